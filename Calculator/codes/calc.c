@@ -0,0 +1,257 @@
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include "calc.h"
+
+// ---------------- Stack Implementation ----------------
+static void pushValue(CalcFrame *f, double val) {
+    if (f->valueTop < MAX_STACK - 1) f->valueStack[++f->valueTop] = val;
+    else f->overflow = 1;
+}
+static double popValue(CalcFrame *f) {
+    if (f->valueTop >= 0) return f->valueStack[f->valueTop--];
+    f->underflow = 1;
+    return NAN;
+}
+
+static void pushOperator(CalcFrame *f, char op) {
+    if (f->operatorTop < MAX_STACK - 1) f->operatorStack[++f->operatorTop] = op;
+    else f->overflow = 1;
+}
+static char popOperator(CalcFrame *f) {
+    return (f->operatorTop >= 0) ? f->operatorStack[f->operatorTop--] : '\0';
+}
+
+static double applyOperator(double a, double b, char op) {
+    switch (op) {
+        case '+': return a + b;
+        case '-': return a - b;
+        case '*': return a * b;
+        case '/': return (b != 0) ? (a / b) : NAN;
+        case '^': return pow(a, b);
+        default: return 0;
+    }
+}
+
+// 'n' is unary minus, which binds tighter than * and / but not ^ (-2^2 is -4)
+static int precedence(char op) {
+    if (op == '+' || op == '-') return 1;
+    if (op == '*' || op == '/') return 2;
+    if (op == 'n') return 3;
+    if (op == '^') return 4;
+    return 0;
+}
+
+// Pops one operator and its operands and pushes the result
+static void reduce(CalcFrame *f) {
+    char op = popOperator(f);
+    if (op == 'n') {
+        pushValue(f, -popValue(f));
+        return;
+    }
+    double b = popValue(f);
+    double a = popValue(f);
+    pushValue(f, applyOperator(a, b, op));
+}
+
+// ---------------- CORDIC Setup ----------------
+#define ITERATIONS 16
+#define SCALE_OUT 32768.0
+#define ANGLE_SCALE 16384.0
+#define CORDIC_K (0.607252935 * SCALE_OUT)
+
+static const int16_t atan_table[ITERATIONS] = {
+    8192, 4828, 2552, 1296, 650, 325, 163, 81,
+    40, 20, 10, 5, 2, 1, 0, 0
+};
+
+void cordic(int16_t theta, int16_t *sin_out, int16_t *cos_out) {
+    int32_t x = CORDIC_K, y = 0, z = theta;
+    for (int i = 0; i < ITERATIONS; i++) {
+        int32_t x_new, y_new;
+        if (z >= 0) {
+            x_new = x - (y >> i);
+            y_new = y + (x >> i);
+            z -= atan_table[i];
+        } else {
+            x_new = x + (y >> i);
+            y_new = y - (x >> i);
+            z += atan_table[i];
+        }
+        x = x_new;
+        y = y_new;
+    }
+    // The gain can carry +-1 just past the Q15 range (cos(0) comes out at 32768), which the firmware
+    // wraps around to the opposite sign
+    if (x > INT16_MAX) x = INT16_MAX;
+    if (x < -INT16_MAX) x = -INT16_MAX;
+    if (y > INT16_MAX) y = INT16_MAX;
+    if (y < -INT16_MAX) y = -INT16_MAX;
+    *cos_out = (int16_t)x;
+    *sin_out = (int16_t)y;
+}
+
+// CORDIC only converges for |theta| up to about pi/2, so the angle (radians) is first brought into
+// [-pi, pi] and then folded into [-pi/2, pi/2] with sin(pi-a)=sin(a), cos(pi-a)=-cos(a)
+static void cordicRadians(double angle, double *sinVal, double *cosVal) {
+    double a = remainder(angle, 2 * M_PI), sign = 1;
+    if (a > M_PI_2) {
+        a = M_PI - a;
+        sign = -1;
+    } else if (a < -M_PI_2) {
+        a = -M_PI - a;
+        sign = -1;
+    }
+    int16_t s, c;
+    cordic((int16_t)lrint(a * ANGLE_SCALE / M_PI_2), &s, &c);
+    *sinVal = s / SCALE_OUT;
+    *cosVal = sign * c / SCALE_OUT;
+}
+
+// ---------------- Math Functions ----------------
+static double factorial(int n) {
+    if (n < 0) return NAN;
+    if (n > 170) return INFINITY;  // beyond the double range
+    double fact = 1;
+    for (int i = 1; i <= n; i++) fact *= i;
+    return fact;
+}
+
+// Trigonometric functions go through CORDIC as on the calculator, the others through libm
+// (the firmware's fixed step RK4 approximations are only good near 1); NAN for an unknown name
+static double applyFunction(const char *name, int len, double param) {
+    double s, c;
+#define IS(str) (len == (int)sizeof(str) - 1 && memcmp(name, str, len) == 0)
+    if (IS("sin") || IS("cos") || IS("tan")) {
+        if (!isfinite(param)) return NAN;
+        cordicRadians(param, &s, &c);
+        if (IS("sin")) return s;
+        if (IS("cos")) return c;
+        return (c != 0) ? s / c : NAN;
+    }
+    if (IS("ln")) return log(param);
+    if (IS("log")) return log10(param);
+    if (IS("sqrt")) return sqrt(param);
+    if (IS("cbrt")) return cbrt(param);
+    if (IS("asin") || IS("sininv")) return asin(param);
+    if (IS("acos") || IS("cosinv")) return acos(param);
+    if (IS("atan") || IS("taninv")) return atan(param);
+#undef IS
+    return NAN;
+}
+
+// ---------------- Expression Evaluation ----------------
+// Evaluates expr[*pos..len) in frame depth up to the end or the first unmatched ')', which closes the
+// argument of the function one level up and is consumed; sets *bad on anything it cannot parse
+static double evaluate(CalcState *s, int depth, const char *expr, int len, int *pos, int *bad) {
+    CalcFrame *f = &s->frame[depth];
+    f->valueTop = -1;
+    f->operatorTop = -1;
+    f->overflow = 0;
+    f->underflow = 0;
+
+    int i = *pos;
+    int operand = 1;  // an operand comes next: at the start, after '(' and after an operator
+    while (i < len && !*bad) {
+        char ch = expr[i];
+        if (ch == ' ' || ch == '\t' || ch == '\r') {
+            i++;
+        } else if ((ch >= '0' && ch <= '9') || ch == '.') {
+            char numStr[32];
+            int j = 0, dots = 0;
+            while (i < len && ((expr[i] >= '0' && expr[i] <= '9') || expr[i] == '.')) {
+                dots += expr[i] == '.';
+                if (j == (int)sizeof(numStr) - 1) break;
+                numStr[j++] = expr[i++];
+            }
+            numStr[j] = '\0';
+            // At most one point and at least one digit, and no number straight after an operand
+            if (!operand || dots > 1 || j == dots || j == (int)sizeof(numStr) - 1) {
+                *bad = 1;
+                break;
+            }
+            pushValue(f, strtod(numStr, NULL));
+            operand = 0;
+        } else if (ch == '(') {
+            if (!operand) {  // no implicit multiplication, 2(3)
+                *bad = 1;
+                break;
+            }
+            pushOperator(f, ch);
+            i++;
+        } else if (ch == ')') {
+            i++;
+            if (operand) {  // (), sin() or 2+)
+                *bad = 1;
+                break;
+            }
+            int open = 0;
+            for (int k = 0; k <= f->operatorTop; k++) open |= f->operatorStack[k] == '(';
+            if (!open) {  // end of a function argument
+                if (depth == 0) *bad = 1;
+                break;
+            }
+            while (f->operatorStack[f->operatorTop] != '(') reduce(f);
+            popOperator(f);
+        } else if (isalpha((unsigned char)ch)) {  // Detect function names and Pi
+            const char *name = expr + i;
+            int n = 0;
+            while (i < len && isalpha((unsigned char)expr[i])) {
+                i++;
+                n++;
+            }
+            if (!operand) {
+                *bad = 1;
+            } else if (n == 2 && name[0] == 'P' && name[1] == 'i') {
+                pushValue(f, M_PI);
+            } else if (i < len && expr[i] == '(' && depth + 1 < MAX_NESTING) {
+                i++;
+                double param = evaluate(s, depth + 1, expr, len, &i, bad);
+                pushValue(f, applyFunction(name, n, param));
+            } else {
+                *bad = 1;
+            }
+            operand = 0;
+        } else if (ch == '!') {  // postfix factorial of a whole number
+            double v = operand ? NAN : popValue(f);
+            if (v != floor(v)) {  // also NAN and nothing to apply it to
+                *bad = 1;
+                break;
+            }
+            pushValue(f, factorial(v > 171 ? 171 : v < -1 ? -1 : (int)v));  // clamped before the conversion
+            i++;
+        } else if (operand && (ch == '-' || ch == '+')) {  // unary sign, + changes nothing
+            if (ch == '-') pushOperator(f, 'n');
+            i++;
+        } else if (precedence(ch) > 0 && !operand) {
+            // ^ is right associative, so 2^3^2 is 2^9 as in lib/expr.c
+            while (f->operatorTop >= 0 && (precedence(f->operatorStack[f->operatorTop]) > precedence(ch) ||
+                   (precedence(f->operatorStack[f->operatorTop]) == precedence(ch) && ch != '^'))) {
+                reduce(f);
+            }
+            pushOperator(f, ch);
+            operand = 1;
+            i++;
+        } else {
+            *bad = 1;
+        }
+    }
+    if (operand) *bad = 1;  // nothing to evaluate, or an operator missing its right operand
+
+    // Parentheses still open are closed at the end
+    while (f->operatorTop >= 0) {
+        if (f->operatorStack[f->operatorTop] == '(') popOperator(f);
+        else reduce(f);
+    }
+    double result = popValue(f);
+    if (f->overflow || f->underflow || f->valueTop >= 0) *bad = 1;  // a missing operand or one left over
+    *pos = i;
+    return result;
+}
+
+double evaluateExpression(CalcState *s, const char *expr, int len) {
+    int pos = 0, bad = 0;
+    double result = evaluate(s, 0, expr, len, &pos, &bad);
+    return (bad || pos < len) ? NAN : result;
+}
@@ -0,0 +1,31 @@
+#ifndef CALC_H
+#define CALC_H
+#include <stdint.h>
+
+// Host build of the evaluator in calculator.c (evaluateExpression, applyOperator, precedence, cordic)
+// The value and operator stacks live in a CalcState instead of globals, so every thread can own one
+// and evaluate without locks; nothing is allocated
+
+#define MAX_STACK 20       // same depth as the firmware
+#define MAX_NESTING 8      // function calls inside function arguments
+
+typedef struct {
+    double valueStack[MAX_STACK];
+    char operatorStack[MAX_STACK];
+    int valueTop, operatorTop;
+    int overflow;          // a push found its stack full
+    int underflow;         // a pop found its stack empty (a missing operand)
+} CalcFrame;
+
+typedef struct {
+    CalcFrame frame[MAX_NESTING];   // one per level of function arguments
+} CalcState;
+
+// Evaluates the len characters at expr (no terminator needed), NAN if they do not parse,
+// nest deeper than MAX_NESTING or overflow a stack
+double evaluateExpression(CalcState *s, const char *expr, int len);
+
+// The firmware's fixed point CORDIC: theta in units of ANGLE_SCALE per pi/2, outputs in Q15
+void cordic(int16_t theta, int16_t *sin_out, int16_t *cos_out);
+
+#endif
@@ -0,0 +1,412 @@
+// Batch evaluation service for the calculator's expressions on Linux (evaluator in calc.c)
+// Reads newline separated expressions and answers each with one line holding its value (nan if it
+// does not parse), using a pool of threads that each own a CalcState
+//
+//   calcd [-t threads] [-l lines per batch]             stdin to stdout, answers in input order
+//   calcd [-t threads] [-l lines per batch] -s path     Unix socket server, any number of clients
+//
+// stdin mode: the main thread cuts the input into batches of whole lines, the pool evaluates them
+// and a writer thread sends each batch back with one write() in input order
+// socket mode: every thread accepts and serves its own connections, answering everything that came
+// in with one read() by one write(); SIGINT or SIGTERM stops accepting and drains open connections
+// Buffers are sized at startup, so the evaluation path does not allocate
+// When done, one JSON line goes to stderr with the throughput and the percentiles of the evaluation
+// time per expression (and of the batch turnaround in stdin mode)
+//
+// gcc -O2 -Wall -o calcd calcd.c calc.c -lm -lpthread
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "calc.h"
+
+#define MAX_THREADS 64
+#define READ_BYTES (1 << 16)   // one read() of input
+#define BATCH_BYTES (1 << 18)  // input held by one batch
+#define MAX_LINE 1024          // longer lines are answered with nan
+#define RESULT_BYTES 32        // room for one formatted result and its newline
+
+// ---------------- Latency Histogram ----------------
+// Log2 buckets split into 8 linear sub-buckets, so a percentile is within 12.5% of the true value
+#define SUB_BUCKETS 8
+#define BUCKETS (64 * SUB_BUCKETS)
+
+typedef struct {
+    uint64_t count[BUCKETS];
+    uint64_t max;
+} Histogram;
+
+static int bucketOf(uint64_t v) {
+    if (v < SUB_BUCKETS) return (int)v;
+    int e = 63 - __builtin_clzll(v);
+    return (e - 2) * SUB_BUCKETS + (int)((v >> (e - 3)) & (SUB_BUCKETS - 1));
+}
+
+// Largest value that falls in bucket b
+static uint64_t bucketTop(int b) {
+    if (b < SUB_BUCKETS) return (uint64_t)b;
+    int e = b / SUB_BUCKETS + 2;
+    return ((uint64_t)(SUB_BUCKETS + b % SUB_BUCKETS + 1) << (e - 3)) - 1;
+}
+
+static void record(Histogram *h, uint64_t v) {
+    h->count[bucketOf(v)]++;
+    if (v > h->max) h->max = v;
+}
+
+static void merge(Histogram *into, const Histogram *h) {
+    for (int b = 0; b < BUCKETS; b++) into->count[b] += h->count[b];
+    if (h->max > into->max) into->max = h->max;
+}
+
+static uint64_t percentile(const Histogram *h, double p) {
+    uint64_t total = 0, seen = 0;
+    for (int b = 0; b < BUCKETS; b++) total += h->count[b];
+    if (total == 0) return 0;
+    uint64_t rank = (uint64_t)(p * total);
+    if (rank >= total) rank = total - 1;
+    for (int b = 0; b < BUCKETS; b++) {
+        seen += h->count[b];
+        if (seen > rank) return bucketTop(b) < h->max ? bucketTop(b) : h->max;
+    }
+    return h->max;
+}
+
+static void printPercentiles(FILE *out, const char *name, const Histogram *h, double unit) {
+    fprintf(out, "\"%s\": {\"p50\": %.4g, \"p90\": %.4g, \"p99\": %.4g, \"p999\": %.4g, \"max\": %.4g}", name,
+            percentile(h, 0.5) / unit, percentile(h, 0.9) / unit, percentile(h, 0.99) / unit,
+            percentile(h, 0.999) / unit, h->max / unit);
+}
+
+static uint64_t nowNs(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000u + (uint64_t)t.tv_nsec;
+}
+
+// ---------------- Workers ----------------
+typedef struct {
+    CalcState state;
+    Histogram evalNs;
+    long expressions;
+    char *in, *out;    // socket mode buffers
+    pthread_t tid;
+} Worker;
+
+// Evaluates one line (without its newline) and appends the answer at out, returns the bytes written
+static int answer(Worker *w, const char *line, int len, char *out) {
+    uint64_t t0 = nowNs();
+    double result = (len <= MAX_LINE) ? evaluateExpression(&w->state, line, len) : NAN;
+    record(&w->evalNs, nowNs() - t0);
+    w->expressions++;
+    return snprintf(out, RESULT_BYTES, "%.15g\n", result);
+}
+
+static int writeAll(int fd, const char *buf, long len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static int nthreads = 1, batchLines = 4096;
+static Worker workers[MAX_THREADS];
+
+// ---------------- stdin Mode ----------------
+// A ring of batches passes from the reader (filled), to the pool (evaluated), to the writer (written)
+typedef struct {
+    char *in, *out;
+    int inLen, outLen, lines;
+    int evaluated;
+    uint64_t filledNs;
+} Batch;
+
+static Batch *ring;
+static int nslots;
+static long nextFill, nextEval, nextWrite;
+static int inputDone;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t changed = PTHREAD_COND_INITIALIZER;
+static Histogram batchUs;
+
+static void *evaluateBatches(void *arg) {
+    Worker *w = (Worker *)arg;
+    pthread_mutex_lock(&lock);
+    for (;;) {
+        while (nextEval == nextFill && !inputDone) pthread_cond_wait(&changed, &lock);
+        if (nextEval == nextFill) break;
+        Batch *b = &ring[nextEval++ % nslots];
+        pthread_mutex_unlock(&lock);
+        b->outLen = 0;
+        for (int i = 0; i < b->inLen;) {
+            int j = i;
+            while (b->in[j] != '\n') j++;
+            b->outLen += answer(w, b->in + i, j - i, b->out + b->outLen);
+            i = j + 1;
+        }
+        pthread_mutex_lock(&lock);
+        b->evaluated = 1;
+        pthread_cond_broadcast(&changed);
+    }
+    pthread_mutex_unlock(&lock);
+    return NULL;
+}
+
+static void *writeBatches(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&lock);
+    for (;;) {
+        while (!(nextWrite < nextFill && ring[nextWrite % nslots].evaluated) && !(inputDone && nextWrite == nextFill)) {
+            pthread_cond_wait(&changed, &lock);
+        }
+        if (nextWrite == nextFill) break;
+        Batch *b = &ring[nextWrite % nslots];
+        pthread_mutex_unlock(&lock);
+        if (writeAll(1, b->out, b->outLen) != 0) {
+            perror("calcd: write");
+            exit(1);
+        }
+        record(&batchUs, (nowNs() - b->filledNs) / 1000);
+        pthread_mutex_lock(&lock);
+        b->evaluated = 0;
+        nextWrite++;
+        pthread_cond_broadcast(&changed);
+    }
+    pthread_mutex_unlock(&lock);
+    return NULL;
+}
+
+// Waits for a free slot and returns it empty
+static Batch *takeSlot(void) {
+    pthread_mutex_lock(&lock);
+    while (nextFill - nextWrite >= nslots) pthread_cond_wait(&changed, &lock);
+    Batch *b = &ring[nextFill % nslots];
+    pthread_mutex_unlock(&lock);
+    b->inLen = 0;
+    b->lines = 0;
+    return b;
+}
+
+static void submit(Batch *b) {
+    b->filledNs = nowNs();
+    pthread_mutex_lock(&lock);
+    nextFill++;
+    pthread_cond_broadcast(&changed);
+    pthread_mutex_unlock(&lock);
+}
+
+// Appends one line to the batch being filled, handing the batch over when it is full
+static Batch *addLine(Batch *b, const char *line, int len) {
+    if (len > MAX_LINE) {
+        line = "?";    // does not parse, so it is answered with nan
+        len = 1;
+    }
+    if (b->lines == batchLines || b->inLen + len + 1 > BATCH_BYTES) {
+        submit(b);
+        b = takeSlot();
+    }
+    memcpy(b->in + b->inLen, line, len);
+    b->in[b->inLen + len] = '\n';
+    b->inLen += len + 1;
+    b->lines++;
+    return b;
+}
+
+static void serveStdin(void) {
+    static char chunk[READ_BYTES];
+    nslots = 2 * nthreads + 2;
+    ring = (Batch *)calloc(nslots, sizeof(Batch));
+    for (int i = 0; i < nslots; i++) {
+        ring[i].in = (char *)malloc(BATCH_BYTES);
+        ring[i].out = (char *)malloc((size_t)batchLines * RESULT_BYTES);
+        if (!ring[i].in || !ring[i].out) {
+            fprintf(stderr, "calcd: out of memory\n");
+            exit(1);
+        }
+    }
+    pthread_t writer;
+    pthread_create(&writer, NULL, writeBatches, NULL);
+    for (int t = 0; t < nthreads; t++) pthread_create(&workers[t].tid, NULL, evaluateBatches, &workers[t]);
+
+    Batch *b = takeSlot();
+    int have = 0, skipping = 0;    // skipping the rest of a line longer than the chunk
+    for (;;) {
+        ssize_t n = read(0, chunk + have, READ_BYTES - have);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        have += (int)n;
+        int start = 0;
+        for (int i = 0; i < have; i++) {
+            if (chunk[i] != '\n') continue;
+            if (skipping) {
+                b = addLine(b, "?", 1);
+                skipping = 0;
+            } else {
+                b = addLine(b, chunk + start, i - start);
+            }
+            start = i + 1;
+        }
+        if (start == 0 && have == READ_BYTES) {
+            skipping = 1;
+            have = 0;
+        } else {
+            memmove(chunk, chunk + start, have - start);
+            have -= start;
+        }
+    }
+    if (have > 0 || skipping) b = addLine(b, skipping ? "?" : chunk, skipping ? 1 : have);  // last line without '\n'
+    if (b->lines > 0) submit(b);
+
+    pthread_mutex_lock(&lock);
+    inputDone = 1;
+    pthread_cond_broadcast(&changed);
+    pthread_mutex_unlock(&lock);
+    for (int t = 0; t < nthreads; t++) pthread_join(workers[t].tid, NULL);
+    pthread_join(writer, NULL);
+}
+
+// ---------------- Socket Mode ----------------
+static int listenFd = -1;
+static volatile sig_atomic_t stopping;
+
+static void stop(int sig) {
+    (void)sig;
+    stopping = 1;
+    shutdown(listenFd, SHUT_RDWR);    // wakes every accept()
+}
+
+static void serveConnection(Worker *w, int fd) {
+    int have = 0, skipping = 0;
+    for (;;) {
+        ssize_t n = read(fd, w->in + have, READ_BYTES - have);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        have += (int)n;
+        int start = 0, outLen = 0;
+        for (int i = 0; i < have; i++) {
+            if (w->in[i] != '\n') continue;
+            if (outLen + RESULT_BYTES > batchLines * RESULT_BYTES) {
+                if (writeAll(fd, w->out, outLen) != 0) return;
+                outLen = 0;
+            }
+            outLen += answer(w, skipping ? "?" : w->in + start, skipping ? 1 : i - start, w->out + outLen);
+            skipping = 0;
+            start = i + 1;
+        }
+        if (outLen > 0 && writeAll(fd, w->out, outLen) != 0) return;
+        if (start == 0 && have == READ_BYTES) {
+            skipping = 1;
+            have = 0;
+        } else {
+            memmove(w->in, w->in + start, have - start);
+            have -= start;
+        }
+    }
+    if (have > 0 || skipping) {
+        int outLen = answer(w, skipping ? "?" : w->in, skipping ? 1 : have, w->out);
+        writeAll(fd, w->out, outLen);
+    }
+}
+
+static void *acceptConnections(void *arg) {
+    Worker *w = (Worker *)arg;
+    while (!stopping) {
+        int fd = accept(listenFd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            break;
+        }
+        serveConnection(w, fd);
+        close(fd);
+    }
+    return NULL;
+}
+
+static void serveSocket(const char *path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "calcd: socket path too long\n");
+        exit(1);
+    }
+    strcpy(addr.sun_path, path);
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(path);
+    if (listenFd < 0 || bind(listenFd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(listenFd, 128) != 0) {
+        perror("calcd: socket");
+        exit(1);
+    }
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = stop;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    for (int t = 0; t < nthreads; t++) {
+        workers[t].in = (char *)malloc(READ_BYTES);
+        workers[t].out = (char *)malloc((size_t)batchLines * RESULT_BYTES);
+        if (!workers[t].in || !workers[t].out) {
+            fprintf(stderr, "calcd: out of memory\n");
+            exit(1);
+        }
+        pthread_create(&workers[t].tid, NULL, acceptConnections, &workers[t]);
+    }
+    for (int t = 0; t < nthreads; t++) pthread_join(workers[t].tid, NULL);
+    close(listenFd);
+    unlink(path);
+}
+
+// ---------------- Main ----------------
+int main(int argc, char **argv) {
+    const char *path = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "t:l:s:")) != -1) {
+        if (opt == 't') nthreads = atoi(optarg);
+        else if (opt == 'l') batchLines = atoi(optarg);
+        else if (opt == 's') path = optarg;
+        else {
+            fprintf(stderr, "usage: calcd [-t threads] [-l lines per batch] [-s socket path]\n");
+            return 2;
+        }
+    }
+    if (nthreads < 1) nthreads = 1;
+    if (nthreads > MAX_THREADS) nthreads = MAX_THREADS;
+    if (batchLines < 1) batchLines = 1;
+    signal(SIGPIPE, SIG_IGN);    // a client that goes away only ends its own connection
+
+    uint64_t t0 = nowNs();
+    if (path) serveSocket(path);
+    else serveStdin();
+    double seconds = (nowNs() - t0) * 1e-9;
+
+    Histogram evalNs;
+    long expressions = 0;
+    memset(&evalNs, 0, sizeof(evalNs));
+    for (int t = 0; t < nthreads; t++) {
+        merge(&evalNs, &workers[t].evalNs);
+        expressions += workers[t].expressions;
+    }
+    fprintf(stderr, "{\"mode\": \"%s\", \"threads\": %d, \"expressions\": %ld, \"seconds\": %.6g, \"per_second\": %.6g, ",
+            path ? "socket" : "stdin", nthreads, expressions, seconds, expressions / seconds);
+    printPercentiles(stderr, "eval_ns", &evalNs, 1);
+    if (!path) {
+        fprintf(stderr, ", ");
+        printPercentiles(stderr, "batch_us", &batchUs, 1);
+    }
+    fprintf(stderr, "}\n");
+    return 0;
+}
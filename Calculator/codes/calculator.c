@@ -1,6 +1,10 @@
 #include <avr/io.h> 
 #include <util/delay.h> 
 #include <stdlib.h> 
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdbool.h>
 #include <math.h>
 
 // ---------------- TYPEDEFS ----------------
@@ -75,6 +79,19 @@ void LCD_Integer(int data) {
     LCD_Message(st);
 }
 
+// Helpers used by handleKeyPress
+void lcd_clear() {
+    LCD_Clear();
+}
+
+void lcd_print(const char *text) {
+    LCD_Message(text);
+}
+
+void lcd_set_cursor(byte col, byte row) {
+    LCD_Cmd(0x80 | (row ? 0x40 : 0x00) | col);  // Set DDRAM address, line 2 starts at 0x40
+}
+
 // ---------------- Button Matrix Setup ----------------
 #define ROWS 4
 #define COLS 5
@@ -97,7 +114,8 @@ char shiftKeys[ROWS][COLS] = {
     {'S', 'I', 'T', 'Q', 'B'}
 };
 
-String input = "";
+char input[32] = "";
+size_t input_len = 0;
 
 // ---------------- Stack Implementation ----------------
 #define MAX_STACK 20
@@ -191,7 +209,9 @@ double rk4_ln(double x0, double x) {
     return y;
 }
 
-double rk4_sqrt(double x, double h = 0.01, int steps = 100) {
+double rk4_sqrt(double x) {
+    double h = 0.01;
+    int steps = 100;
     double y = 1;
     double xn = x;
 
@@ -206,7 +226,9 @@ double rk4_sqrt(double x, double h = 0.01, int steps = 100) {
     return y;
 }
 
-double rk4_asin(double x, double h = 0.01, int steps = 100) {
+double rk4_asin(double x) {
+    double h = 0.01;
+    int steps = 100;
     double y = 0;
     double xn = 0;
 
@@ -226,7 +248,9 @@ double rk4_acos(double x) {
     return M_PI / 2 - rk4_asin(x);
 }
 
-double rk4_atan(double x, double h = 0.01, int steps = 100) {
+double rk4_atan(double x) {
+    double h = 0.01;
+    int steps = 100;
     double y = 0;
     double xn = 0;
 
@@ -252,7 +276,8 @@ double evaluateExpression(char* expr) {
             char numStr[10] = "";
             int j = 0;
             while ((expr[i] >= '0' && expr[i] <= '9') || expr[i] == '.') {
-                numStr[j++] = expr[i++];
+                if (j < (int)sizeof(numStr) - 1) numStr[j++] = expr[i];  // longer numbers are cut short
+                i++;
             }
             numStr[j] = '\0';
             pushValue(atof(numStr));
@@ -271,13 +296,14 @@ double evaluateExpression(char* expr) {
             char funcName[10] = "";
             int j = 0;
             while (isalpha(expr[i])) {
-                funcName[j++] = expr[i++];
+                if (j < (int)sizeof(funcName) - 1) funcName[j++] = expr[i];
+                i++;
             }
             funcName[j] = '\0';
             if (expr[i] == '(') {
                 i++;
                 double param = evaluateExpression(expr + i);
-                while (expr[i] != ')') i++;
+                while (expr[i] != ')' && expr[i] != '\0') i++;  // an unclosed argument runs to the end
                 if (strcmp(funcName, "sin") == 0) {
                     int16_t sinVal, cosVal;
                     cordic(param * ANGLE_SCALE / M_PI_2, &sinVal, &cosVal);
@@ -311,6 +337,7 @@ double evaluateExpression(char* expr) {
             }
             pushOperator(expr[i]);
         }
+        if (expr[i] == '\0') break;
         i++;
     }
 
@@ -326,6 +353,46 @@ double evaluateExpression(char* expr) {
 
 
 // ---------------- Key Press Handling ----------------
+// Called with every key the scan in loop() accepts, before it is handled (a hook for host builds)
+#ifndef KEY_EVENT
+#define KEY_EVENT(key)
+#endif
+
+// Called with a key whose text no longer fits in input, which then ignores it
+#ifndef KEY_REJECTED
+#define KEY_REJECTED(key)
+#endif
+
+// Text a key adds to the input, NULL for keys that add their own character
+const char *keyToken(char key) {
+    switch (key) {
+        case 's': return "sin(";
+        case 'c': return "cos(";
+        case 't': return "tan(";
+        case 'l': return "log(";
+        case 'L': return "ln(";
+        case 'q': return "sqrt(";
+        case 'b': return "cbrt(";  // Cube root (not implemented yet)
+        case 'R': return "R(";
+        case 'S': return "sininv(";
+        case 'I': return "cosinv(";
+        case 'T': return "taninv(";
+        case 'Q': return "^2";  // Square
+        case 'B': return "^3";  // Cube
+        case 'P': return "Pi";
+        default: return NULL;
+    }
+}
+
+// Appends the whole token to input or, if it does not fit, nothing and returns false
+bool appendInput(const char *token) {
+    size_t n = strlen(token);
+    if (n > sizeof(input) - 1 - input_len) return false;
+    memcpy(input + input_len, token, n + 1);
+    input_len += n;
+    return true;
+}
+
 void handleKeyPress(char key) {
     lcd_set_cursor(0, 0);
 
@@ -350,30 +417,9 @@ void handleKeyPress(char key) {
         snprintf(input, sizeof(input), "%s", resultStr);
         input_len = strlen(input);
     } else {
-        if (input_len < sizeof(input) - 1) {
-            if (key == 's') strcat(input, "sin(");
-            else if (key == 'c') strcat(input, "cos(");
-            else if (key == 't') strcat(input, "tan(");
-            else if (key == 'l') strcat(input, "log(");
-            else if (key == 'L') strcat(input, "ln(");
-            else if (key == '!') strcat(input, "!");
-            else if (key == 'q') strcat(input, "sqrt(");
-            else if (key == 'b') strcat(input, "cbrt(");  // Cube root (not implemented yet)
-            else if (key == 'N') strcat(input, "N");
-            else if (key == 'E') strcat(input, "E");
-            else if (key == 'R') strcat(input, "R(");
-            else if (key == 'S') strcat(input, "sininv(");
-            else if (key == 'I') strcat(input, "cosinv(");
-            else if (key == 'T') strcat(input, "taninv(");
-            else if (key == '|') strcat(input, "|");
-            else if (key == 'Q') strcat(input, "^2");  // Square
-            else if (key == 'B') strcat(input, "^3");  // Cube
-            else if (key == 'P') strcat(input, "Pi");
-            else {
-                input[input_len++] = key;
-                input[input_len] = '\0';
-            }
-        }
+        char single[2] = {key, '\0'};
+        const char *token = keyToken(key);
+        if (!appendInput(token ? token : single)) KEY_REJECTED(key);
     }
 
     lcd_clear();
@@ -418,6 +464,7 @@ void loop() {
             if (!(PINC & (1 << (j + 4)))) {
                 _delay_ms(50);
                 char key = shiftMode ? shiftKeys[i][j] : normalKeys[i][j];
+                KEY_EVENT(key);
                 handleKeyPress(key);
                 while (!(PINC & (1 << (j + 4))));
                 _delay_ms(50);
@@ -0,0 +1,28 @@
+#ifndef HOST_AVR_IO_H
+#define HOST_AVR_IO_H
+#include <stdint.h>
+
+// Host stand-in for <avr/io.h> used by keyreplay.c: every I/O register access goes through
+// hostRegister(), which lets the virtual keypad drive the PIN registers and the virtual LCD
+// watch PORTB, and charges one simulated cycle (an IN or OUT instruction)
+enum { HOST_PORTB, HOST_DDRB, HOST_PINB, HOST_PORTC, HOST_DDRC, HOST_PINC,
+       HOST_PORTD, HOST_DDRD, HOST_PIND, HOST_REGISTERS };
+
+volatile uint8_t *hostRegister(int reg);
+
+#define PORTB (*hostRegister(HOST_PORTB))
+#define DDRB (*hostRegister(HOST_DDRB))
+#define PINB (*hostRegister(HOST_PINB))
+#define PORTC (*hostRegister(HOST_PORTC))
+#define DDRC (*hostRegister(HOST_DDRC))
+#define PINC (*hostRegister(HOST_PINC))
+#define PORTD (*hostRegister(HOST_PORTD))
+#define DDRD (*hostRegister(HOST_DDRD))
+#define PIND (*hostRegister(HOST_PIND))
+
+#define _BV(bit) (1 << (bit))
+
+// avr-libc's <stdlib.h> extras used by the firmware
+char *itoa(int value, char *str, int base);
+char *dtostrf(double value, signed char width, unsigned char prec, char *str);
+#endif
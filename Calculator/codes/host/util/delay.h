@@ -0,0 +1,7 @@
+#ifndef HOST_UTIL_DELAY_H
+#define HOST_UTIL_DELAY_H
+
+// Host stand-in for <util/delay.h>: busy waits advance the simulated clock by F_CPU cycles per second
+void _delay_us(double us);
+void _delay_ms(double ms);
+#endif
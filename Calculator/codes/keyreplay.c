@@ -0,0 +1,356 @@
+// Host replay harness for the calculator firmware: calculator.c is compiled as it is on top of the
+// stand-in <avr/io.h> and <util/delay.h> in host/, a virtual keypad matrix and shift button drive
+// the PIN registers from a script of keystrokes, a virtual HD44780 decodes the 4-bit stream on PORTB,
+// and the firmware's own setup() and loop() do the rest
+//
+//   keyreplay [-d] [script]     one sequence of keys per line (stdin without a script), e.g. 12+3=
+//
+// Keys are the characters of normalKeys and shiftKeys; the shift button is pressed whenever the
+// next key is on the other layer. For every key it reports whether the scan delivered it, the LCD
+// bytes its handling sent, the simulated cycles from the press to the last of those bytes and the
+// display afterwards, then the dropped keys and why (a key the firmware had no room for counts as dropped)
+// -d skips the keypad and calls handleKeyPress() directly, to time the UI path on its own
+// A loop() that runs longer than WATCHDOG_MS is cut off and the firmware set up again, as the AVR
+// watchdog would, and the register it was polling is reported
+// Simulated time is the firmware's busy waits at F_CPU plus one cycle per I/O register access,
+// the arithmetic in between is not modelled
+//
+// gcc -O2 -Wall -DF_CPU=16000000UL -Ihost -o keyreplay keyreplay.c -lm
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <avr/io.h>
+
+#define MS(ms) ((uint64_t)((ms) * (F_CPU / 1000)))
+#define HOLD_MS 120        // how long a key is held down
+#define GAP_MS 120         // pause before the next key
+#define WATCHDOG_MS 1000   // longest loop() allowed
+
+static uint64_t cycles;    // simulated clock
+static uint8_t reg[HOST_REGISTERS];
+static const char *regName[HOST_REGISTERS] = {"PORTB", "DDRB", "PINB", "PORTC", "DDRC", "PINC", "PORTD", "DDRD", "PIND"};
+
+// ---------------- Watchdog ----------------
+static jmp_buf watchdog;
+static uint64_t watchdogAt;
+static int watchdogArmed, stuckOn = -1;
+static long resets;
+
+static void checkWatchdog(int r) {
+    if (watchdogArmed && cycles > watchdogAt) {
+        watchdogArmed = 0;
+        stuckOn = r;
+        longjmp(watchdog, 1);
+    }
+}
+
+// ---------------- Virtual HD44780 ----------------
+// Latches a nibble on every falling edge of E; starts in 8-bit mode, where each nibble is a whole
+// instruction, until a function set with DL=0 (0x2x) switches it to pairs of nibbles
+#define LCD_RS_BIT 0
+#define LCD_E_BIT 1
+
+static char ddram[128];
+static int lcdAddress, lcd4bit, lcdHalf, lcdHigh;
+static int lastE;
+static uint8_t latched;    // PORTB while E was high
+static long lcdBytes;      // bytes (instructions and characters) received so far
+static uint64_t lastByteAt;
+
+static void noteByte(void);
+
+static void lcdByte(int rs, uint8_t b) {
+    lcdBytes++;
+    lastByteAt = cycles;
+    noteByte();
+    if (rs) {
+        ddram[lcdAddress] = (char)b;
+        lcdAddress = (lcdAddress + 1) & 0x7F;
+    } else if (b == 0x01) {
+        memset(ddram, ' ', sizeof(ddram));
+        lcdAddress = 0;
+    } else if ((b & 0xFE) == 0x02) {
+        lcdAddress = 0;
+    } else if (b & 0x80) {
+        lcdAddress = b & 0x7F;
+    }
+}
+
+static void lcdNibble(int rs, int n) {
+    if (!lcd4bit) {
+        lcdByte(rs, (uint8_t)(n << 4));
+        if (!rs && n == 0x2) lcd4bit = 1;
+    } else if (!lcdHalf) {
+        lcdHigh = n;
+        lcdHalf = 1;
+    } else {
+        lcdByte(rs, (uint8_t)(lcdHigh << 4 | n));
+        lcdHalf = 0;
+    }
+}
+
+// Looks at PORTB as the last access left it
+static void watchLcd(void) {
+    uint8_t b = reg[HOST_PORTB];
+    int e = (b >> LCD_E_BIT) & 1;
+    if (e) latched = b;
+    else if (lastE) lcdNibble(latched & (1 << LCD_RS_BIT), (latched >> 2) & 0x0F);  // DAT4..DAT7 on PB2..PB5
+    lastE = e;
+}
+
+static void display(char *out) {
+    memcpy(out, ddram, 16);
+    out[16] = '|';
+    memcpy(out + 17, ddram + 0x40, 16);
+    out[33] = '\0';
+    for (int i = 0; i < 33; i++) if ((unsigned char)out[i] < ' ') out[i] = '?';
+}
+
+// ---------------- Virtual Keypad ----------------
+// Key (r, c) joins the row line on PC r to the column line on PC c+4 when pressed; column 5 would
+// need PC8, which an 8-bit port does not have. The shift button is wired to Arduino pin 13 but
+// the firmware reads bit 13 of PIND, which does not exist either, so no register ever shows it
+static int heldRow = -1, heldCol = -1, shiftHeld;
+static uint64_t releaseAt;
+
+// Outputs read back what they drive and inputs their pull-up (a set PORT bit), unless a key pulls
+// a column low
+static uint8_t readPinc(void) {
+    uint8_t v = reg[HOST_PORTC];
+    uint8_t dir = reg[HOST_DDRC];
+    if (heldRow >= 0 && heldCol + 4 < 8) {
+        int rowLow = (dir >> heldRow & 1) && !(reg[HOST_PORTC] >> heldRow & 1);
+        int colInput = !(dir >> (heldCol + 4) & 1);
+        if (rowLow && colInput) v &= (uint8_t)~(1 << (heldCol + 4));
+    }
+    return v;
+}
+
+volatile uint8_t *hostRegister(int r) {
+    cycles++;
+    checkWatchdog(r);
+    if (heldRow >= 0 || shiftHeld) {
+        if (cycles >= releaseAt) heldRow = heldCol = -1, shiftHeld = 0;
+    }
+    if (r == HOST_PORTB) watchLcd();
+    if (r == HOST_PINB) reg[r] = reg[HOST_PORTB];
+    if (r == HOST_PINC) reg[r] = readPinc();
+    if (r == HOST_PIND) reg[r] = reg[HOST_PORTD];
+    return &reg[r];
+}
+
+void _delay_us(double us) {
+    watchLcd();
+    cycles += (uint64_t)(us * (F_CPU / 1000000.0));
+    checkWatchdog(-1);
+}
+
+void _delay_ms(double ms) {
+    watchLcd();
+    cycles += MS(ms);
+    checkWatchdog(-1);
+}
+
+char *itoa(int value, char *str, int base) {
+    (void)base;
+    sprintf(str, "%d", value);
+    return str;
+}
+
+char *dtostrf(double value, signed char width, unsigned char prec, char *str) {
+    sprintf(str, "%*.*f", width, prec, value);
+    return str;
+}
+
+// ---------------- Firmware ----------------
+typedef struct {
+    char key;
+    int shift, row, col;     // layer and matrix position, row -1 if no key has this character
+    int delivered;           // keys the scan handed to handleKeyPress while this one was down
+    int hung;                // the watchdog cut loop() off while this one was down
+    char other;              // a different key delivered instead, 0 if none
+    int full;                // handleKeyPress had no room left in input for its text
+    uint64_t pressAt, doneAt;
+    long bytes;
+    char shown[34];
+} KeyRecord;
+
+static KeyRecord *active;
+static int capturing;      // LCD bytes now belong to the active key
+static long spurious[256]; // keys delivered that were not pressed
+
+static void noteByte(void) {
+    if (!capturing) return;
+    active->bytes++;
+    active->doneAt = cycles;
+}
+
+static void endCapture(void) {
+    if (!capturing) return;
+    display(active->shown);
+    capturing = 0;
+}
+
+static void keyEvent(char key) {
+    endCapture();
+    if (!active || key != active->key) {
+        spurious[(unsigned char)key]++;
+        if (active) active->other = key;
+        return;
+    }
+    active->delivered++;
+    capturing = 1;
+}
+
+static void keyRejected(char key) {
+    if (active && key == active->key) active->full = 1;
+}
+
+#define KEY_EVENT(key) keyEvent(key)
+#define KEY_REJECTED(key) keyRejected(key)
+#include "calculator.c"
+
+// ---------------- Replay ----------------
+static void locate(KeyRecord *k) {
+    k->row = -1;
+    for (int layer = 0; layer < 2 && k->row < 0; layer++) {
+        for (int r = 0; r < ROWS; r++) {
+            for (int c = 0; c < COLS; c++) {
+                if ((layer ? shiftKeys : normalKeys)[r][c] == k->key && k->row < 0) {
+                    k->shift = layer;
+                    k->row = r;
+                    k->col = c;
+                }
+            }
+        }
+    }
+    // C and D sit in the same place on both layers, so they never need the shift button
+    if (k->row >= 0 && normalKeys[k->row][k->col] == shiftKeys[k->row][k->col]) k->shift = -1;
+}
+
+// Runs loop() until the simulated clock reaches the end time, noting the LCD traffic of a delivered key
+static void runUntil(uint64_t end) {
+    while (cycles < end) {
+        if (setjmp(watchdog)) {
+            resets++;
+            if (active) active->hung = 1;
+            endCapture();
+            setup();
+            continue;
+        }
+        watchdogAt = cycles + MS(WATCHDOG_MS);
+        watchdogArmed = 1;
+        loop();
+        watchdogArmed = 0;
+        endCapture();
+    }
+}
+
+static int shiftBelief;    // layer the harness has asked for, the firmware may not agree
+
+static void replayScan(KeyRecord *k) {
+    if (k->row < 0) return;
+    if (k->shift >= 0 && k->shift != shiftBelief) {
+        shiftHeld = 1;
+        releaseAt = cycles + MS(HOLD_MS);
+        runUntil(releaseAt + MS(GAP_MS));
+        shiftBelief = k->shift;
+    }
+    active = k;
+    heldRow = k->row;
+    heldCol = k->col;
+    k->pressAt = cycles;
+    releaseAt = cycles + MS(HOLD_MS);
+    runUntil(releaseAt + MS(GAP_MS));
+    active = NULL;
+}
+
+static void replayDirect(KeyRecord *k) {
+    long before = lcdBytes;
+    active = k;
+    k->pressAt = cycles;
+    k->delivered = 1;
+    handleKeyPress(k->key);
+    active = NULL;
+    k->bytes = lcdBytes - before;
+    k->doneAt = k->bytes ? lastByteAt : cycles;
+    display(k->shown);
+}
+
+static const char *why(const KeyRecord *k) {
+    if (k->full) return "input full, handleKeyPress ignored it";
+    if (k->row < 0) return "not on the keypad";
+    if (k->col + 4 >= 8) return "column read from PINC bit 8, past the port";
+    if (k->shift == 1) return "shift read from PIND bit 13, past the port";
+    if (k->hung) return "loop() hung and was reset by the watchdog";
+    if (k->other) return "scan delivered another key";
+    return "missed by the scan";
+}
+
+int main(int argc, char **argv) {
+    int direct = 0;
+    FILE *in = stdin;
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "-d") == 0) direct = 1;
+        else if (!(in = fopen(argv[a], "r"))) {
+            perror(argv[a]);
+            return 1;
+        }
+    }
+    memset(ddram, ' ', sizeof(ddram));
+    setup();
+
+    static KeyRecord keys[4096];
+    int n = 0, dropped = 0, seq = 0;
+    uint64_t worst = 0, total = 0;
+    long bytes = 0;
+    char line[1024];
+    printf("%-4s %-4s %-6s %-8s %-10s %12s %6s  %s\n", "seq", "key", "layer", "row,col", "delivered", "cycles",
+           "bytes", "display (line 1|line 2)");
+    while (fgets(line, sizeof(line), in) && n < 4096) {
+        seq++;
+        for (char *p = line; *p && *p != '\n' && n < 4096; p++) {
+            KeyRecord *k = &keys[n++];
+            memset(k, 0, sizeof(*k));
+            k->key = *p;
+            locate(k);
+            if (direct) replayDirect(k);
+            else replayScan(k);
+            if (k->delivered && !k->full) {
+                uint64_t c = k->doneAt - k->pressAt;
+                total += c;
+                bytes += k->bytes;
+                if (c > worst) worst = c;
+                printf("%-4d %-4c %-6s %d,%-6d %-10d %12llu %6ld  %s\n", seq, k->key,
+                       k->shift == 1 ? "shift" : k->shift == 0 ? "normal" : "both", k->row, k->col, k->delivered,
+                       (unsigned long long)c, k->bytes, k->shown);
+            } else {
+                dropped++;
+                printf("%-4d %-4c %-6s %d,%-6d %-10s %12s %6s  (%s)\n", seq, k->key,
+                       k->shift == 1 ? "shift" : k->shift == 0 ? "normal" : "both", k->row, k->col, "dropped", "-", "-",
+                       why(k));
+            }
+        }
+    }
+    int delivered = n - dropped;
+    printf("\n%d keys, %d delivered, %d dropped", n, delivered, dropped);
+    if (delivered) {
+        printf("; key to last LCD byte: mean %.0f cycles (%.2f ms), worst %llu cycles (%.2f ms); %.1f LCD bytes per key",
+               (double)total / delivered, (double)total / delivered / (F_CPU / 1000.0), (unsigned long long)worst,
+               worst / (F_CPU / 1000.0), (double)bytes / delivered);
+    }
+    printf("\n");
+    if (resets) {
+        printf("watchdog resets: %ld, the last one while polling %s\n", resets,
+               stuckOn >= 0 ? regName[stuckOn] : "a busy wait");
+    }
+    for (int c = 0; c < 256; c++) {
+        if (spurious[c]) printf("delivered without being pressed: '%c' %ld times\n", c, spurious[c]);
+    }
+    for (int i = 0; i < n; i++) {
+        if (!keys[i].delivered || keys[i].full) printf("dropped '%c': %s\n", keys[i].key, why(&keys[i]));
+    }
+    return 0;
+}
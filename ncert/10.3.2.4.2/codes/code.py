@@ -1,38 +1,31 @@
 import ctypes
 import numpy as np
 import matplotlib.pyplot as plt
+import sys
+sys.path.insert(0, "../../lib")
+from npbuf import rows  # zero-copy ndarray pointers
 
 # Load the shared library
 lib = ctypes.CDLL('./func.so')  # Compile the C code to a shared library (.so)
 
-# Define the matrix structure in Python
-class Matrix(ctypes.Structure):
-    _fields_ = [("mat", ctypes.c_double * 4)]  # 2x2 matrix flattened to 1D (ORDER * ORDER)
-
-# Define the C function prototypes
-lib.luDecompose.argtypes = [Matrix, ctypes.POINTER(Matrix), ctypes.POINTER(Matrix)]
-lib.luDecompose.restype = None
+# Define the C function prototypes, results go into caller-owned arrays
+lib.luDecomposebuf.argtypes = [ctypes.c_void_p, ctypes.c_long, ctypes.c_void_p, ctypes.c_long, ctypes.c_void_p, ctypes.c_long, ctypes.c_int]
+lib.luDecomposebuf.restype = ctypes.c_int
 
 # Input matrix A (2x2)
-A = Matrix((1, -1, 3, -3))
+A = np.array([[1.0, -1.0], [3.0, -3.0]])
+n = A.shape[0]
 
 # Create empty matrices for L and U
-L = Matrix((0,) * 4)
-U = Matrix((0,) * 4)
+L_np = np.empty((n, n))
+U_np = np.empty((n, n))
 
 # Call the C function for LU decomposition
-lib.luDecompose(A, ctypes.byref(L), ctypes.byref(U))
-
-# Convert the results back to Python-readable format
-def matrix_to_numpy(mat):
-    return np.array(mat.mat).reshape(2, 2)
-
-L_np = matrix_to_numpy(L)
-U_np = matrix_to_numpy(U)
+lib.luDecomposebuf(*rows(A, np.float64), *rows(L_np, np.float64), *rows(U_np, np.float64), n)
 
 # Print the results
 print("Input Matrix A:")
-print(matrix_to_numpy(A))
+print(A)
 print("\nLower Triangular Matrix L:")
 print(L_np)
 print("\nUpper Triangular Matrix U:")
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <math.h>
 #include <stdlib.h>
+#include "../../lib/lu.h"
 #define ORDER 2
 
 // Define a struct for a matrix
@@ -10,51 +11,18 @@ typedef struct matrix {
 
 // Function to perform LU decomposition
 void luDecompose(matrix A, matrix *L, matrix *U) {
-    int i, j, k;
-
-    // Initialize L and U
-    for (i = 0; i < ORDER; i++) {
-        for (j = 0; j < ORDER; j++) {
-            if (i == j) {
-                L->mat[i][j] = 1; // Diagonal elements of L are 1
-            } else {
-                L->mat[i][j] = 0;
-            }
-            U->mat[i][j] = 0;
-        }
-    }
-
-    // Perform decomposition
-    for (i = 0; i < ORDER; i++) {
-        // Calculate U
-        for (j = i; j < ORDER; j++) {
-            U->mat[i][j] = A.mat[i][j];
-            for (k = 0; k < i; k++) {
-                U->mat[i][j] -= L->mat[i][k] * U->mat[k][j];
-            }
-        }
+    lu_decompose(&A.mat[0][0], ORDER, &L->mat[0][0], ORDER, &U->mat[0][0], ORDER, ORDER);
+}
 
-        // Calculate L
-        for (j = i + 1; j < ORDER; j++) {
-            L->mat[j][i] = A.mat[j][i];
-            for (k = 0; k < i; k++) {
-                L->mat[j][i] -= L->mat[j][k] * U->mat[k][i];
-            }
-            L->mat[j][i] /= U->mat[i][i];
-        }
-    }
+// LU decomposition of the n x n matrix A into caller buffers L and U, nothing is allocated
+// Row i of each matrix starts at i*lda (ldl, ldu), so NumPy arrays can be passed as they are
+int luDecomposebuf(const double *A, long lda, double *L, long ldl, double *U, long ldu, int n) {
+    return lu_decompose(A, lda, L, ldl, U, ldu, n);
 }
 
 // Function to print a matrix
 void printMatrix(matrix M, const char *name) {
-    printf("%s:\n", name);
-    for (int i = 0; i < ORDER; i++) {
-        for (int j = 0; j < ORDER; j++) {
-            printf("%8.4f ", M.mat[i][j]);
-        }
-        printf("\n");
-    }
-    printf("\n");
+    mat_print(&M.mat[0][0], ORDER, ORDER, name);
 }
 
 // Main function
@@ -72,4 +40,3 @@ int main() {
 
     return 0;
 }
-
@@ -1,53 +1,40 @@
 import ctypes
 import numpy as np
 import matplotlib.pyplot as plt
+import sys
+sys.path.insert(0, "../../lib")
+from npbuf import ptr, rows  # zero-copy ndarray pointers
 
 # Load the shared library
 lib = ctypes.CDLL('./func.so')  # Compile the C code to a shared library (.so)
 
-# Define the matrix structure in Python
-class Matrix(ctypes.Structure):
-    _fields_ = [("mat", ctypes.c_double * 4)]  # 2x2 matrix flattened to 1D (ORDER * ORDER)
+# Define the C function prototypes, results go into caller-owned arrays
+lib.luDecomposebuf.argtypes = [ctypes.c_void_p, ctypes.c_long, ctypes.c_void_p, ctypes.c_long, ctypes.c_void_p, ctypes.c_long, ctypes.c_int]
+lib.luDecomposebuf.restype = ctypes.c_int
 
-# Define the vector structure in Python
-class Vector(ctypes.Structure):
-    _fields_ = [("vec", ctypes.c_double * 2)]  # 2-element vector
-
-# Define the C function prototypes
-lib.luDecompose.argtypes = [Matrix, ctypes.POINTER(Matrix), ctypes.POINTER(Matrix)]
-lib.luDecompose.restype = None
-
-lib.solve.argtypes = [Matrix, Vector]
-lib.solve.restype = Vector
+lib.solvebuf.argtypes = [ctypes.c_void_p, ctypes.c_long, ctypes.c_void_p, ctypes.c_void_p, ctypes.c_int, ctypes.c_void_p]
+lib.solvebuf.restype = ctypes.c_int
 
 # Input matrix A (2x2) and vector b
-A = Matrix((1, 1, 1, -1))  # Coefficient matrix
-b = Vector((36, 4))  # Right-hand side vector
+A = np.array([[1.0, 1.0], [1.0, -1.0]])  # Coefficient matrix
+b = np.array([36.0, 4.0])  # Right-hand side vector
+n = len(b)
 
 # Create empty matrices for L and U
-L = Matrix((0,) * 4)
-U = Matrix((0,) * 4)
+L_np = np.empty((n, n))
+U_np = np.empty((n, n))
 
 # Call the C function for LU decomposition
-lib.luDecompose(A, ctypes.byref(L), ctypes.byref(U))
+lib.luDecomposebuf(*rows(A, np.float64), *rows(L_np, np.float64), *rows(U_np, np.float64), n)
 
 # Solve the system using the solve function from the C library
-solution = lib.solve(A, b)
-
-# Convert the results back to Python-readable format
-def matrix_to_numpy(mat):
-    return np.array(mat.mat).reshape(2, 2)
-
-def vector_to_numpy(vec):
-    return np.array(vec.vec)
-
-L_np = matrix_to_numpy(L)
-U_np = matrix_to_numpy(U)
-solution_np = vector_to_numpy(solution)
+solution_np = np.empty(n)
+lu = np.empty(n * n)  # scratch for the factors
+lib.solvebuf(*rows(A, np.float64), ptr(b, np.float64), ptr(solution_np, np.float64), n, ptr(lu, np.float64))
 
 # Print the results
 print("Input Matrix A:")
-print(matrix_to_numpy(A))
+print(A)
 print("\nLower Triangular Matrix L:")
 print(L_np)
 print("\nUpper Triangular Matrix U:")
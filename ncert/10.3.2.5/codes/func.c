@@ -1,6 +1,10 @@
 #include <stdio.h>
 #include <math.h>
 #include <stdlib.h>
+#include "../../lib/lu.h"
+#include "../../lib/band.h"
+#include "../../lib/sparse.h"
+#include "../../lib/krylov.h"
 #define ORDER 2
 
 // Define a struct for a matrix
@@ -13,69 +17,90 @@ typedef struct vector{
 }vector;
 // Function to perform LU decomposition
 void luDecompose(matrix A, matrix *L, matrix *U) {
-    int i, j, k;
-
-    // Initialize L and U
-    for (i = 0; i < ORDER; i++) {
-        for (j = 0; j < ORDER; j++) {
-            if (i == j) {
-                L->mat[i][j] = 1; // Diagonal elements of L are 1
-            } else {
-                L->mat[i][j] = 0;
-            }
-            U->mat[i][j] = 0;
-        }
-    }
-
-    // Perform decomposition
-    for (i = 0; i < ORDER; i++) {
-        // Calculate U
-        for (j = i; j < ORDER; j++) {
-            U->mat[i][j] = A.mat[i][j];
-            for (k = 0; k < i; k++) {
-                U->mat[i][j] -= L->mat[i][k] * U->mat[k][j];
-            }
-        }
+    lu_decompose(&A.mat[0][0], ORDER, &L->mat[0][0], ORDER, &U->mat[0][0], ORDER, ORDER);
+}
 
-        // Calculate L
-        for (j = i + 1; j < ORDER; j++) {
-            L->mat[j][i] = A.mat[j][i];
-            for (k = 0; k < i; k++) {
-                L->mat[j][i] -= L->mat[j][k] * U->mat[k][i];
-            }
-            L->mat[j][i] /= U->mat[i][i];
-        }
-    }
+// LU decomposition of the n x n matrix A into caller buffers L and U, nothing is allocated
+// Row i of each matrix starts at i*lda (ldl, ldu), so NumPy arrays can be passed as they are
+int luDecomposebuf(const double *A, long lda, double *L, long ldl, double *U, long ldu, int n) {
+    return lu_decompose(A, lda, L, ldl, U, ldu, n);
 }
 
 // Function to print a matrix
 void printMatrix(matrix M, const char *name) {
-    printf("%s:\n", name);
-    for (int i = 0; i < ORDER; i++) {
-        for (int j = 0; j < ORDER; j++) {
-            printf("%8.4f ", M.mat[i][j]);
-        }
-        printf("\n");
-    }
-    printf("\n");
+    mat_print(&M.mat[0][0], ORDER, ORDER, name);
 }
 
 vector solve(matrix A, vector b){
-	matrix L,U;
-	for (int i = 0; i < ORDER; i++) {
-        for (int j = 0; j < ORDER; j++) {
-            L.mat[i][j] = 0;  // Diagonal elements of L are 1
-            U.mat[i][j] = 0;                // All elements of U are 0
-        }
-    }
-	luDecompose(A,&L,&U);
-	vector y={0,0},x={0,0};
-	y.vec[0]=b.vec[0];
-	y.vec[1]=b.vec[1]-L.mat[1][0]*y.vec[0];
-	x.vec[1]=y.vec[1]/U.mat[1][1];
-	x.vec[0]=(y.vec[0]-x.vec[1]*U.mat[0][1])/U.mat[0][0];
+	matrix LU;
+	vector x={{0,0}};
+	lu_solve(&A.mat[0][0],ORDER,b.vec,x.vec,ORDER,&LU.mat[0][0]);
 	return x;
 
 } 
 
+// Solve Ax=b for an n x n A into the caller's x, lu must hold n*n doubles of scratch
+int solvebuf(const double *A, long lda, const double *b, double *x, int n, double *lu) {
+    return lu_solve(A, lda, b, x, n, lu);
+}
 
+// Banded A in band storage, row i holding A[i][i-kl..i+ku] at ab+i*ldab (see band.h)
+// lu must hold n*(kl+ku+1) doubles of scratch; O(n*kl*ku) instead of the dense O(n^3)
+int bandsolvebuf(const double *ab, long ldab, const double *b, double *x, long n, int kl, int ku, double *lu) {
+    return band_solve(ab, ldab, b, x, n, kl, ku, lu);
+}
+
+// Tridiagonal A in band storage with kl=ku=1, work must hold 3n doubles
+// nthreads>1 uses partitioned cyclic reduction for long systems, otherwise the Thomas algorithm
+int trisolvebuf(const double *ab, long ldab, const double *b, double *x, long n, double *work, int nthreads) {
+    return tri_solve_cr(ab, ldab, b, x, n, work, nthreads);
+}
+
+// Preconditioner for the CSR solvers below: 0 none, 1 Jacobi (pval holds n doubles),
+// 2 ILU(0) (pval holds ptr[n] doubles and pdiag n longs); returns -1 if it cannot be built
+static int precondition(const csr *A, int precond, double *pval, long *pdiag, ilu0 *M, matvec *f, void **ctx) {
+    *f = NULL;
+    *ctx = NULL;
+    if (precond == 1) {
+        *f = jacobi_apply;
+        *ctx = pval;
+        return csr_jacobi(A, pval);
+    }
+    if (precond == 2) {
+        *f = ilu0_apply;
+        *ctx = M;
+        return csr_ilu0(A, pval, pdiag, M);
+    }
+    return 0;
+}
+
+// Sparse A in CSR form (the indptr, indices and data of scipy.sparse.csr_matrix, indices int32)
+// Conjugate gradients for SPD A from the x passed in, work must hold 4n doubles
+// Returns the iteration count or -1, st (NULL or a kstats) gets the iteration statistics
+int cgcsrbuf(long n, const long *ptr, const int *col, const double *val, const double *b, double *x,
+    double tol, int maxiter, int precond, double *pval, long *pdiag, double *work, int nthreads, kstats *st) {
+    csr A = {n, ptr, col, val, nthreads};
+    ilu0 M;
+    matvec f;
+    void *ctx;
+    if (precondition(&A, precond, pval, pdiag, &M, &f, &ctx) != 0) return -1;
+    return cg(csr_matvec, &A, f, ctx, b, x, n, tol, maxiter, work, st);
+}
+
+// Restarted GMRES(m) for general A, work must hold GMRES_WORK(n,m) = (m+2)n+(m+1)(m+4) doubles
+int gmrescsrbuf(long n, const long *ptr, const int *col, const double *val, const double *b, double *x, int m,
+    double tol, int maxiter, int precond, double *pval, long *pdiag, double *work, int nthreads, kstats *st) {
+    csr A = {n, ptr, col, val, nthreads};
+    ilu0 M;
+    matvec f;
+    void *ctx;
+    if (precondition(&A, precond, pval, pdiag, &M, &f, &ctx) != 0) return -1;
+    return gmres(csr_matvec, &A, f, ctx, b, x, n, m, tol, maxiter, work, st);
+}
+
+// Solve Ax=b with pivoted float LU factors refined to double accuracy by double residuals, falling back
+// to pivoted double factors if refinement stalls; work must hold LU_MIXED_WORK(n) = n*n+2n+(n+1)/2 doubles
+// Returns 0 (float factors), 1 (double fallback) or -1 (singular or not converged), st gets the refinement steps
+int solvemixedbuf(const double *A, long lda, const double *b, double *x, int n, int maxiter, double *work, kstats *st) {
+    return lu_solve_mixed(A, lda, b, x, n, maxiter, work, st);
+}
@@ -1,63 +1,44 @@
 import numpy as np
 import matplotlib.pyplot as plt
 import ctypes
-from ctypes import POINTER, c_double
-
-# Define complex type for ctypes
-class Complex(ctypes.Structure):
-    _fields_ = [("real", ctypes.c_double), ("imag", ctypes.c_double)]
-
-    def __complex__(self):
-        return self.real + self.imag * 1j
-
-
-# Define the matrix struct
-class Matrix(ctypes.Structure):
-    _fields_ = [("mat", Complex * 2 * 2)]  # Assuming ORDER = 2
-
+import sys
+from ctypes import c_int, c_long, c_void_p
+sys.path.insert(0, "../../lib")
+from npbuf import ptr, rows, stride  # zero-copy ndarray pointers
 
 # Load the compiled C libraries
 # Replace these paths with the actual locations of your compiled shared libraries
 eigen_lib = ctypes.CDLL("./func.so")
 newton_lib = ctypes.CDLL("./func.so")
 
-# Declare the function signatures
-eigen_lib.QRAlgorithm.restype = POINTER(Complex)
-eigen_lib.QRAlgorithm.argtypes = [Matrix]
-newton_lib.newton.restype = POINTER(c_double)
+# Declare the function signatures, results go into caller-owned arrays
+eigen_lib.QRAlgorithmrows.restype = c_int
+eigen_lib.QRAlgorithmrows.argtypes = [c_void_p, c_long, c_int, c_void_p, c_long, c_void_p, c_void_p]
+newton_lib.newtonbuf.restype = c_int
+newton_lib.newtonbuf.argtypes = [c_void_p, c_int]
 print("hi")
 
 def extract_eigenvalues():
     """Extract eigenvalues from the hardcoded matrix {{0, 1}, {273, -32}}."""
-    # Define the hardcoded matrix
-    matrix = Matrix()
-    matrix.mat[0][0] = Complex(0, 0)       # mat[0][0] = 0
-    matrix.mat[0][1] = Complex(1, 0)       # mat[0][1] = 1
-    matrix.mat[1][0] = Complex(273, 0)     # mat[1][0] = 273
-    matrix.mat[1][1] = Complex(-32, 0)     # mat[1][1] = -32
+    # Companion matrix of x^2 + 32x - 273, passed to C as it is
+    A = np.array([[0, 1], [273, -32]], dtype=np.complex128)
+    n = A.shape[0]
 
-    # Call the QRAlgorithm function
-    eigenvalues_ptr = eigen_lib.QRAlgorithm(matrix)
-
-    # Retrieve eigenvalues from the pointer
-    eigenvalues = [complex(eigenvalues_ptr[i]) for i in range(2)]  # Assuming ORDER = 2
-
-    # Free allocated memory in C
-    eigen_lib.free(eigenvalues_ptr)
+    # Eigenvalues are written into the array, work is the scratch the QR iteration needs
+    eigenvalues = np.empty(n, dtype=np.complex128)
+    work = np.empty(3 * n * n + 2 * n, dtype=np.complex128)
+    a, lda = rows(A, np.complex128)
+    eigen_lib.QRAlgorithmrows(a, lda, n, ptr(eigenvalues, np.complex128), stride(eigenvalues),
+                              ptr(work, np.complex128), None)
 
     return eigenvalues
 
 print("hi")
 def extract_roots():
     """Call the newton method from the C library and retrieve roots."""
-    # Call the newton function
-    roots_ptr = newton_lib.newton()
-
-    # Retrieve the roots (assuming 2 roots)
-    roots = [roots_ptr[i] for i in range(2)]
-
-    # Free allocated memory in C
-    newton_lib.free(roots_ptr)
+    # Call the newton function, roots are written into the array (assuming 2 roots)
+    roots = np.empty(2, dtype=np.float64)
+    newton_lib.newtonbuf(ptr(roots, np.float64), len(roots))
 
     return roots
 
@@ -2,246 +2,133 @@
 #include <math.h>
 #include <complex.h>
 #include <stdlib.h>
-//TO DO LIST
-//QR DECOMPOSITION DONE
-//QR Algo DONE
-//MATRIX SUB DONE
-//MATRIX SCALARMULT DONE
-//MATRIX MULT DONE
-//WILKINSON SHIFT DONE
-//VECTOR NORM DONE
+#include "../../lib/eigen.h"
+#include "../../lib/newton.h"
+#include "../../lib/eigs.h"
+#include "../../lib/sparse.h"
+#include "../../lib/arena.h"
 #define MAX_ITER 10000
 #define ORDER 2
 typedef struct matrix{
 	double complex mat[ORDER][ORDER];
 }matrix;
-typedef struct QR{
-	matrix Q;
-	matrix R;
-}QR;
-double complex VectorInnerProduct(double complex* vector1,double complex* vector2){
-	double complex ip=0;
-	for (int i=0;i<ORDER;i++){
-                ip+=vector1[i]*conj(vector2[i]);
-        }
-	return ip;
-}
-double complex VectorNorm(double complex* vector){
-	return csqrt(VectorInnerProduct(vector,vector));
-}
-matrix Identity(){
-	matrix Id;
-	
-	for (int i=0;i<ORDER;i++){
-		for(int j=0;j<ORDER;j++){
-			if (i==j){
-				Id.mat[i][j]=1;
-			}
-			else{
-				Id.mat[i][j]=0;
-			}
-		}
-	}
-	return Id;
-}
 
-matrix MatScalMult(matrix mat,double complex scal){
-	matrix result;
-	for (int i=0;i<ORDER;i++){
-		for (int j=0;j<ORDER;j++){
-			result.mat[i][j]=mat.mat[i][j]*scal;
-		}
-	}
-	return result;
+// Eigenvalues of A into the caller's buffer eigenv[0..n-1], n must be at least ORDER
+// Householder QR with Wilkinson shift, see lib/eigen.c
+// st (may be NULL) receives the iteration and deflation counts, residual and wall time
+int QRAlgorithmstats(matrix A, double complex* eigenv, int n, kstats* st){
+    double complex work[QR_WORK(ORDER)];
+    if (n < ORDER){
+        return -1;
+    }
+    return qr_eigen(&A.mat[0][0], ORDER, eigenv, work, MAX_ITER, st) < 0 ? -1 : 0;
 }
-matrix MatSub(matrix mat1,matrix mat2){
-	matrix result;
-
-    for (int i=0;i<ORDER;i++){
-            for (int j=0;j<ORDER;j++){
-                result.mat[i][j]=mat1.mat[i][j]-mat2.mat[i][j];
-            }       
-    }       
-        return result;
+
+int QRAlgorithmbuf(matrix A, double complex* eigenv, int n){
+    return QRAlgorithmstats(A, eigenv, n, NULL);
 }
-matrix MatMult(matrix mat1,matrix mat2) {
-    matrix result;
-    for (int i=0;i<ORDER;i++){
-        for (int j=0;j<ORDER;j++){
-            result.mat[i][j]=0;
+
+// Eigenvalues of any n x n A, row i at A+i*lda (a NumPy array as it is), into eigenv[i*stride]
+// A is left untouched; work must hold n*n+QR_WORK(n)+n = 3n^2+2n values and nothing is allocated
+int QRAlgorithmrows(const double complex* A, long lda, int n, double complex* eigenv, long stride,
+    double complex* work, kstats* st){
+    double complex* a = work + QR_WORK(n);
+    double complex* eig = a + (long)n * n;
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            a[(long)i * n + j] = A[i * lda + j];
         }
     }
-    for (int i=0;i<ORDER;i++){
-        for (int j=0;j<ORDER;j++){
-            for (int k=0;k<ORDER;k++){
-                result.mat[i][j]+=mat1.mat[i][k]*mat2.mat[k][j];
-            }
-        }
+    if (qr_eigen(a, n, eig, work, MAX_ITER, st) < 0) {
+        return -1;
     }
-    
-    return result;
-}
-matrix trans(matrix mat){
-    matrix result;
-    for (int i=0;i<ORDER;i++){
-        for (int j=0;j<ORDER;j++){
-        result.mat[i][j]=conj(mat.mat[j][i]);
-        }
+    for (int i = 0; i < n; i++) {
+        eigenv[i * stride] = eig[i];
     }
-    return result;
+    return 0;
 }
-double complex WilkinsonShift(matrix A){
-    double complex delta = (A.mat[ORDER-2][ORDER-2]-A.mat[ORDER-1][ORDER-1])/2;
-    if (cabs(delta)==0 && cabs(A.mat[ORDER-1][ORDER-2])==0){
-        return A.mat[ORDER-1][ORDER-1]+1;
-    }
-    else if (cabs(delta)==0){
-        return A.mat[ORDER-1][ORDER-1]-A.mat[ORDER-1][ORDER-2]+1;
-    }
-    else if(cabs(A.mat[ORDER-1][ORDER-2])==0){
-        return A.mat[ORDER-1][ORDER-1]+1;
-    }
-    else{
-        return A.mat[ORDER-1][ORDER-1]-((delta/cabs(delta))*(A.mat[ORDER-1][ORDER-2]*A.mat[ORDER-1][ORDER-2])/(cabs(delta)+csqrt(delta*delta+A.mat[ORDER-1][ORDER-2]*A.mat[ORDER-1][ORDER-2])));
-    }
+
+// k eigenvalues of a large sparse A in CSR form (scipy indptr int64, indices int32, data)
+// which is EIGS_LM, EIGS_SM, EIGS_LR or EIGS_SR (0..3), m Krylov vectors with k+1<m<=n
+// work must hold EIGS_WORK(n,m) = (m+1)n+11m^2+70m+64 doubles; returns restarts or -1, see lib/eigs.h
+// Symmetric A: implicitly restarted Lanczos, real eigenvalues
+int Lanczoscsr(long n, const long* ptr, const int* col, const double* val, int k, int m, int which,
+    double tol, double* eigenv, double* work, int nthreads, kstats* st){
+    csr A = {n, ptr, col, val, nthreads};
+    return lanczos_eigs(csr_matvec, &A, n, k, m, which, tol, MAX_ITER, eigenv, work, nthreads, st);
 }
-int tolcheck(matrix A){
-    int t=0;
-    double complex tol=1e-12;
-    for (int i=1;i<ORDER;i++){
-        for (int j=0;j<i;j++){
-            if (cabs(A.mat[i][j])>cabs(tol)){
-                t++;
-                break;
-            }
-        }
-    }
-    if (t>0){
-        return 1;
-    } 
-    else{return 0;}
+
+// General A: implicitly restarted Arnoldi, complex eigenvalues
+int Arnoldicsr(long n, const long* ptr, const int* col, const double* val, int k, int m, int which,
+    double tol, double complex* eigenv, double* work, int nthreads, kstats* st){
+    csr A = {n, ptr, col, val, nthreads};
+    return arnoldi_eigs(csr_matvec, &A, n, k, m, which, tol, MAX_ITER, eigenv, work, nthreads, st);
 }
 
-QR QRDecomposition(matrix A){
-    QR result;
-    matrix  H;
-    result.Q=Identity();
-    result.R=A;    
-
-    for (int k=0;k<ORDER-1;k++){
-        double complex v[ORDER-k];
-        double complex beta;
-        for (int i=k;i<ORDER;i++){
-            v[i-k]=result.R.mat[i][k];
-        }
-        double complex alpha;
-        //printf("%lf %lf\n",creal(v[0]),creal(v[1]));  
-        if (creal(v[0])==0){
-        alpha=VectorNorm(v);
-        }
-        else{
-        alpha=(result.R.mat[k][k]/cabs(result.R.mat[k][k]))*VectorNorm(v);
-        }
-        v[0]+=alpha;
-        double complex vc=VectorNorm(v);
-        if (vc!=0){
-        for (int i=0;i<ORDER-k;i++){
-            v[i]/=vc;
-            }
-        }
-        double complex qprime[ORDER-k][ORDER-k];
-        for(int i=0;i<ORDER-k;i++){
-            for(int j=0;j<ORDER-k;j++){
-                if (i==j){
-                    qprime[j][i]=1-(2*conj(v[i])*v[j]);
-                }
-                else{
-                    qprime[j][i]=-(2*conj(v[i])*v[j]);
-                }
-            }
-        }
-        
-
-        for(int i=0;i<ORDER;i++){
-            for (int j=0;j<ORDER;j++){
-                if (i==j && i<k){H.mat[i][j]=1;}
-                else if(i>=k&&j>=k){
-                    H.mat[i][j]=qprime[i-k][j-k];
-                }
-                else{H.mat[i][j]=0;}
-            }
-        }
-        result.R=MatMult(H,result.R);
+double complex* QRAlgorithm(matrix A){
+    double complex* eigenv = (double complex*)malloc(ORDER * sizeof(double complex));
+    QRAlgorithmbuf(A, eigenv, ORDER);
+    return eigenv;
+}
 
+// Eigenvalues of A into ORDER values taken from a, with the QR scratch released again on return
+// Nothing touches the heap; returns NULL if a is too small or in query mode (see lib/arena.h)
+double complex* QRAlgorithmarena(matrix A, arena* a){
+    double complex* eigenv = ARENA_NEW(a, double complex, ORDER);
+    size_t mark = arena_mark(a);
+    double complex* work = ARENA_NEW(a, double complex, QR_WORK(ORDER));
+    int ret = eigenv && work ? qr_eigen(&A.mat[0][0], ORDER, eigenv, work, MAX_ITER, NULL) : -1;
+    arena_release(a, mark);
+    return ret < 0 ? NULL : eigenv;
+}
 
-        result.Q=MatMult(result.Q,trans(H));
-    }
+// Coefficients of f(x) = x^2 + 32x - 273, highest power first
+static const double fcoef[] = {1, 32, -273};
 
+dual fdx(double x, void *ctx) {
+    (void)ctx;
+    return dhorner(fcoef, 3, x); // f(x) and f'(x) in one pass
+}
 
-    return result;
+double fx(double x) {
+    return fdx(x, NULL).d; // Derivative of f(x)
 }
 
-double complex* QRAlgorithm(matrix A){
-    double complex* eigenv = (double complex*)malloc(ORDER * sizeof(double complex));
-    double complex shift;
+double f(double x) {
+    return horner(fcoef, 3, x); // Original function
+}
 
-    for (int  i=0; i< MAX_ITER; i++){
-        if (tolcheck(A)==0){
-            break;
-        }
-         shift = WilkinsonShift(A);
-         matrix identity = Identity();
-         A = MatSub(A, MatScalMult(identity, shift));
-         QR qr = QRDecomposition(A);
-         A = MatMult(qr.R,qr.Q);
-        A=MatSub(MatMult(qr.R, qr.Q),MatScalMult(identity, -shift));       
+// Both roots into the caller's buffer roots[0..n-1], n must be at least 2
+// st is NULL or holds two kstats, one per root
+int newtonstats(double* roots, int n, kstats* st) {
+    double tol = 1e-3; // Tolerance for convergence
+    if (n < 2) {
+        return -1;
     }
-    
-    int i;
-    for (i=0;i<ORDER-1;i++){
-        if (cabs(A.mat[i+1][i])>1e-5){
-            double complex eig1,eig2,a=A.mat[i][i],b=A.mat[i][i+1],c=A.mat[i+1][i],d=A.mat[i+1][i+1];
-            eigenv[i]=(a+d+csqrt((a+d)*(a+d)-4*(a*d-b*c)))/2;
-            eigenv[i+1]=(a+d-csqrt((a+d)*(a+d)-4*(a*d-b*c)))/2;
-            ++i;
-            
-        }
-        else{
-        eigenv[i]=A.mat[i][i];
-        }
+    // Find the first root from -100 and the second from 0 using Newton-Raphson
+    if (newton_root(fdx, NULL, -100.0, tol, MAX_ITER, &roots[0], st) < 0 ||
+        newton_root(fdx, NULL, 0.0, tol, MAX_ITER, &roots[1], st ? st + 1 : NULL) < 0) {
+        return -1;
     }
-    if (i==ORDER-1){
-    eigenv[ORDER-1]=A.mat[ORDER-1][ORDER-1];}
-    return eigenv;
-}
-
-double fx(double x) {
-    return 2 * x + 32; // Derivative of f(x)
+    return 0;
 }
 
-double f(double x) {
-    return x * x + 32 * x - 273; // Original function
+int newtonbuf(double* roots, int n) {
+    return newtonstats(roots, n, NULL);
 }
 
 double* newton(void) {
-    double tol = 1e-3; // Tolerance for convergence
     double* roots = (double*)malloc(2 * sizeof(double));
-    double root = -100.0; // Initial guess for the first root
-    roots[0] = root; // Initialize the first root
+    newtonbuf(roots, 2);
+    return roots;
+}
 
-    // Find the first root
-    while (fabs(f(root)) > tol) {
-        root -= f(root) / fx(root); // Update using Newton-Raphson
-    }
-    roots[0] = root;
 
-    // Find the second root
-    root = 0.0; // Start from a different initial guess
-    while (fabs(f(root)) > tol) {
-        root -= f(root) / fx(root); // Update using Newton-Raphson
+// Both roots into two values taken from a, NULL if a is too small or in query mode
+double* newtonarena(arena* a) {
+    double* roots = ARENA_NEW(a, double, 2);
+    if (!roots || newtonbuf(roots, 2) != 0) {
+        return NULL;
     }
-    roots[1] = root;
-
     return roots;
 }
-
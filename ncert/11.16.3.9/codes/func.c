@@ -1,28 +1,74 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
+#include "../../lib/mc.h"
+#include "../../lib/alias.h"
 
-void simulate_bernoulli(double p_a, int n_simulations, double *empirical_pmf) {
-    int count_0 = 0, count_1 = 0; // Counters for outcomes 0 and 1
-
-    // Seed the random number generator
-    srand(time(NULL));
-
-    // Simulate Bernoulli trials
-    for (int i = 0; i < n_simulations; i++) {
-        double rand_num = (double)rand() / RAND_MAX; // Generate a random number in [0, 1)
-        if (rand_num < p_a) {
-            count_1++; // Outcome 1 (success)
-        } else {
-            count_0++; // Outcome 0 (failure)
-        }
+// Simulate n_simulations Bernoulli(p_a) trials and store the empirical PMF
+// The result depends only on seed, not on the number of threads (nthreads<=0 uses every CPU)
+// n_simulations<=0 leaves both probabilities 0
+void simulate_bernoulli_seed(double p_a, long long n_simulations, unsigned long long seed, int nthreads, double *empirical_pmf) {
+    // No draws, no frequencies; a negative count would wrap to a huge uint64_t
+    if (n_simulations <= 0) {
+        empirical_pmf[0] = empirical_pmf[1] = 0;
+        return;
     }
+    uint64_t count_1 = mc_bernoulli(p_a, n_simulations, seed, nthreads); // Outcome 1 (success)
+    uint64_t count_0 = n_simulations - count_1; // Outcome 0 (failure)
 
     // Calculate the empirical PMF
     empirical_pmf[0] = (double)count_0 / n_simulations; // Probability of 0 (not A)
     empirical_pmf[1] = (double)count_1 / n_simulations; // Probability of 1 (A)
 }
 
+void simulate_bernoulli(double p_a, int n_simulations, double *empirical_pmf) {
+    // Seed from the clock, as before, on a single thread
+    simulate_bernoulli_seed(p_a, n_simulations, (unsigned long long)time(NULL), 1, empirical_pmf);
+}
+
+// Empirical PMF of n_simulations draws from any discrete distribution pmf[0..k-1]
+// empirical_pmf must hold k values, returns 0 on success or -1 (also for n_simulations<0)
+int simulate_pmf(const double *pmf, int k, long long n_simulations, unsigned long long seed, int nthreads, double *empirical_pmf) {
+    if (n_simulations < 0) return -1;
+    alias a;
+    a.thr = (uint64_t *)malloc(k * sizeof(uint64_t));
+    a.alias = (int *)malloc(k * sizeof(int));
+    double *q = (double *)malloc(k * sizeof(double));
+    int *work = (int *)malloc(k * sizeof(int));
+    int ret = -1;
+    if (a.thr && a.alias && q && work && alias_build(&a, pmf, k, q, work) == 0) {
+        ret = alias_hist(&a, n_simulations, seed, nthreads, empirical_pmf);
+    }
+    free(a.thr);
+    free(a.alias);
+    free(q);
+    free(work);
+    return ret;
+}
+
+// Empirical PMF of binomial(n, p) into empirical_pmf[0..n]
+int simulate_binomial(long n, double p, long long n_simulations, unsigned long long seed, int nthreads, double *empirical_pmf) {
+    if (n_simulations < 0) return -1;
+    return binomial_hist(n, p, n_simulations, seed, nthreads, empirical_pmf);
+}
+
+// Empirical PMF of Poisson(lambda) into empirical_pmf[0..kmax-1], the last bin collects the tail
+int simulate_poisson(double lambda, int kmax, long long n_simulations, unsigned long long seed, int nthreads, double *empirical_pmf) {
+    if (n_simulations < 0) return -1;
+    return poisson_hist(lambda, kmax, n_simulations, seed, nthreads, empirical_pmf);
+}
+
+// Raw binomial(n, p) draws streamed into the .npy file at path (int64), the same draws simulate_binomial counts
+// Returns 0 on success; read with np.load(path, mmap_mode="r")
+int simulate_binomial_npy(long n, double p, long long n_simulations, unsigned long long seed, const char *path) {
+    npysink s;
+    if (npysink_open(&s, path, "<i8", 1, 1) != 0) {
+        return -1;
+    }
+    int ret = binomial_stream(n, p, n_simulations, seed, &s);
+    return npysink_close(&s) != 0 ? -1 : ret;
+}
+
 int main() {
     double p_a = 1.0 / 12.0; // Probability of event A (success)
     int n_simulations = 10000; // Number of simulations
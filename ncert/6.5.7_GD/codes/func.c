@@ -1,6 +1,9 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <math.h>
+#include "../../lib/gd.h"
+#include "../../lib/lbfgs.h"
+#include "../../lib/expr.h"
 //This code of gradient descent scans the entirety of the region to find global min and max
 // Define a structure to hold coordinates (x, y)
 typedef struct coords{
@@ -10,68 +13,80 @@ typedef struct coords{
 typedef struct gradient{
 	coords min,max;
 }gradient;
+//Coefficients of f(x)=3x^4-8x^3+12x^2-48x+25, highest power first
+static const double fcoef[]={3,-8,12,-48,25};
+//f(x) and df/dx together from the single definition above
+dual fdx(double x,void *ctx){
+	(void)ctx;
+	return dhorner(fcoef,5,x);
+}
 // Function to compute the derivative df/dx based on the given equation
 double f1x(double x){
-	return 12*x*x*x-24*x*x+24*x-48;
+	return fdx(x,NULL).d;
 }
 //Function f(x)
 double fx(double x){
-	return 3*pow(x,4)-8*pow(x,3)+12*pow(x,2)-48*x+25;
+	return horner(fcoef,5,x);
 }
 //Gradient Descent
 double gd(double cur,double up){
 	double precision=0.0001,h=0.001;
-	while((fabs(f1x(cur))>precision)&&(cur<up)){  //Ensuring the current iteration value is under upper bound and the loop breaks when slope is under precision value
-		cur-=h*f1x(cur);  //gradient descent difference eqn
-	}
-	return cur;
+	return gd_walk(fdx,NULL,cur,up,h,precision,-1,NULL);  //gradient descent difference eqn
 }
 //"Gradient Ascent"
 double ga(double cur,double up){
         double precision=0.0001,h=0.001;
-        while((fabs(f1x(cur))>precision)&&(cur<up)){  //Ensuring the current iteration value is under upper bound and the loop breaks when slope is under precision value
-                cur+=h*f1x(cur);  //gradient ascent difference eqn
-        }       
-        return cur;
+        return gd_walk(fdx,NULL,cur,up,h,precision,1,NULL);  //gradient ascent difference eqn
 }
 // Function to compute the values of global min and global max and selectively apply gradient descent and ascent
+// st (may be NULL) receives the total steps and evaluations, final slope and wall time
+gradient gstats(double lower,double upper,kstats *st){
+	gdpoint globalmin,globalmax;
+	gd_scan(fdx,NULL,lower,upper,&globalmin,&globalmax,st);
+	gradient val;
+	val.max.y=globalmax.y;
+	val.max.x=globalmax.x;
+	val.min.y=globalmin.y;
+	val.min.x=globalmin.x;
+	return val; 
+}
 gradient g(double lower,double upper){
-	double h=0.001,precision=0.0001;
-	coords globalmax,globalmin;
-	globalmax.y=-1e10,globalmin.y=1e10;//initialising
-	while (upper>lower){ //terminating condition of scnanning the entire region
-		if(f1x(lower)<0){
-			if(fx(lower)>globalmax.y){
-			globalmax.x=lower;
-			globalmax.y=fx(lower);
-			}
-		double X=gd(lower,upper);
-		if(fx(X)<globalmin.y){
-			globalmin.x=X;
-                        globalmin.y=fx(X);
-		}
-		lower=X;
-		}
-		else if(f1x(lower)>0){
-                        if(fx(lower)<globalmin.y){
-                        globalmin.x=lower;
-                        globalmin.y=fx(lower);
-                        }
-                double XX=ga(lower,upper);
-                if(fx(XX)>globalmax.y){
-                        globalmax.x=XX;  
-                        globalmax.y=fx(XX);
-                }
-                lower=XX;
-                }
-			lower+=0.1; //Not to get stuck
-		
+	return gstats(lower,upper,NULL);
+}
 
-	}
+// Global min and max of any f(x) given as a string, e.g. "3*x^4-8*x^3+12*x^2-48*x+25"
+// The slope comes from dual number evaluation of the compiled expression, NANs if f does not compile
+gradient gexpr(const char *f,double lower,double upper){
+	expr e;
+	gdpoint globalmin={NAN,NAN},globalmax={NAN,NAN};
+	if(expr_compile(&e,f,"x")==0) gd_scan(expr_dualfunc,&e,lower,upper,&globalmin,&globalmax,NULL);
 	gradient val;
 	val.max.y=globalmax.y;
 	val.max.x=globalmax.x;
 	val.min.y=globalmin.y;
 	val.min.x=globalmin.x;
-	return val; 
+	return val;
+}
+
+// Share of F(x)=f(x_0)+...+f(x_n-1) owned by x_lo..x_hi-1, with its gradient
+double Fpart(const double *x,double *g,long lo,long hi,long n,void *ctx){
+	(void)n;
+	double F=0;
+	for(long i=lo;i<hi;i++){
+		dual y=fdx(x[i],ctx);
+		F+=y.v;
+		g[i]=y.d;
+	}
+	return F;
+}
+
+// Minimises F over n variables with L-BFGS from the x[] passed in, leaving the minimiser in x[] (every x_i at
+// the minimum of f) and F there in *F; st (may be NULL) receives the iterations, evaluations and final |grad F|
+// Returns the iterations, or -1 if it did not converge or work could not be allocated
+int gdn(double *x,long n,int nthreads,double *F,kstats *st){
+	double *work=(double*)malloc(LBFGS_WORK(n,10)*sizeof(double));
+	if(!work) return -1;
+	int it=lbfgs_sep(Fpart,NULL,x,n,10,1e-8,1000,F,work,nthreads,st);
+	free(work);
+	return it;
 }
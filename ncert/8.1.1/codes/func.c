@@ -1,12 +1,59 @@
 #include <stdio.h>
 #include <math.h>
+#include "../../lib/quad.h"
+#include "../../lib/expr.h"
+#include "../../lib/qmc.h"
+
+//Integrand y=sqrt(x) in the form taken by the quadrature engine
+double rootx(double x,void *ctx){
+	(void)ctx;
+	return sqrt(x);
+}
+
+//Area under y=sqrt(x) by adaptive Gauss-Kronrod to within tol, nfev receives the evaluation count
+double integratedgk(double x1,double x2,double tol,int *nfev){
+	quadstats st;
+	double A=quad_gk(rootx,NULL,x1,x2,tol,&st);
+	if(nfev) *nfev=st.nfev;
+	return A;
+}
 
 double integrated(double x1,double x2){
 	int N=300000; //Number of iterations
-	double h=(x2-x1)/N, A=0.0,x=1.0;
-	for(int i=0;i<N;i++){
-		A+=(( sqrt(x+h) + sqrt(x) )/2)*h; //trapezoidal rule
-		x+=h; //increment of x
-	}
+	return quad_trapezoid(rootx,NULL,x1,x2,N); //trapezoidal rule
+}
+
+//Area under any y=f(x) given as a string, e.g. "sqrt(x)", by batched Gauss-Kronrod
+//Returns NAN if f does not compile
+double integratedexpr(const char *f,double x1,double x2,double tol,int *nfev){
+	expr e;
+	quadstats st;
+	if(expr_compile(&e,f,"x")!=0) return NAN;
+	double A=quad_gk_batch(expr_batchintegrand,&e,x1,x2,tol,&st);
+	if(nfev) *nfev=st.nfev;
 	return A;
 }
+
+//Indicator of the unit ball, in the form taken by the QMC engine
+void inball(const double *x,double *y,int n,int dim,void *ctx){
+	(void)ctx;
+	for(int i=0;i<n;i++){
+		double r=0;
+		for(int d=0;d<dim;d++) r+=x[i*dim+d]*x[i*dim+d];
+		y[i]=r<=1;
+	}
+}
+
+//Volume of the unit ball in dim<=QMC_MAXDIM dimensions by scrambled Sobol points on [-1,1]^dim,
+//reps replicates of n points; err receives the standard error, NAN on bad arguments
+double volumeqmc(int dim,long n,int reps,unsigned long long seed,double *err){
+	double lo[QMC_MAXDIM],hi[QMC_MAXDIM];
+	qmcstats st={0,NAN,0};
+	for(int d=0;d<dim&&d<QMC_MAXDIM;d++){
+		lo[d]=-1;
+		hi[d]=1;
+	}
+	double V=qmc_integrate(inball,NULL,dim,lo,hi,n,reps,seed,0,&st);
+	if(err) *err=st.err;
+	return V;
+}
@@ -1,27 +1,113 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <math.h>
+#include "../../lib/dual.h"
+#include "../../lib/rk45.h"
+#include "../../lib/bdf.h"
+#include "../../lib/euler.h"
+#include "../../lib/expr.h"
+#include "../../lib/npysink.h"
+#include "../../lib/arena.h"
 // Define a structure to hold coordinates (x, y)
 typedef struct coords{
 	float x,y;
 }coords;
 
+// Function to compute the derivative dy/dx along with its partial derivative wrt y
+dual ffy(double y, double x){
+	return dconst(-cos(3*x)/3+sin(3*x)/3);
+}
+
 // Function to compute the derivative dy/dx based on the given equation
 float ffx(float y, float x){
-	return -cos(3*x)/3+sin(3*x)/3;
+	return ffy(y,x).v;
+}
+
+// Float right hand side in the form taken by the Euler kernel
+float rhsf(float x, float y, void *ctx){
+	(void)ctx;
+	return ffx(y,x);
+}
+
+// Function to compute the values of (x, y) using the Euler method into caller buffers
+// x_i goes to xs[i*xstride] and y_i to ys[i*ystride] for i<n, nothing is allocated
+int fxbuf(float yn,float x,float *xs,long xstride,float *ys,long ystride,int n){
+	return euler_f(rhsf,NULL,x,yn,0.001f,xs,xstride,ys,ystride,n);
 }
 
 // Function to compute the values of (x, y) using the Euler method
 coords* fx(float yn,float x){
-	float h=0.001;
 	coords * f;
 	f=(coords*)malloc(10000*sizeof(coords));
-	// Initialize the first coordinates with the given initial values
-	f[0].y=yn;
-	f[0].x=x;
-	for(int i=1;i<10000;i++){
-		f[i].y=f[i-1].y+h*ffx(f[i-1].y,f[i-1].x); //y_(n+1)=y_n+h*ffx(y_n,x_n)
-		f[i].x=f[i-1].x+h; //x_(n+1)=x_n+h
-	}
+	fxbuf(yn,x,&f[0].x,2,&f[0].y,2,10000); //x and y interleave, so each has a stride of 2
+	return f;
+}
+
+// The same 10000 points taken from a instead of the heap, NULL if a is too small or in query mode
+coords* fxarena(float yn,float x,arena *a){
+	coords *f=ARENA_NEW(a,coords,10000);
+	if(!f) return NULL;
+	fxbuf(yn,x,&f[0].x,2,&f[0].y,2,10000);
 	return f;
 }
+
+// Right hand side in the form taken by the adaptive integrator
+double rhs(double x, double y, void *ctx){
+	(void)ctx;
+	return ffy(y,x).v;
+}
+
+// Function to stream n Euler points (x, y) into the .npy file at path instead of memory
+// euler() writes straight into the sink's buffers, each buffer continues one step past the last row
+// Returns 0, or -1 if the file could not be written; read it with np.load(path, mmap_mode="r")
+int fxnpy(double yn,double x,long n,const char *path){
+	npysink s;
+	double h=0.001;
+	if(npysink_open(&s,path,"<f8",2,1)!=0) return -1;
+	for(long done=0;done<n;){
+		long m=n-done;
+		double *row=(double*)npysink_reserve(&s,&m);
+		if(done>0){
+			yn+=h*rhs(x,yn,NULL); // y_(n+1)=y_n+h*f(x_n,y_n)
+			x+=h;
+		}
+		euler(rhs,NULL,x,yn,h,row,2,row+1,2,(int)m);
+		x=row[2*(m-1)];
+		yn=row[2*(m-1)+1];
+		npysink_commit(&s,m);
+		done+=m;
+	}
+	return npysink_close(&s);
+}
+
+// Function to compute y at the caller's grid points xs[0..n-1] with adaptive RK45
+// ys must hold n values, returns 0 on success
+int fxrk(double yn,double x,const double *xs,double *ys,int n){
+	return rk45(rhs,NULL,x,yn,xs,ys,n,NULL,NULL);
+}
+
+// Right hand side and its derivative wrt y in the form taken by the stiff integrator
+void rhssys(double x, const double *y, double *dy, int n, void *ctx){
+	(void)n;
+	(void)ctx;
+	dy[0]=ffy(y[0],x).v;
+}
+void rhsjac(double x, const double *y, double *J, int n, void *ctx){
+	(void)n;
+	(void)ctx;
+	J[0]=ffy(y[0],x).d;
+}
+
+// The same as fxrk() with the implicit BDF integrator, for stiff right hand sides
+int fxbdf(double yn,double x,const double *xs,double *ys,int n){
+	double work[BDF_WORK(1)];
+	return bdf(rhssys,rhsjac,NULL,1,x,&yn,xs,ys,n,NULL,work,NULL);
+}
+
+// The same for a right hand side in x and y given as a string, e.g. "-cos(3*x)/3+sin(3*x)/3"
+// Returns -1 if rhs does not compile
+int fxrkexpr(const char *rhs,double yn,double x,const double *xs,double *ys,int n){
+	expr e;
+	if(expr_compile(&e,rhs,"x,y")!=0) return -1;
+	return rk45(expr_odefunc,&e,x,yn,xs,ys,n,NULL,NULL);
+}
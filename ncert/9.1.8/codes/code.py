@@ -1,19 +1,17 @@
 # Import necessary libraries
 import numpy as np
 import matplotlib.pyplot as plt
-from ctypes import CDLL, Structure, POINTER, c_float, byref
-
-
-# Define the structure matching the C struct
-class Coords(Structure):
-    _fields_ = [("x", c_float), ("y", c_float)]
+import sys
+from ctypes import CDLL, c_float, c_int, c_long, c_void_p
+sys.path.insert(0, "../../lib")
+from npbuf import ptr, stride  # zero-copy ndarray pointers
 
 # Load the shared library
 lib = CDLL("./func.so")
 
-# Declare the return type and argument types for fx
-lib.fx.restype = POINTER(Coords)  # Pointer to Coords array
-lib.fx.argtypes = [c_float, c_float]  # float, float
+# Declare the return type and argument types for fxbuf
+lib.fxbuf.restype = c_int
+lib.fxbuf.argtypes = [c_float, c_float, c_void_p, c_long, c_void_p, c_long, c_int]  # yn, x, xs, xstride, ys, ystride, n
 
 # Define initial conditions
 yn = 0.5  # Initial value for yn
@@ -27,10 +25,10 @@ X = np.linspace(0, 2, 2000)
 Y = (np.exp(X)/2)
 plt.plot(X, Y, label="theory", color='red')
 
-# Call fx
-results = lib.fx(c_float(yn), c_float(x))
-xvals = np.array([results[i].x for i in range(2000)]) #Extracting Values
-yvals = np.array([results[i].y for i in range(2000)])
+# Call fxbuf, the trajectory is written straight into the arrays
+xvals = np.empty(2000, dtype=np.float32)
+yvals = np.empty(2000, dtype=np.float32)
+lib.fxbuf(yn, x, ptr(xvals, np.float32), stride(xvals), ptr(yvals, np.float32), stride(yvals), 2000)
 plt.plot(xvals, yvals,linestyle=':',label='sim',color='black')
 
 
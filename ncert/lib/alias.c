@@ -0,0 +1,268 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "alias.h"
+#include "mc.h"
+
+//Samples per Philox stream, the unit of work handed to threads
+#define CHUNK 65536
+
+int alias_build(alias *a,const double *pmf,int k,double *q,int *work){
+	double sum=0;
+	for(int i=0;i<k;i++){
+		if(pmf[i]<0) return -1;
+		sum+=pmf[i];
+	}
+	if(!(sum>0)) return -1;
+	//Vose: small columns fill from the front of work, large ones from the back
+	int ns=0,nl=k;
+	for(int i=0;i<k;i++){
+		q[i]=pmf[i]*k/sum;
+		if(q[i]<1) work[ns++]=i;
+		else work[--nl]=i;
+	}
+	a->k=k;
+	while(ns>0&&nl<k){
+		int s=work[--ns],l=work[nl++];
+		a->thr[s]=(uint64_t)(q[s]*4294967296.0);
+		a->alias[s]=l;
+		q[l]+=q[s]-1;
+		if(q[l]<1) work[ns++]=l;
+		else work[--nl]=l;
+	}
+	//Leftovers are 1 up to rounding
+	while(ns>0){
+		int s=work[--ns];
+		a->thr[s]=4294967296ull;
+		a->alias[s]=s;
+	}
+	while(nl<k){
+		int l=work[nl++];
+		a->thr[l]=4294967296ull;
+		a->alias[l]=l;
+	}
+	return 0;
+}
+
+//Inversion by sequential search from 0, used when n*p is small
+static long binomial_inv(rng *r,long n,double p){
+	double q=1-p,qn=exp(n*log(q)),np=n*p;
+	double bound=fmin(n,np+10*sqrt(np*q+1));
+	long x=0;
+	double px=qn,u=rng_double(r);
+	while(u>px){
+		x++;
+		if(x>bound){
+			x=0;
+			px=qn;
+			u=rng_double(r);
+		}
+		else{
+			u-=px;
+			px=((n-x+1)*p*px)/(x*q);
+		}
+	}
+	return x;
+}
+
+//BTPE: triangle, parallelogram and exponential tails over the binomial, p<=1/2
+static long binomial_btpe(rng *r,long n,double p){
+	double q=1-p,fm=n*p+p,nrq=n*p*q;
+	long m=(long)floor(fm),y,k;
+	double p1=floor(2.195*sqrt(nrq)-4.6*q)+0.5;
+	double xm=m+0.5,xl=xm-p1,xr=xm+p1;
+	double c=0.134+20.5/(15.3+m);
+	double a=(fm-xl)/(fm-xl*p),laml=a*(1+a/2);
+	a=(xr-fm)/(xr*q);
+	double lamr=a*(1+a/2);
+	double p2=p1*(1+2*c),p3=p2+c/laml,p4=p3+c/lamr;
+	for(;;){
+		double u=rng_double(r)*p4,v=rng_double(r),x;
+		if(u<=p1){
+			//Triangular region, accepted immediately
+			return (long)floor(xm-p1*v+u);
+		}
+		if(u<=p2){
+			x=xl+(u-p1)/c;
+			v=v*c+1-fabs(m-x+0.5)/p1;
+			if(v>1) continue;
+			y=(long)floor(x);
+		}
+		else if(u<=p3){
+			y=(long)floor(xl+log(v)/laml);
+			if(y<0) continue;
+			v=v*(u-p2)*laml;
+		}
+		else{
+			y=(long)floor(xr-log(v)/lamr);
+			if(y>n) continue;
+			v=v*(u-p3)*lamr;
+		}
+		k=labs(y-m);
+		if(k<=20||k>=nrq/2-1){
+			//Explicit evaluation of f(y)/f(m) by recursion
+			double s=p/q,aa=s*(n+1),F=1;
+			if(m<y) for(long i=m+1;i<=y;i++) F*=(aa/i-s);
+			else if(m>y) for(long i=y+1;i<=m;i++) F/=(aa/i-s);
+			if(v<=F) return y;
+			continue;
+		}
+		//Squeeze using upper and lower bounds on log(f(y))
+		double rho=(k/nrq)*((k*(k/3.0+0.625)+0.16666666666666666)/nrq+0.5);
+		double t=-(double)k*k/(2*nrq),A=log(v);
+		if(A<t-rho) return y;
+		if(A>t+rho) continue;
+		//Final acceptance with Stirling's formula
+		double x1=y+1,f1=m+1,z=n+1-m,w=n-y+1;
+		double x2=x1*x1,f2=f1*f1,z2=z*z,w2=w*w;
+		double bound=xm*log(f1/x1)+(n-m+0.5)*log(z/w)+(y-m)*log(w*p/(x1*q))
+			+(13680.-(462.-(132.-(99.-140./f2)/f2)/f2)/f2)/f1/166320.
+			+(13680.-(462.-(132.-(99.-140./z2)/z2)/z2)/z2)/z/166320.
+			+(13680.-(462.-(132.-(99.-140./x2)/x2)/x2)/x2)/x1/166320.
+			+(13680.-(462.-(132.-(99.-140./w2)/w2)/w2)/w2)/w/166320.;
+		if(A<=bound) return y;
+	}
+}
+
+long binomial_draw(rng *r,long n,double p){
+	if(n<=0||p<=0) return 0;
+	if(p>=1) return n;
+	//Sample the smaller tail and reflect
+	double pp=p>0.5?1-p:p;
+	long y=n*pp<30?binomial_inv(r,n,pp):binomial_btpe(r,n,pp);
+	return p>0.5?n-y:y;
+}
+
+long poisson_draw(rng *r,double lambda){
+	if(lambda<=0) return 0;
+	if(lambda<10){
+		//Multiply uniforms until the product drops below e^-lambda
+		double enlam=exp(-lambda),prod=1;
+		long x=0;
+		for(;;){
+			prod*=rng_double(r);
+			if(prod>enlam) x++;
+			else return x;
+		}
+	}
+	//PTRS: transformed rejection with squeeze
+	double slam=sqrt(lambda),loglam=log(lambda);
+	double b=0.931+2.53*slam,a=-0.059+0.02483*b;
+	double invalpha=1.1239+1.1328/(b-3.4),vr=0.9277-3.6224/(b-2);
+	for(;;){
+		double u=rng_double(r)-0.5,v=rng_double(r),us=0.5-fabs(u);
+		long k=(long)floor((2*a/us+b)*u+lambda+0.43);
+		if(us>=0.07&&v<=vr) return k;
+		if(k<0||(us<0.013&&v>us)) continue;
+		if(log(v)+log(invalpha)-log(a/(us*us)+b)<=-lambda+k*loglam-lgamma(k+1)) return k;
+	}
+}
+
+//What a worker samples, one of the three distributions
+typedef struct source{
+	const alias *a;
+	long n;
+	double p,lambda;
+	int kind;	//0 alias, 1 binomial, 2 poisson
+}source;
+
+static long draw(const source *s,rng *r){
+	switch(s->kind){
+		case 0: return alias_draw(s->a,r);
+		case 1: return binomial_draw(r,s->n,s->p);
+		default: return poisson_draw(r,s->lambda);
+	}
+}
+
+//Chunks c0..c1-1 counted into a private histogram
+typedef struct job{
+	const source *src;
+	uint64_t c0,c1,nsamples,seed;
+	uint64_t *h;
+	int k;
+}job;
+
+static void *run(void *arg){
+	job *j=(job*)arg;
+	for(uint64_t c=j->c0;c<j->c1;c++){
+		rng r;
+		rng_init(&r,j->seed,c);
+		uint64_t m=j->nsamples-c*CHUNK<CHUNK?j->nsamples-c*CHUNK:CHUNK;
+		for(uint64_t i=0;i<m;i++){
+			long x=draw(j->src,&r);
+			j->h[x<j->k?x:j->k-1]++;
+		}
+	}
+	return NULL;
+}
+
+static int hist(const source *src,int k,uint64_t nsamples,uint64_t seed,int nthreads,double *out){
+	uint64_t nchunks=(nsamples+CHUNK-1)/CHUNK;
+	if(nthreads<=0) nthreads=mc_ncpu();
+	if(nthreads>MC_MAXTHREADS) nthreads=MC_MAXTHREADS;
+	if((uint64_t)nthreads>nchunks) nthreads=nchunks>0?(int)nchunks:1;
+	uint64_t *h=(uint64_t*)calloc((size_t)k*nthreads,sizeof(uint64_t));
+	if(!h) return -1;
+	job jobs[MC_MAXTHREADS];
+	for(int t=0;t<nthreads;t++){
+		job j={src,nchunks*t/nthreads,nchunks*(t+1)/nthreads,nsamples,seed,h+(size_t)k*t,k};
+		jobs[t]=j;
+	}
+	parallel_for(nthreads,run,jobs,sizeof(job));
+	//Merge the private histograms bin by bin
+	for(int i=0;i<k;i++){
+		uint64_t c=0;
+		for(int t=0;t<nthreads;t++) c+=h[(size_t)k*t+i];
+		out[i]=nsamples?(double)c/nsamples:0;
+	}
+	free(h);
+	return 0;
+}
+
+//Draws chunk by chunk straight into the sink's buffers, the writer thread saves the previous one meanwhile
+static int stream(const source *src,uint64_t nsamples,uint64_t seed,npysink *s){
+	if(s->ncols!=1||strcmp(s->descr,"<i8")!=0) return -1;
+	for(uint64_t c=0;c*CHUNK<nsamples;c++){
+		rng r;
+		rng_init(&r,seed,c);
+		uint64_t m=nsamples-c*CHUNK<CHUNK?nsamples-c*CHUNK:CHUNK;
+		while(m>0){
+			long k=(long)m;
+			int64_t *d=(int64_t*)npysink_reserve(s,&k);
+			for(long i=0;i<k;i++) d[i]=draw(src,&r);
+			npysink_commit(s,k);
+			m-=k;
+		}
+	}
+	return s->err?-1:0;
+}
+
+int alias_hist(const alias *a,uint64_t nsamples,uint64_t seed,int nthreads,double *out){
+	source s={a,0,0,0,0};
+	return hist(&s,a->k,nsamples,seed,nthreads,out);
+}
+
+int binomial_hist(long n,double p,uint64_t nsamples,uint64_t seed,int nthreads,double *out){
+	source s={NULL,n,p,0,1};
+	return hist(&s,(int)(n+1),nsamples,seed,nthreads,out);
+}
+
+int poisson_hist(double lambda,int kmax,uint64_t nsamples,uint64_t seed,int nthreads,double *out){
+	source s={NULL,0,0,lambda,2};
+	return hist(&s,kmax,nsamples,seed,nthreads,out);
+}
+
+int alias_stream(const alias *a,uint64_t nsamples,uint64_t seed,npysink *s){
+	source src={a,0,0,0,0};
+	return stream(&src,nsamples,seed,s);
+}
+
+int binomial_stream(long n,double p,uint64_t nsamples,uint64_t seed,npysink *s){
+	source src={NULL,n,p,0,1};
+	return stream(&src,nsamples,seed,s);
+}
+
+int poisson_stream(double lambda,uint64_t nsamples,uint64_t seed,npysink *s){
+	source src={NULL,0,0,lambda,2};
+	return stream(&src,nsamples,seed,s);
+}
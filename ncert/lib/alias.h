@@ -0,0 +1,48 @@
+#ifndef ALIAS_H
+#define ALIAS_H
+#include <stdint.h>
+#include "rng.h"
+#include "npysink.h"
+//Discrete distribution sampling for empirical PMFs of multinomial, binomial and Poisson experiments
+
+//Walker/Vose alias table over k outcomes, arrays are owned by the caller
+typedef struct alias{
+	int k;
+	uint64_t *thr;	//accept column i when the 32-bit draw is below thr[i]
+	int *alias;	//otherwise take this outcome
+}alias;
+
+//Builds the table from pmf[0..k-1] (need not be normalised), q[k] and work[k] are scratch
+//Returns 0, or -1 if the weights are negative or sum to zero
+int alias_build(alias *a,const double *pmf,int k,double *q,int *work);
+
+//O(1) draw: one 32-bit word picks the column, a second one decides the coin flip
+static inline int alias_draw(const alias *a,rng *r){
+	uint32_t u=rng_u32(r),v=rng_u32(r);
+	int i=(int)(((uint64_t)u*a->k)>>32);
+	return v<a->thr[i]?i:a->alias[i];
+}
+
+//Binomial(n,p) variate, inversion for small n*p and BTPE rejection (Kachitvichyanukul & Schmeiser) otherwise
+long binomial_draw(rng *r,long n,double p);
+//Poisson(lambda) variate, inversion for small lambda and PTRS rejection (Hormann) otherwise
+long poisson_draw(rng *r,double lambda);
+
+//Fills hist[0..k-1] with the empirical PMF of nsamples draws from the alias table
+//Each thread counts into its own histogram and they are summed once at the end
+//Samples come in fixed chunks with one Philox stream each, so the result depends only on the seed
+//nthreads<=0 uses every CPU
+//Returns 0, or -1 if the per-thread histograms could not be allocated
+int alias_hist(const alias *a,uint64_t nsamples,uint64_t seed,int nthreads,double *hist);
+
+//Empirical PMFs of nsamples binomial(n,p) draws into hist[0..n] and Poisson(lambda) draws into hist[0..kmax-1]
+//Poisson outcomes >= kmax are counted in the last bin
+int binomial_hist(long n,double p,uint64_t nsamples,uint64_t seed,int nthreads,double *hist);
+int poisson_hist(double lambda,int kmax,uint64_t nsamples,uint64_t seed,int nthreads,double *hist);
+
+//The raw draws behind the histograms above, streamed into s (one "<i8" column) chunk by chunk
+//The same seed gives the same draws as the _hist functions; returns 0 or -1 after a write error
+int alias_stream(const alias *a,uint64_t nsamples,uint64_t seed,npysink *s);
+int binomial_stream(long n,double p,uint64_t nsamples,uint64_t seed,npysink *s);
+int poisson_stream(double lambda,uint64_t nsamples,uint64_t seed,npysink *s);
+#endif
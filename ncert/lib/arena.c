@@ -0,0 +1,40 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include "arena.h"
+
+void arena_query(arena *a){
+	arena_init(a,NULL,0);
+}
+
+void arena_init(arena *a,void *buf,size_t size){
+	size_t pad=buf?(ARENA_ALIGN-(uintptr_t)buf%ARENA_ALIGN)%ARENA_ALIGN:0;
+	a->base=buf?(char*)buf+(pad<size?pad:size):NULL;
+	a->size=pad<size?size-pad:0;
+	a->used=0;
+	a->peak=0;
+	a->nalloc=0;
+	a->owned=0;
+}
+
+int arena_create(arena *a,size_t size){
+	size=(size+ARENA_ALIGN-1)/ARENA_ALIGN*ARENA_ALIGN;
+	void *buf=aligned_alloc(ARENA_ALIGN,size?size:ARENA_ALIGN);
+	arena_init(a,buf,buf?size:0);
+	a->owned=buf!=NULL;
+	return buf?0:-1;
+}
+
+void arena_destroy(arena *a){
+	if(a->owned) free(a->base);
+	arena_init(a,NULL,0);
+}
+
+void *arena_alloc(arena *a,size_t n){
+	//Offsets are aligned rather than addresses, base itself is aligned
+	size_t at=(a->used+ARENA_ALIGN-1)/ARENA_ALIGN*ARENA_ALIGN;
+	a->used=at+n;
+	if(a->used>a->peak) a->peak=a->used;
+	a->nalloc++;
+	if(!a->base||a->used>a->size) return NULL;
+	return a->base+at;
+}
@@ -0,0 +1,45 @@
+#ifndef ARENA_H
+#define ARENA_H
+#include <stddef.h>
+//Bump allocator for kernel workspaces: created once and reset between calls, so a kernel called in a
+//hot loop does no heap work. Any kernel taking a caller work buffer can be fed with
+//ARENA_NEW(a,double,LBFGS_WORK(n,m)) and the like
+//An arena without a buffer is in query mode: every allocation returns NULL but is still counted,
+//so running a kernel on it leaves the bytes that kernel needs in peak
+
+//Alignment of every allocation, one cache line
+#define ARENA_ALIGN 64
+
+typedef struct arena{
+	char *base;		//NULL in query mode
+	size_t size;		//bytes at base
+	size_t used;		//bytes handed out, including alignment padding
+	size_t peak;		//largest used since the arena was set up, the size a kernel needs
+	long nalloc;		//allocations requested
+	int owned;		//base came from arena_create
+}arena;
+
+//Query mode, sizes only
+void arena_query(arena *a);
+//Over the caller's buffer; a misaligned buf loses its first bytes to alignment
+void arena_init(arena *a,void *buf,size_t size);
+//Over one heap buffer of size bytes, the only allocation the arena makes; returns -1 if it fails
+int arena_create(arena *a,size_t size);
+void arena_destroy(arena *a);
+
+//n bytes aligned to ARENA_ALIGN, NULL in query mode or when the arena is full; used and peak
+//advance either way, so a run that failed still reports the size it needed
+void *arena_alloc(arena *a,size_t n);
+#define ARENA_NEW(a,T,n) ((T*)arena_alloc(a,(size_t)(n)*sizeof(T)))
+
+//Scratch allocated after a mark is released by going back to it; arena_reset releases everything
+static inline size_t arena_mark(const arena *a){
+	return a->used;
+}
+static inline void arena_release(arena *a,size_t mark){
+	a->used=mark;
+}
+static inline void arena_reset(arena *a){
+	a->used=0;
+}
+#endif
@@ -0,0 +1,184 @@
+#include <string.h>
+#include "band.h"
+#include "cpu.h"
+#include "mc.h"
+
+//In place elimination, row i of the band only meets rows i-kl..i+ku so nothing fills in
+HOT int factor(double *lu,long ld,long n,int kl,int ku){
+	for(long k=0;k<n;k++){
+		double p=lu[BAND_AT(ld,kl,k,k)];
+		if(p==0){
+			return k<n-1?-1:0;
+		}
+		long ilast=k+kl<n-1?k+kl:n-1,jlast=k+ku<n-1?k+ku:n-1;
+		const double *uk=lu+BAND_AT(ld,kl,k,k);
+		for(long i=k+1;i<=ilast;i++){
+			double *ui=lu+BAND_AT(ld,kl,i,k);
+			double l=ui[0]/p;
+			ui[0]=l;
+			//Row i from column k+1 against row k of U, contiguous in both
+			for(long j=1;j<=jlast-k;j++){
+				ui[j]-=l*uk[j];
+			}
+		}
+	}
+	return 0;
+}
+ISA_CLONES(int,factor,(double *lu,long ld,long n,int kl,int ku),(lu,ld,n,kl,ku))
+
+int band_decompose(const double *ab,long ldab,double *lu,long ldlu,long n,int kl,int ku){
+	if(lu!=ab){
+		for(long i=0;i<n;i++){
+			memcpy(lu+i*ldlu,ab+i*ldab,(kl+ku+1)*sizeof(double));
+		}
+	}
+	return ISA_CALL(factor)(lu,ldlu,n,kl,ku);
+}
+
+void band_subst(const double *lu,long ld,const double *b,double *x,long n,int kl,int ku){
+	//Forward substitution Ly=b, y is kept in x
+	for(long i=0;i<n;i++){
+		double s=b[i];
+		for(long k=i-kl>0?i-kl:0;k<i;k++){
+			s-=lu[BAND_AT(ld,kl,i,k)]*x[k];
+		}
+		x[i]=s;
+	}
+	//Back substitution Ux=y
+	for(long i=n-1;i>=0;i--){
+		double s=x[i];
+		long last=i+ku<n-1?i+ku:n-1;
+		for(long k=i+1;k<=last;k++){
+			s-=lu[BAND_AT(ld,kl,i,k)]*x[k];
+		}
+		x[i]=s/lu[BAND_AT(ld,kl,i,i)];
+	}
+}
+
+int band_solve(const double *ab,long ldab,const double *b,double *x,long n,int kl,int ku,double *lu){
+	long ld=kl+ku+1;
+	if(band_decompose(ab,ldab,lu,ld,n,kl,ku)!=0||lu[BAND_AT(ld,kl,n-1,n-1)]==0){
+		return -1;
+	}
+	band_subst(lu,ld,b,x,n,kl,ku);
+	return 0;
+}
+
+int tri_solve(const double *ab,long ldab,const double *b,double *x,long n,double *work){
+	double *c=work;	//super-diagonal of the unit upper factor
+	if(n<1) return 0;
+	double p=ab[1];
+	if(p==0) return -1;
+	x[0]=b[0]/p;
+	for(long i=1;i<n;i++){
+		const double *r=ab+i*ldab;
+		c[i-1]=ab[(i-1)*ldab+2]/p;
+		p=r[1]-r[0]*c[i-1];
+		if(p==0) return -1;
+		x[i]=(b[i]-r[0]*x[i-1])/p;
+	}
+	for(long i=n-2;i>=0;i--){
+		x[i]-=c[i]*x[i+1];
+	}
+	return 0;
+}
+
+//One thread's block of rows [lo,hi) in tri_solve_cr
+typedef struct block{
+	const double *ab,*b;
+	double *x,*be,*ga,*c;
+	long ldab,n,lo,hi;
+	double *red;	//its two rows of the reduced system, 4 doubles each: sub, diag, super, rhs
+	int err;
+}block;
+
+//Interior rows lo+1..hi-2 written as x[i]=al[i]+be[i]*x[lo]+ga[i]*x[hi-1] (al kept in x),
+//one Thomas sweep with three right hand sides, then the block's first and last rows
+//are rewritten over x[lo-1],x[lo],x[hi-1] and x[lo],x[hi-1],x[hi]
+static void *reduce(void *arg){
+	block *k=(block*)arg;
+	const double *ab=k->ab,*b=k->b;
+	double *al=k->x,*be=k->be,*ga=k->ga,*c=k->c,p=0;
+	long ld=k->ldab,lo=k->lo,hi=k->hi;
+	for(long i=lo+1;i<=hi-2;i++){
+		const double *r=ab+i*ld;
+		double a=i>lo+1?r[0]:0;
+		p=r[1]-a*(i>lo+1?c[i-1]:0);
+		if(p==0){
+			k->err=-1;
+			return NULL;
+		}
+		c[i]=i<hi-2?r[2]/p:0;
+		al[i]=(b[i]-(i>lo+1?a*al[i-1]:0))/p;
+		be[i]=(i>lo+1?-a*be[i-1]:-r[0])/p;
+		ga[i]=((i==hi-2?-r[2]:0)-(i>lo+1?a*ga[i-1]:0))/p;
+	}
+	for(long i=hi-3;i>=lo+1;i--){
+		al[i]-=c[i]*al[i+1];
+		be[i]-=c[i]*be[i+1];
+		ga[i]-=c[i]*ga[i+1];
+	}
+	const double *f=ab+lo*ld,*l=ab+(hi-1)*ld;
+	double *rf=k->red,*rl=k->red+4;
+	rf[0]=lo>0?f[0]:0;
+	rl[2]=hi<k->n?l[2]:0;
+	if(hi-lo>2){
+		rf[1]=f[1]+f[2]*be[lo+1];
+		rf[2]=f[2]*ga[lo+1];
+		rf[3]=b[lo]-f[2]*al[lo+1];
+		rl[0]=l[0]*be[hi-2];
+		rl[1]=l[1]+l[0]*ga[hi-2];
+		rl[3]=b[hi-1]-l[0]*al[hi-2];
+	}else{
+		rf[1]=f[1];
+		rf[2]=f[2];
+		rf[3]=b[lo];
+		rl[0]=l[0];
+		rl[1]=l[1];
+		rl[3]=b[hi-1];
+	}
+	k->err=0;
+	return NULL;
+}
+
+//x[lo] and x[hi-1] are known, fills in the interior
+static void *expand(void *arg){
+	block *k=(block*)arg;
+	double *x=k->x,x0=x[k->lo],x1=x[k->hi-1];
+	for(long i=k->lo+1;i<=k->hi-2;i++){
+		x[i]+=k->be[i]*x0+k->ga[i]*x1;
+	}
+	return NULL;
+}
+
+int tri_solve_cr(const double *ab,long ldab,const double *b,double *x,long n,double *work,int nthreads){
+	if(nthreads>MC_MAXTHREADS) nthreads=MC_MAXTHREADS;
+	if(nthreads>n/TRI_CHUNK) nthreads=(int)(n/TRI_CHUNK);
+	if(nthreads<=1){
+		return tri_solve(ab,ldab,b,x,n,work);
+	}
+	block blocks[MC_MAXTHREADS];
+	double red[MC_MAXTHREADS*8],rab[MC_MAXTHREADS*6],rb[MC_MAXTHREADS*2],rx[MC_MAXTHREADS*2],rw[MC_MAXTHREADS*2];
+	for(int t=0;t<nthreads;t++){
+		block k={ab,b,x,work,work+n,work+2*n,ldab,n,n*t/nthreads,n*(t+1)/nthreads,red+8*t,0};
+		blocks[t]=k;
+	}
+	parallel_for(nthreads,reduce,blocks,sizeof(block));
+	//Reduced system over x[lo],x[hi-1] of every block, in that order, is tridiagonal
+	for(int t=0;t<nthreads;t++){
+		if(blocks[t].err) return -1;
+		for(int r=0;r<2;r++){
+			memcpy(rab+3*(2*t+r),red+8*t+4*r,3*sizeof(double));
+			rb[2*t+r]=red[8*t+4*r+3];
+		}
+	}
+	if(tri_solve(rab,3,rb,rx,2*nthreads,rw)!=0){
+		return -1;
+	}
+	for(int t=0;t<nthreads;t++){
+		x[blocks[t].lo]=rx[2*t];
+		x[blocks[t].hi-1]=rx[2*t+1];
+	}
+	parallel_for(nthreads,expand,blocks,sizeof(block));
+	return 0;
+}
@@ -0,0 +1,37 @@
+#ifndef BAND_H
+#define BAND_H
+//Direct solvers for banded systems in O(n) time and memory, next to the dense LU in lu.h
+//Band storage is the row-major form of LAPACK's: row i of the band array holds row i of A
+//from column i-kl to i+ku, so A[i][j] is ab[i*ldab+j-i+kl] and ldab>=kl+ku+1
+//Cells outside the matrix (the top left and bottom right corners of ab) are never read
+//Like lu_decompose there is no pivoting, so A should be diagonally dominant or positive definite
+
+//Offset of A[i][j] in band storage
+#define BAND_AT(ldab,kl,i,j) ((long)(i)*(ldab)+(j)-(i)+(kl))
+
+//Band LU with kl sub- and ku super-diagonals, factors kept in band storage (L unit lower)
+//lu may be the same buffer as ab; returns -1 if a pivot other than the last one is zero
+int band_decompose(const double *ab,long ldab,double *lu,long ldlu,long n,int kl,int ku);
+
+//Forward and back substitution with factors from band_decompose, b and x may alias
+void band_subst(const double *lu,long ld,const double *b,double *x,long n,int kl,int ku);
+
+//Solve Ax=b for x, lu must hold n*(kl+ku+1) doubles of scratch; returns -1 if A is singular
+int band_solve(const double *ab,long ldab,const double *b,double *x,long n,int kl,int ku,double *lu);
+
+//Tridiagonal systems in band storage with kl=ku=1: ab[i*ldab] is A[i][i-1],
+//ab[i*ldab+1] the diagonal and ab[i*ldab+2] is A[i][i+1]
+
+//Thomas algorithm, work must hold n doubles, b and x may alias; returns -1 on a zero pivot
+int tri_solve(const double *ab,long ldab,const double *b,double *x,long n,double *work);
+
+//Rows per thread below which tri_solve_cr uses fewer threads
+#define TRI_CHUNK 32768
+
+//Partitioned cyclic reduction: each thread reduces a block of rows to the two equations
+//coupling its first and last unknowns, the 2*nthreads row reduced system is solved with
+//the Thomas algorithm and the blocks are then filled in in parallel
+//work must hold 3n doubles; nthreads<=1 or a short system falls back to tri_solve
+//About 2.5 times the arithmetic of tri_solve, so it wins from three or four threads on
+int tri_solve_cr(const double *ab,long ldab,const double *b,double *x,long n,double *work,int nthreads);
+#endif
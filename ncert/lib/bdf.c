@@ -0,0 +1,354 @@
+#include <math.h>
+#include <float.h>
+#include <string.h>
+#include "bdf.h"
+#include "lu.h"
+
+#define NEWTON_MAXITER 4
+#define MIN_FACTOR 0.2
+#define MAX_FACTOR 10.0
+
+//Klopfenstein-Shampine NDF coefficients, kappa[0] and kappa[5] zero give plain BDF at those orders
+static const double kappa[BDF_MAXORDER+1]={0,-0.1850,-1.0/9,-0.0823,-0.0415,0};
+
+bdfopts bdf_defaults(void){
+	bdfopts o={1e-6,1e-9,0,0,100000};
+	return o;
+}
+
+//Coefficients derived from kappa: gamma_k=sum 1/i, alpha_k=(1-kappa_k)gamma_k, error constants
+typedef struct coefs{
+	double gamma[BDF_MAXORDER+2],alpha[BDF_MAXORDER+2],err[BDF_MAXORDER+2];
+}coefs;
+
+static coefs makecoefs(void){
+	coefs c;
+	c.gamma[0]=0;
+	for(int k=1;k<=BDF_MAXORDER+1;k++) c.gamma[k]=c.gamma[k-1]+1.0/k;
+	for(int k=0;k<=BDF_MAXORDER+1;k++){
+		double kp=k<=BDF_MAXORDER?kappa[k]:0;
+		c.alpha[k]=(1-kp)*c.gamma[k];
+		c.err[k]=kp*c.gamma[k]+1.0/(k+1);
+	}
+	return c;
+}
+
+//Root mean square of x[i]/scale[i]
+static double rms(const double *x,const double *scale,int n){
+	double s=0;
+	for(int i=0;i<n;i++){
+		double t=x[i]/scale[i];
+		s+=t*t;
+	}
+	return sqrt(s/n);
+}
+
+//R[i][j]=prod_{l=1..i}(l-1-factor*j)/l, row 0 all ones
+static void computeR(int order,double factor,double *R){
+	int m=order+1;
+	for(int j=0;j<m;j++) R[j]=1;
+	for(int i=1;i<m;i++){
+		for(int j=0;j<m;j++){
+			R[i*m+j]=R[(i-1)*m+j]*(j==0?0:(i-1-factor*j)/i);
+		}
+	}
+}
+
+//Rescales the differences D[0..order] (row k at D+k*n) for a step size change by factor
+static void changeD(double *D,int n,int order,double factor){
+	double R[(BDF_MAXORDER+1)*(BDF_MAXORDER+1)],U[(BDF_MAXORDER+1)*(BDF_MAXORDER+1)];
+	double RU[(BDF_MAXORDER+1)*(BDF_MAXORDER+1)],t[BDF_MAXORDER+1];
+	int m=order+1;
+	computeR(order,factor,R);
+	computeR(order,1,U);
+	for(int i=0;i<m;i++){
+		for(int j=0;j<m;j++){
+			double s=0;
+			for(int k=0;k<m;k++) s+=R[i*m+k]*U[k*m+j];
+			RU[i*m+j]=s;
+		}
+	}
+	//D=RU'D, one component at a time
+	for(int c=0;c<n;c++){
+		for(int i=0;i<m;i++){
+			double s=0;
+			for(int k=0;k<m;k++) s+=RU[k*m+i]*D[k*n+c];
+			t[i]=s;
+		}
+		for(int i=0;i<m;i++) D[i*n+c]=t[i];
+	}
+}
+
+//Working state of one integration
+typedef struct bdfstate{
+	sysfunc f;
+	jacfunc jac;
+	void *ctx;
+	int n;
+	double *D,*J,*M,*LU;
+	double *ypred,*scale,*psi,*ynew,*d,*fv,*dy,*tmp;
+	bdfstats s;
+}bdfstate;
+
+//J at (x,y) from the callback or by forward differences, f0=f(x,y) computed here for the latter
+static void jacobian(bdfstate *b,double x,const double *y){
+	int n=b->n;
+	b->s.njev++;
+	if(b->jac){
+		b->jac(x,y,b->J,n,b->ctx);
+		return;
+	}
+	double *f0=b->fv,*yt=b->tmp,*f1=b->dy;
+	b->f(x,y,f0,n,b->ctx);
+	memcpy(yt,y,n*sizeof(double));
+	for(int j=0;j<n;j++){
+		double h=sqrt(DBL_EPSILON)*fmax(fabs(y[j]),1);
+		yt[j]=y[j]+h;
+		h=yt[j]-y[j];	//exactly representable step
+		b->f(x,yt,f1,n,b->ctx);
+		for(int i=0;i<n;i++) b->J[i*n+j]=(f1[i]-f0[i])/h;
+		yt[j]=y[j];
+	}
+	b->s.nfev+=n+1;
+}
+
+//LU of I-cJ, returns -1 if a pivot vanishes
+static int factor(bdfstate *b,double c){
+	int n=b->n;
+	for(int i=0;i<n;i++){
+		for(int j=0;j<n;j++) b->M[i*n+j]=(i==j)-c*b->J[i*n+j];
+	}
+	b->s.nlu++;
+	if(lu_decompose(b->M,n,b->LU,n,b->LU,n,n)!=0||b->LU[(long)n*n-1]==0) return -1;
+	return 0;
+}
+
+//Simplified Newton on y=ypred+d, c f(x,y)-psi-d=0; returns 1 if converged, iterations in *iters
+static int newton(bdfstate *b,double x,double c,double tol,int *iters){
+	int n=b->n,conv=0,k;
+	double old=0;
+	memcpy(b->ynew,b->ypred,n*sizeof(double));
+	memset(b->d,0,n*sizeof(double));
+	for(k=0;k<NEWTON_MAXITER;k++){
+		b->f(x,b->ynew,b->fv,n,b->ctx);
+		b->s.nfev++;
+		int finite=1;
+		for(int i=0;i<n;i++){
+			if(!isfinite(b->fv[i])) finite=0;
+			b->dy[i]=c*b->fv[i]-b->psi[i]-b->d[i];
+		}
+		if(!finite) break;
+		lu_subst(b->LU,n,b->dy,b->dy,n);
+		double norm=rms(b->dy,b->scale,n),rate=k>0?norm/old:0;
+		if(k>0&&(rate>=1||pow(rate,NEWTON_MAXITER-k)/(1-rate)*norm>tol)) break;
+		for(int i=0;i<n;i++){
+			b->ynew[i]+=b->dy[i];
+			b->d[i]+=b->dy[i];
+		}
+		if(norm==0||(k>0&&rate/(1-rate)*norm<tol)){
+			conv=1;
+			break;
+		}
+		old=norm;
+	}
+	*iters=k+1;
+	return conv;
+}
+
+//Value at xe of the interpolating polynomial through the last order+1 points, step h ending at x
+static void interpolate(const bdfstate *b,int order,double x,double h,double xe,double *y){
+	int n=b->n;
+	memcpy(y,b->D,n*sizeof(double));
+	double p=1;
+	for(int j=1;j<=order;j++){
+		p*=(xe-(x-h*(j-1)))/(h*j);
+		for(int i=0;i<n;i++) y[i]+=b->D[j*n+i]*p;
+	}
+}
+
+int bdf(sysfunc f,jacfunc jac,void *ctx,int n,double x0,const double *y0,const double *xout,double *yout,
+	int nout,const bdfopts *opt,double *work,bdfstats *st){
+	bdfopts o=bdf_defaults();
+	coefs c=makecoefs();
+	bdfstate b;
+	int k=0,ret=0;
+	if(opt){
+		if(opt->rtol>0) o.rtol=opt->rtol;
+		if(opt->atol>0) o.atol=opt->atol;
+		if(opt->h0>0) o.h0=opt->h0;
+		if(opt->hmax>0) o.hmax=opt->hmax;
+		if(opt->maxsteps>0) o.maxsteps=opt->maxsteps;
+	}
+	memset(&b.s,0,sizeof(b.s));
+	b.f=f;
+	b.jac=jac;
+	b.ctx=ctx;
+	b.n=n;
+	b.D=work;
+	b.J=b.D+(BDF_MAXORDER+3)*(long)n;
+	b.M=b.J+(long)n*n;
+	b.LU=b.M+(long)n*n;
+	b.ypred=b.LU+(long)n*n;
+	b.scale=b.ypred+n;
+	b.psi=b.scale+n;
+	b.ynew=b.psi+n;
+	b.d=b.ynew+n;
+	b.fv=b.d+n;
+	b.dy=b.fv+n;
+	b.tmp=b.dy+n;
+	//Only forward integration over a non-decreasing grid
+	for(int i=0;i<nout;i++){
+		if(xout[i]<(i?xout[i-1]:x0)){
+			if(st) *st=b.s;
+			return -1;
+		}
+	}
+	//Grid points at the starting point need no integration
+	while(k<nout&&xout[k]<=x0){
+		memcpy(yout+(long)k*n,y0,n*sizeof(double));
+		k++;
+	}
+	if(k==nout){
+		b.s.order=1;
+		if(st) *st=b.s;
+		return 0;
+	}
+	double xend=xout[nout-1],x=x0,*D=b.D;
+	memset(D,0,(BDF_MAXORDER+3)*(long)n*sizeof(double));
+	memcpy(D,y0,n*sizeof(double));
+	f(x,y0,D+n,n,ctx);
+	b.s.nfev++;
+	//Starting step from y, y' and a trial Euler step (Hairer, Norsett, Wanner)
+	double h=o.h0;
+	if(h<=0){
+		for(int i=0;i<n;i++) b.scale[i]=o.atol+o.rtol*fabs(y0[i]);
+		double d0=rms(y0,b.scale,n),d1=rms(D+n,b.scale,n);
+		double h0=d0<1e-5||d1<1e-5?1e-6:0.01*d0/d1;
+		if(h0>xend-x) h0=xend-x;
+		for(int i=0;i<n;i++) b.tmp[i]=y0[i]+h0*D[n+i];
+		f(x+h0,b.tmp,b.fv,n,ctx);
+		b.s.nfev++;
+		for(int i=0;i<n;i++) b.dy[i]=b.fv[i]-D[n+i];
+		double d2=rms(b.dy,b.scale,n)/h0,dm=fmax(d1,d2);
+		double h1=dm<=1e-15?fmax(1e-6,h0*1e-3):pow(0.01/dm,0.5);
+		h=fmin(100*h0,h1);
+	}
+	if(o.hmax>0&&h>o.hmax) h=o.hmax;
+	if(h>xend-x) h=xend-x;
+	for(int i=0;i<n;i++) D[n+i]*=h;	//D[1]=h y'
+	jacobian(&b,x,y0);
+	int order=1,equal=0,havelu=0,iters=0;
+	while(k<nout){
+		double hmin=10*(nextafter(fabs(x),INFINITY)-fabs(x)),err=0;
+		int accepted=0,current=0;
+		if(o.hmax>0&&h>o.hmax){
+			changeD(D,n,order,o.hmax/h);
+			h=o.hmax;
+			equal=0;
+			havelu=0;
+		}
+		while(!accepted){
+			if(b.s.accepted+b.s.rejected>=o.maxsteps||h<hmin){
+				ret=-1;
+				break;
+			}
+			double xn=x+h;
+			if(xn>xend){
+				changeD(D,n,order,(xend-x)/h);
+				xn=xend;
+				h=xend-x;
+				equal=0;
+				havelu=0;
+			}
+			for(int i=0;i<n;i++){
+				double s=0,p=0;
+				for(int j=0;j<=order;j++) s+=D[j*n+i];
+				for(int j=1;j<=order;j++) p+=D[j*n+i]*c.gamma[j];
+				b.ypred[i]=s;
+				b.psi[i]=p/c.alpha[order];
+				b.scale[i]=o.atol+o.rtol*fabs(s);
+			}
+			double cc=h/c.alpha[order],tol=fmax(10*DBL_EPSILON/o.rtol,fmin(0.03,sqrt(o.rtol)));
+			int conv=0;
+			for(;;){
+				if(!havelu) havelu=factor(&b,cc)==0;
+				conv=havelu&&newton(&b,xn,cc,tol,&iters);
+				if(conv||current) break;
+				//Newton failed with an old Jacobian, refresh it at the predicted point
+				jacobian(&b,xn,b.ypred);
+				havelu=0;
+				current=1;
+			}
+			if(!conv){
+				changeD(D,n,order,0.5);
+				h*=0.5;
+				equal=0;
+				havelu=0;
+				b.s.rejected++;
+				continue;
+			}
+			double safety=0.9*(2*NEWTON_MAXITER+1)/(2*NEWTON_MAXITER+iters);
+			for(int i=0;i<n;i++){
+				b.scale[i]=o.atol+o.rtol*fabs(b.ynew[i]);
+				b.tmp[i]=c.err[order]*b.d[i];
+			}
+			err=rms(b.tmp,b.scale,n);
+			if(err>1){
+				double fac=fmax(MIN_FACTOR,safety*pow(err,-1.0/(order+1)));
+				changeD(D,n,order,fac);
+				h*=fac;
+				equal=0;
+				b.s.rejected++;
+				//Convergence was fine, so the factorisation is kept for the smaller step
+				continue;
+			}
+			accepted=1;
+			b.s.accepted++;
+			equal++;
+			x=xn;
+			//D[order+2]=d-D[order+1], D[order+1]=d, then the lower differences accumulate
+			for(int i=0;i<n;i++){
+				D[(order+2)*n+i]=b.d[i]-D[(order+1)*n+i];
+				D[(order+1)*n+i]=b.d[i];
+			}
+			for(int j=order;j>=0;j--){
+				for(int i=0;i<n;i++) D[j*n+i]+=D[(j+1)*n+i];
+			}
+			//Order and step size for the next step once order+1 equal steps have been taken
+			if(equal>=order+1){
+				double em=INFINITY,ep=INFINITY;
+				if(order>1){
+					for(int i=0;i<n;i++) b.tmp[i]=c.err[order-1]*D[order*n+i];
+					em=rms(b.tmp,b.scale,n);
+				}
+				if(order<BDF_MAXORDER){
+					for(int i=0;i<n;i++) b.tmp[i]=c.err[order+1]*D[(order+2)*n+i];
+					ep=rms(b.tmp,b.scale,n);
+				}
+				double fm=em>0?pow(em,-1.0/order):INFINITY;
+				double f0=err>0?pow(err,-1.0/(order+1)):INFINITY;
+				double fp=ep>0?pow(ep,-1.0/(order+2)):INFINITY;
+				double best=f0;
+				int delta=0;
+				if(fm>best){ best=fm; delta=-1; }
+				if(fp>best){ best=fp; delta=1; }
+				order+=delta;
+				double fac=fmin(MAX_FACTOR,safety*best);
+				changeD(D,n,order,fac);
+				h*=fac;
+				equal=0;
+				havelu=0;
+			}
+		}
+		if(ret) break;
+		//Every grid point passed by this step, from the polynomial of the current differences
+		while(k<nout&&xout[k]<=x){
+			interpolate(&b,order,x,h,xout[k],yout+(long)k*n);
+			k++;
+		}
+		if(x>=xend) break;
+	}
+	b.s.order=order;
+	if(st) *st=b.s;
+	return ret;
+}
@@ -0,0 +1,45 @@
+#ifndef BDF_H
+#define BDF_H
+//Variable order (1-5), variable step BDF integrator for stiff systems y'=f(x,y), y in R^n
+//Backward differences in quasi-constant step form (Shampine and Reichelt, as in MATLAB's ode15s
+//and SciPy's BDF): each implicit step is solved by a simplified Newton iteration on (I-cJ),
+//factored with lu_decompose and reused across steps until Newton stops converging,
+//only then is the Jacobian re-evaluated
+
+//Right hand side dy[0..n-1]=f(x,y), ctx is passed through untouched
+typedef void (*sysfunc)(double x,const double *y,double *dy,int n,void *ctx);
+//Jacobian J[i*n+j]=df_i/dy_j at (x,y)
+typedef void (*jacfunc)(double x,const double *y,double *J,int n,void *ctx);
+
+#define BDF_MAXORDER 5
+
+//Tolerances and step limits, zero fields take the defaults from bdf_defaults()
+typedef struct bdfopts{
+	double rtol,atol;	//relative and absolute error tolerance
+	double h0;		//initial step, 0 picks one automatically
+	double hmax;		//largest allowed step, 0 means unlimited
+	int maxsteps;		//accepted+rejected step budget
+}bdfopts;
+
+//What the integrator did
+typedef struct bdfstats{
+	int accepted,rejected;
+	int nfev;		//right hand side evaluations, including those of finite difference Jacobians
+	int njev;		//Jacobians evaluated
+	int nlu;		//LU factorisations of I-cJ
+	int order;		//order in use at the end
+}bdfstats;
+
+bdfopts bdf_defaults(void);
+
+//Doubles of work for an n equation system
+#define BDF_WORK(n) (18L*(n)+3L*(n)*(n))
+
+//Integrates from (x0,y0[0..n-1]) and writes y at the nout increasing grid points xout[] into
+//yout[k*n..k*n+n-1], interpolating the backward differences between steps
+//jac may be NULL for a forward difference Jacobian (n extra evaluations of f each time)
+//Returns 0 on success, -1 if the step budget ran out or the step size underflowed, or straight
+//away (nothing written) if xout[0]<x0 or xout decreases anywhere
+int bdf(sysfunc f,jacfunc jac,void *ctx,int n,double x0,const double *y0,const double *xout,double *yout,
+	int nout,const bdfopts *opt,double *work,bdfstats *st);
+#endif
@@ -0,0 +1,322 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include "lu.h"
+#include "band.h"
+#include "sparse.h"
+#include "krylov.h"
+#include "eigen.h"
+#include "newton.h"
+#include "gd.h"
+#include "euler.h"
+#include "quad.h"
+#include "rk45.h"
+#include "mc.h"
+#include "rng.h"
+#include "cpu.h"
+//Reproducible microbenchmarks for every kernel in libncert, results as JSON on stdout
+//./bench [repeats] [kernel] > results.json
+//Each (kernel, size, threads) point gets one warm-up run and then repeats timed runs
+//The process is pinned to the first `threads` CPUs so runs do not migrate
+
+double now(){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC,&t);
+	return t.tv_sec+t.tv_nsec*1e-9;
+}
+
+//Inputs shared by the kernels, regenerated from a fixed seed for every size
+typedef struct state{
+	long n;
+	int threads;
+	double *a,*b,*c,*d;
+	double complex *z,*zw,*ze;
+	csr A;			//sparse kernels: 5-point Poisson matrix on an n x n grid
+	ilu0 M;
+	long *ptr,*diag;
+	int *col;
+	double *val,*lu,*dinv,*x,*rhs,*work;
+}state;
+
+static rng gen;
+
+//Diagonally dominant so that LU without pivoting is stable
+static void randmat(double *A,long n){
+	for(long i=0;i<n;i++){
+		for(long j=0;j<n;j++){
+			A[i*n+j]=rng_double(&gen)-0.5+(i==j?n:0);
+		}
+	}
+}
+
+static const double gdcoef[]={3,-8,12,-48,25};
+static dual gdpoly(double x,void *ctx){
+	(void)ctx;
+	return dhorner(gdcoef,5,x);
+}
+static dual quadratic(double x,void *ctx){
+	double c=*(double*)ctx;
+	dual r={x*x-c,2*x};
+	return r;
+}
+static double odeexp(double x,double y,void *ctx){
+	(void)ctx;
+	return exp(x)-y;
+}
+static double rootx(double x,void *ctx){
+	(void)ctx;
+	return sqrt(x);
+}
+
+//Each kernel runs once on the state and returns the work done in its unit
+static double k_lu(state *s){
+	lu_decompose(s->a,s->n,s->c,s->n,s->c,s->n,(int)s->n);
+	return 2.0*s->n*s->n*s->n/3;
+}
+static double k_solve(state *s){
+	lu_solve(s->a,s->n,s->b,s->d,(int)s->n,s->c);
+	return 2.0*s->n*s->n*s->n/3+2.0*s->n*s->n;
+}
+static double k_tridiag(state *s){
+	tri_solve(s->a,3,s->b,s->c,s->n,s->d);
+	return s->n;
+}
+static double k_tridiag_cr(state *s){
+	tri_solve_cr(s->a,3,s->b,s->c,s->n,s->d,s->threads);
+	return s->n;
+}
+//Pentadiagonal, kl=ku=2
+static double k_band(state *s){
+	band_solve(s->a,5,s->b,s->c,s->n,2,2,s->d);
+	return s->n;
+}
+static double k_spmv(state *s){
+	csr_spmv(&s->A,s->rhs,s->x);
+	return s->A.ptr[s->A.n];
+}
+//Iterations are capped so every size finishes, the unit is one preconditioned iteration
+#define BENCH_KRYLOV_ITER 200
+static double k_cg(state *s){
+	kstats st={0};
+	memset(s->x,0,s->A.n*sizeof(double));
+	cg(csr_matvec,&s->A,jacobi_apply,s->dinv,s->rhs,s->x,s->A.n,1e-10,BENCH_KRYLOV_ITER,s->work,&st);
+	return st.iterations;
+}
+static double k_gmres(state *s){
+	kstats st={0};
+	memset(s->x,0,s->A.n*sizeof(double));
+	gmres(csr_matvec,&s->A,ilu0_apply,&s->M,s->rhs,s->x,s->A.n,30,1e-10,BENCH_KRYLOV_ITER,s->work,&st);
+	return st.iterations;
+}
+static double k_eigen(state *s){
+	memcpy(s->zw,s->z,s->n*s->n*sizeof(double complex));
+	qr_eigen(s->zw,(int)s->n,s->ze,s->zw+s->n*s->n,10000,NULL);
+	return 1;
+}
+static double k_newton(state *s){
+	double r;
+	for(long i=0;i<s->n;i++){
+		double c=s->a[i];
+		newton_root(quadratic,&c,c,1e-12,100,&r,NULL);
+	}
+	return s->n;
+}
+static double k_gd(state *s){
+	gdpoint mn,mx;
+	for(long i=0;i<s->n;i++){
+		gd_scan(gdpoly,NULL,0,3,&mn,&mx,NULL);
+	}
+	return s->n;
+}
+static double k_euler(state *s){
+	euler(odeexp,NULL,0,0.5,2.0/s->n,s->a,1,s->b,1,(int)s->n);
+	return s->n;
+}
+static double k_rk45(state *s){
+	rk45(odeexp,NULL,0,0.5,s->a,s->b,(int)s->n,NULL,NULL);
+	return s->n;
+}
+static double k_trapezoid(state *s){
+	quad_trapezoid(rootx,NULL,1,4,(int)s->n);
+	return s->n+1;
+}
+static double k_gk(state *s){
+	quadstats st;
+	quad_gk(rootx,NULL,0,4,pow(10,-(double)s->n),&st);
+	return st.nfev;
+}
+static double k_bernoulli(state *s){
+	mc_bernoulli(1.0/12,s->n,12345,s->threads);
+	return s->n;
+}
+
+typedef struct kernel{
+	const char *name,*unit;
+	double (*run)(state*);
+	long sizes[4];
+	int threaded;
+}kernel;
+
+static const kernel kernels[]={
+	{"lu","flop",k_lu,{16,64,256,0},0},
+	{"solve","flop",k_solve,{16,64,256,0},0},
+	{"tridiag","unknown",k_tridiag,{1000,100000,10000000,0},0},
+	{"tridiag_cr","unknown",k_tridiag_cr,{1000,100000,10000000,0},1},
+	{"band","unknown",k_band,{1000,100000,10000000,0},0},
+	{"spmv","nonzero",k_spmv,{64,512,2048,0},1},	//sizes are grid sides, n^2 unknowns
+	{"cg","iteration",k_cg,{32,128,512,0},0},
+	{"gmres","iteration",k_gmres,{32,128,512,0},0},
+	{"qr_eigen","matrix",k_eigen,{4,16,48,0},0},
+	{"newton","root",k_newton,{100,1000,10000,0},0},
+	{"gd","scan",k_gd,{1,4,16,0},0},
+	{"euler","step",k_euler,{1000,100000,1000000,0},0},
+	{"rk45","point",k_rk45,{100,10000,1000000,0},0},
+	{"trapezoid","eval",k_trapezoid,{1000,100000,1000000,0},0},
+	{"gk","eval",k_gk,{6,10,14,0},0},	//size is -log10 of the tolerance
+	{"bernoulli","trial",k_bernoulli,{1000000,10000000,100000000,0},1},
+};
+
+//-laplacian on a k x k grid, plus a first order term c*du/dx that makes it nonsymmetric
+static void poisson(state *s,long k,double c){
+	long n=k*k,e=0;
+	s->ptr=(long*)malloc((n+1)*sizeof(long));
+	s->col=(int*)malloc(5*n*sizeof(int));
+	s->val=(double*)malloc(5*n*sizeof(double));
+	for(long i=0;i<k;i++){
+		for(long j=0;j<k;j++){
+			s->ptr[i*k+j]=e;
+			if(i>0){ s->col[e]=(int)((i-1)*k+j); s->val[e++]=-1-c; }
+			if(j>0){ s->col[e]=(int)(i*k+j-1); s->val[e++]=-1; }
+			s->col[e]=(int)(i*k+j); s->val[e++]=4;
+			if(j<k-1){ s->col[e]=(int)(i*k+j+1); s->val[e++]=-1; }
+			if(i<k-1){ s->col[e]=(int)((i+1)*k+j); s->val[e++]=-1+c; }
+		}
+	}
+	s->ptr[n]=e;
+	csr A={n,s->ptr,s->col,s->val,s->threads};
+	s->A=A;
+	s->x=(double*)malloc(n*sizeof(double));
+	s->rhs=(double*)malloc(n*sizeof(double));
+	s->work=(double*)malloc(GMRES_WORK(n,30)*sizeof(double));
+	s->dinv=(double*)malloc(n*sizeof(double));
+	s->lu=(double*)malloc(e*sizeof(double));
+	s->diag=(long*)malloc(n*sizeof(long));
+	for(long i=0;i<n;i++) s->rhs[i]=rng_double(&gen);
+	csr_jacobi(&s->A,s->dinv);
+	csr_ilu0(&s->A,s->lu,s->diag,&s->M);
+}
+
+static void setup(state *s,const kernel *k,long n,int threads){
+	long m=strcmp(k->name,"lu")==0||strcmp(k->name,"solve")==0?n*n:(n>16?n:16);
+	//Band kernels keep the matrix in a and the factors or work in d, width w per row
+	long w=strncmp(k->name,"tridiag",7)==0?3:strcmp(k->name,"band")==0?5:1;
+	rng_init(&gen,2024,0);
+	s->n=n;
+	s->threads=threads;
+	s->a=(double*)malloc(w*m*sizeof(double));
+	s->b=(double*)malloc(m*sizeof(double));
+	s->c=(double*)malloc(m*sizeof(double));
+	s->d=(double*)malloc(w*m*sizeof(double));
+	s->z=s->zw=s->ze=NULL;
+	s->ptr=s->diag=NULL;
+	s->col=NULL;
+	s->val=s->lu=s->dinv=s->x=s->rhs=s->work=NULL;
+	if(strcmp(k->name,"spmv")==0||strcmp(k->name,"cg")==0) poisson(s,n,0);
+	if(strcmp(k->name,"gmres")==0) poisson(s,n,0.6);
+	if(m==n*n) randmat(s->a,n);
+	for(long i=0;i<m;i++) s->b[i]=rng_double(&gen);
+	if(w>1){
+		for(long i=0;i<w*m;i++) s->a[i]=rng_double(&gen)-0.5+(i%w==w/2?w:0);
+	}
+	if(strcmp(k->name,"newton")==0){
+		for(long i=0;i<m;i++) s->a[i]=1+99*rng_double(&gen);
+	}
+	if(strcmp(k->name,"rk45")==0){
+		for(long i=0;i<n;i++) s->a[i]=2.0*i/n;
+	}
+	if(strcmp(k->name,"qr_eigen")==0){
+		s->z=(double complex*)malloc(n*n*sizeof(double complex));
+		s->zw=(double complex*)malloc((n*n+QR_WORK(n))*sizeof(double complex));
+		s->ze=(double complex*)malloc(n*sizeof(double complex));
+		for(long i=0;i<n*n;i++) s->z[i]=rng_double(&gen)-0.5;
+	}
+}
+
+static void teardown(state *s){
+	free(s->a);
+	free(s->b);
+	free(s->c);
+	free(s->d);
+	free(s->z);
+	free(s->zw);
+	free(s->ze);
+	free(s->ptr);
+	free(s->diag);
+	free(s->col);
+	free(s->val);
+	free(s->lu);
+	free(s->dinv);
+	free(s->x);
+	free(s->rhs);
+	free(s->work);
+}
+
+static void pin(int threads){
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for(int i=0;i<threads;i++) CPU_SET(i,&set);
+	sched_setaffinity(0,sizeof(set),&set);
+}
+
+static int cmp(const void *a,const void *b){
+	double x=*(const double*)a,y=*(const double*)b;
+	return (x>y)-(x<y);
+}
+
+int main(int argc,char **argv){
+	int reps=argc>1?atoi(argv[1]):11;
+	const char *only=argc>2?argv[2]:NULL;
+	int ncpu=mc_ncpu(),first=1;
+	if(reps<1) reps=1;
+	double *t=(double*)malloc(reps*sizeof(double));
+	printf("{\"cpus\": %d, \"isa\": \"%s\", \"repeats\": %d, \"results\": [",ncpu,cpu_isa_name(cpu_isa()),reps);
+	for(size_t ki=0;ki<sizeof(kernels)/sizeof(kernels[0]);ki++){
+		const kernel *k=&kernels[ki];
+		if(only&&strcmp(only,k->name)!=0) continue;
+		for(int si=0;si<4&&k->sizes[si];si++){
+			for(int th=1;;th=th*2<ncpu?th*2:ncpu){
+				state s;
+				double work=0;
+				setup(&s,k,k->sizes[si],th);
+				pin(th);
+				k->run(&s);	//warm-up
+				for(int r=0;r<reps;r++){
+					double t0=now();
+					work=k->run(&s);
+					t[r]=now()-t0;
+				}
+				teardown(&s);
+				double mean=0,var=0;
+				for(int r=0;r<reps;r++) mean+=t[r]/reps;
+				for(int r=0;r<reps;r++) var+=(t[r]-mean)*(t[r]-mean)/(reps>1?reps-1:1);
+				qsort(t,reps,sizeof(double),cmp);
+				double med=reps%2?t[reps/2]:(t[reps/2-1]+t[reps/2])/2;
+				double p95=t[(int)ceil(0.95*reps)-1];
+				printf("%s\n  {\"kernel\": \"%s\", \"n\": %ld, \"threads\": %d, \"median_s\": %.9g, \"p95_s\": %.9g, "
+					"\"mean_s\": %.9g, \"var_s2\": %.9g, \"throughput\": %.9g, \"unit\": \"%s/s\"}",
+					first?"":",",k->name,k->sizes[si],th,med,p95,mean,var,work/med,k->unit);
+				first=0;
+				fflush(stdout);
+				if(!k->threaded||th==ncpu) break;
+			}
+		}
+	}
+	printf("\n]}\n");
+	free(t);
+	return 0;
+}
@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <complex.h>
+#include <dlfcn.h>
+#include <time.h>
+#include "arena.h"
+//Heap allocations and latency per call of the kernels that return malloc'd results (QRAlgorithm and
+//newton of 10.4.1.2.3, the Euler fx of 9.1.8 and 9.1.5) against their arena versions, one arena sized
+//by a query run and reset before every call; run from this directory after build.sh
+//malloc is interposed to count the calls made from every library (glibc); ns/call is the median of
+//REPS timed loops of each version, alternating, and spread the range between the fastest and slowest
+//gcc -O3 -o bench_arena bench_arena.c -L. -lncert -Wl,-rpath,'$ORIGIN' -lm -lpthread -ldl
+
+#define REPS 5
+
+double now(){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC,&t);
+	return t.tv_sec+t.tv_nsec*1e-9;
+}
+
+extern void *__libc_malloc(size_t n);
+static long nmalloc;
+void *malloc(size_t n){
+	nmalloc++;
+	return __libc_malloc(n);
+}
+
+typedef struct matrix{
+	double complex mat[2][2];
+}matrix;
+typedef struct coords{
+	float x,y;
+}coords;
+
+//Kernel under test, old (malloc'd result freed after each call) or arena; returns nonzero on failure
+typedef struct kernel{
+	const char *name;
+	void *sym,*asym;
+	long calls;
+}kernel;
+
+static const matrix A={{{0,1},{273,-32}}};
+
+static int call(const kernel *k,arena *a){
+	void *r;
+	if(!a){
+		if(k->name[0]=='Q') r=((double complex*(*)(matrix))k->sym)(A);
+		else if(k->name[0]=='n') r=((double*(*)(void))k->sym)();
+		else r=((coords*(*)(float,float))k->sym)(0.5f,0);
+		int bad=r==NULL;
+		free(r);
+		return bad;
+	}
+	if(k->name[0]=='Q') r=((double complex*(*)(matrix,arena*))k->asym)(A,a);
+	else if(k->name[0]=='n') r=((double*(*)(arena*))k->asym)(a);
+	else r=((coords*(*)(float,float,arena*))k->asym)(0.5f,0,a);
+	return r==NULL;
+}
+
+//Timed loop of k->calls calls, arena reset before each when a is given; adds the mallocs made to *m
+static double timed(const kernel *k,arena *a,long *m,int *bad){
+	long m0=nmalloc;
+	double t=now();
+	for(long i=0;i<k->calls;i++){
+		if(a) arena_reset(a);
+		*bad|=call(k,a);
+	}
+	t=now()-t;
+	*m+=nmalloc-m0;
+	return t/k->calls*1e9;
+}
+
+static int cmp(const void *x,const void *y){
+	double a=*(const double*)x,b=*(const double*)y;
+	return (a>b)-(a<b);
+}
+
+static void run(kernel *k){
+	arena q,a;
+	double tm[REPS],ta[REPS];
+	long mm=0,ma=0;
+	int bad=0;
+	//Query run for the size, then one arena for every call
+	arena_query(&q);
+	call(k,&q);
+	if(arena_create(&a,q.peak)!=0) return;
+	//The two versions alternate so drift in the machine hits both alike
+	for(int r=0;r<REPS;r++){
+		tm[r]=timed(k,NULL,&mm,&bad);
+		ta[r]=timed(k,&a,&ma,&bad);
+	}
+	arena_destroy(&a);
+	qsort(tm,REPS,sizeof(double),cmp);
+	qsort(ta,REPS,sizeof(double),cmp);
+	printf("%-16s %-6s %8ld %11.3g %12.4g %12.4g %8s\n",k->name,"malloc",k->calls,(double)mm/(REPS*k->calls),tm[REPS/2],tm[REPS-1]-tm[0],"-");
+	printf("%-16s %-6s %8ld %11.3g %12.4g %12.4g %8zu%s\n",k->name,"arena",k->calls,(double)ma/(REPS*k->calls),ta[REPS/2],ta[REPS-1]-ta[0],q.peak,bad?"  failed":"");
+}
+
+int main(){
+	static const char *lib[]={"../10.4.1.2.3/codes/func.so","../9.1.8/codes/func.so","../9.1.5_Trapezoidal/codes/func.so"};
+	void *h[3];
+	for(int i=0;i<3;i++){
+		h[i]=dlopen(lib[i],RTLD_NOW|RTLD_LOCAL);
+		if(!h[i]){
+			fprintf(stderr,"%s\n",dlerror());
+			return 1;
+		}
+	}
+	kernel ks[]={
+		{"QRAlgorithm",dlsym(h[0],"QRAlgorithm"),dlsym(h[0],"QRAlgorithmarena"),1000000},
+		{"newton",dlsym(h[0],"newton"),dlsym(h[0],"newtonarena"),1000000},
+		{"fx 9.1.8",dlsym(h[1],"fx"),dlsym(h[1],"fxarena"),20000},
+		{"fx 9.1.5",dlsym(h[2],"fx"),dlsym(h[2],"fxarena"),5000}};
+	for(int i=0;i<4;i++){
+		if(!ks[i].sym||!ks[i].asym){
+			fprintf(stderr,"%s: %s\n",ks[i].name,dlerror());
+			return 1;
+		}
+	}
+	printf("%-16s %-6s %8s %11s %12s %12s %8s\n","kernel","result","calls","malloc/call","ns/call","spread","bytes");
+	for(int i=0;i<4;i++) run(&ks[i]);
+	return 0;
+}
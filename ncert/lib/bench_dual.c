@@ -0,0 +1,56 @@
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include "dual.h"
+//Compares evaluations/sec of the pow() based f(x),f'(x) of 6.5.7_GD with the fused Horner form
+//gcc -O2 -o bench_dual bench_dual.c -lm
+#define N 20000000
+
+static const double fcoef[]={3,-8,12,-48,25};
+
+double now(){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC,&t);
+	return t.tv_sec+t.tv_nsec*1e-9;
+}
+//Original hand written pair
+double f1x_pow(double x){
+	return 12*x*x*x-24*x*x+24*x-48;
+}
+double fx_pow(double x){
+	return 3*pow(x,4)-8*pow(x,3)+12*pow(x,2)-48*x+25;
+}
+
+int main(){
+	volatile double sink=0;
+	double h=3.0/N,acc=0,t;
+
+	t=now();
+	for(int i=0;i<N;i++){
+		double x=i*h;
+		acc+=fx_pow(x)+f1x_pow(x);
+	}
+	t=now()-t;
+	sink+=acc;
+	printf("pow    : %8.2f Meval/s\n",N/t*1e-6);
+
+	acc=0;
+	t=now();
+	for(int i=0;i<N;i++){
+		dual y=dhorner(fcoef,5,i*h);
+		acc+=y.v+y.d;
+	}
+	t=now()-t;
+	sink+=acc;
+	printf("horner : %8.2f Meval/s\n",N/t*1e-6);
+
+	//Both forms must agree
+	double err=0;
+	for(int i=0;i<1000;i++){
+		double x=i*0.003;
+		dual y=dhorner(fcoef,5,x);
+		err=fmax(err,fabs(y.v-fx_pow(x))+fabs(y.d-f1x_pow(x)));
+	}
+	printf("max |difference| = %g\n",err);
+	return 0;
+}
@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "eigen.h"
+#include "eigs.h"
+#include "sparse.h"
+#include "mc.h"
+#include "rng.h"
+//Top-k eigenvalues of a g x g grid Laplacian plus a random potential in [0,8) (Anderson model,
+//whose largest eigenvalues are well separated unlike those of the bare Poisson matrix):
+//dense qr_eigen on every eigenvalue against lanczos_eigs on the four largest, checked against
+//each other, then Lanczos alone up to 2.6*10^5 unknowns
+//gcc -O3 -o bench_eigs bench_eigs.c -L. -lncert -Wl,-rpath,'$ORIGIN' -lm -lpthread
+#define K 4
+#define M 40
+
+double now(){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC,&t);
+	return t.tv_sec+t.tv_nsec*1e-9;
+}
+
+static long *ptr;
+static int *col;
+static double *val;
+
+static csr anderson(long g,int nthreads){
+	long n=g*g,e=0;
+	rng gen;
+	rng_init(&gen,2024,0);
+	ptr=(long*)malloc((n+1)*sizeof(long));
+	col=(int*)malloc(5*n*sizeof(int));
+	val=(double*)malloc(5*n*sizeof(double));
+	for(long i=0;i<g;i++){
+		for(long j=0;j<g;j++){
+			ptr[i*g+j]=e;
+			if(i>0){ col[e]=(int)((i-1)*g+j); val[e++]=-1; }
+			if(j>0){ col[e]=(int)(i*g+j-1); val[e++]=-1; }
+			col[e]=(int)(i*g+j); val[e++]=4+8*rng_double(&gen);
+			if(j<g-1){ col[e]=(int)(i*g+j+1); val[e++]=-1; }
+			if(i<g-1){ col[e]=(int)((i+1)*g+j); val[e++]=-1; }
+		}
+	}
+	ptr[n]=e;
+	csr A={n,ptr,col,val,nthreads};
+	return A;
+}
+
+static double lanczos(csr *A,double *eig,kstats *st){
+	double *work=(double*)malloc(EIGS_WORK(A->n,M)*sizeof(double));
+	double t0=now();
+	lanczos_eigs(csr_matvec,A,A->n,K,M<A->n?M:(int)A->n,EIGS_LR,1e-8,1000,eig,work,A->nthreads,st);
+	t0=now()-t0;
+	free(work);
+	return t0;
+}
+
+int main(){
+	static const long dense[]={6,10,16},sparse[]={128,256,512};
+	kstats st={0};
+	double eig[K];
+	printf("%-8s %8s %8s %12s %12s %10s %16s\n","grid","n","threads","dense_s","lanczos_s","nfev","|dense-lanczos|");
+	for(int i=0;i<3;i++){
+		long g=dense[i],n=g*g;
+		csr A=anderson(g,1);
+		double complex *D=(double complex*)calloc(n*n,sizeof(double complex));
+		double complex *w=(double complex*)malloc(QR_WORK(n)*sizeof(double complex));
+		double complex *ev=(double complex*)malloc(n*sizeof(double complex));
+		for(long r=0;r<n;r++){
+			for(long k=ptr[r];k<ptr[r+1];k++) D[r*n+col[k]]=val[k];
+		}
+		double t0=now();
+		qr_eigen(D,(int)n,ev,w,100000,NULL);
+		double td=now()-t0,top=-HUGE_VAL;
+		for(long r=0;r<n;r++) if(creal(ev[r])>top) top=creal(ev[r]);
+		double tl=lanczos(&A,eig,&st);
+		printf("%-8ld %8ld %8d %12.4g %12.4g %10ld %16.3g\n",g,n,1,td,tl,st.nfev,fabs(top-eig[0]));
+		free(D);
+		free(w);
+		free(ev);
+		free(ptr);
+		free(col);
+		free(val);
+	}
+	for(int i=0;i<3;i++){
+		long g=sparse[i];
+		for(int th=1;;th=th*2<mc_ncpu()?th*2:mc_ncpu()){
+			csr A=anderson(g,th);
+			double tl=lanczos(&A,eig,&st);
+			printf("%-8ld %8ld %8d %12s %12.4g %10ld %16s\n",g,g*g,th,"-",tl,st.nfev,"-");
+			free(ptr);
+			free(col);
+			free(val);
+			if(th==mc_ncpu()) break;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,44 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "ensemble.h"
+//Trajectories/sec of the 9.1.8 ODE y'=e^x-y over [0,2] as the ensemble grows
+//gcc -O3 -o bench_ensemble bench_ensemble.c ensemble.c cpu.c -lm -lpthread
+#define STEPS 2000
+
+double now(){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC,&t);
+	return t.tv_sec+t.tv_nsec*1e-9;
+}
+void rhs(double x,const double *y,double *dy,int n,void *ctx){
+	double ex=exp(x);
+	for(int i=0;i<n;i++){
+		dy[i]=ex-y[i];
+	}
+}
+
+int main(){
+	int ncpu=(int)sysconf(_SC_NPROCESSORS_ONLN);
+	printf("%10s %8s %14s %10s\n","n","threads","traj/s","maxerr");
+	for(int n=1;n<=1<<20;n*=16){
+		double *y=(double*)malloc(n*sizeof(double));
+		for(int th=1;;th=th*2<ncpu?th*2:ncpu){
+			for(int i=0;i<n;i++) y[i]=(double)i/n;
+			double t=now();
+			ensemble_rk4(rhs,NULL,0,2,STEPS,y,n,th);
+			t=now()-t;
+			//Exact solution y=e^x/2+(y0-1/2)e^-x
+			double err=0;
+			for(int i=0;i<n;i++){
+				err=fmax(err,fabs(y[i]-(exp(2)/2+((double)i/n-0.5)*exp(-2))));
+			}
+			printf("%10d %8d %14.4g %10.2g\n",n,th,n/t,err);
+			if(th==ncpu) break;
+		}
+		free(y);
+	}
+	return 0;
+}
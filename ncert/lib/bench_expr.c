@@ -0,0 +1,169 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "expr.h"
+#include "quad.h"
+#include "gd.h"
+#include "ensemble.h"
+//Nanoseconds per evaluation of compiled expressions against the same functions written in C
+//gcc -O3 -o bench_expr bench_expr.c -L. -lncert -Wl,-rpath,'$ORIGIN' -lm -lpthread
+#define N 1000000
+#define REPS 5
+
+double now(){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC,&t);
+	return t.tv_sec+t.tv_nsec*1e-9;
+}
+
+//The native versions of the problem functions
+static double rootx(double x,void *ctx){
+	(void)ctx;
+	return sqrt(x);
+}
+static void brootx(const double *x,double *y,int n,void *ctx){
+	(void)ctx;
+	for(int i=0;i<n;i++) y[i]=sqrt(x[i]);
+}
+static double rhs(double x,double y,void *ctx){
+	(void)ctx;
+	(void)y;
+	return -cos(3*x)/3+sin(3*x)/3;
+}
+static void brhs(double x,const double *y,double *dy,int n,void *ctx){
+	(void)ctx;
+	double ex=exp(x);
+	for(int i=0;i<n;i++) dy[i]=ex-y[i];
+}
+static double lin(double x,void *ctx){
+	(void)ctx;
+	return 595+35*x;
+}
+static const double gdcoef[]={3,-8,12,-48,25};
+static dual gdpoly(double x,void *ctx){
+	(void)ctx;
+	return dhorner(gdcoef,5,x);
+}
+
+//Called through pointers, the way the kernels call them
+static double (*volatile f_rootx)(double,void*)=rootx;
+static void (*volatile f_brootx)(const double*,double*,int,void*)=brootx;
+static double (*volatile f_rhs)(double,double,void*)=rhs;
+static void (*volatile f_brhs)(double,const double*,double*,int,void*)=brhs;
+static dual (*volatile f_gdpoly)(double,void*)=gdpoly;
+static double (*volatile f_lin)(double,void*)=lin;
+
+static double *xs,*ys;
+static expr e;
+static volatile double sink;
+
+//Each case evaluates N points once, best of REPS
+static void c_sqrt(){
+	double s=0;
+	for(int i=0;i<N;i++) s+=f_rootx(xs[i],NULL);
+	sink=s;
+}
+static void e_integrand(){
+	double s=0;
+	for(int i=0;i<N;i++) s+=expr_integrand(xs[i],&e);
+	sink=s;
+}
+static void cb_sqrt(){
+	f_brootx(xs,ys,N,NULL);
+}
+static void eb_sqrt(){
+	expr_batchintegrand(xs,ys,N,&e);
+}
+static void c_rhs(){
+	double s=0;
+	for(int i=0;i<N;i++) s+=f_rhs(xs[i],0,NULL);
+	sink=s;
+}
+static void e_rhs(){
+	double s=0;
+	for(int i=0;i<N;i++) s+=expr_odefunc(xs[i],0,&e);
+	sink=s;
+}
+static void c_poly(){
+	double s=0;
+	for(int i=0;i<N;i++) s+=f_gdpoly(xs[i],NULL).d;
+	sink=s;
+}
+static void e_poly(){
+	double s=0;
+	for(int i=0;i<N;i++) s+=expr_dualfunc(xs[i],&e).d;
+	sink=s;
+}
+static void c_lin(){
+	double s=0;
+	for(int i=0;i<N;i++) s+=f_lin(xs[i],NULL);
+	sink=s;
+}
+static void cb_ens(){
+	f_brhs(0.5,xs,ys,N,NULL);
+}
+static void eb_ens(){
+	expr_batchfunc(0.5,xs,ys,N,&e);
+}
+
+static double best(void (*f)()){
+	double t=INFINITY;
+	f();
+	for(int r=0;r<REPS;r++){
+		double t0=now();
+		f();
+		t=fmin(t,now()-t0);
+	}
+	return t/N*1e9;
+}
+
+//shown stands in for src in the table when it is too long to print
+static void row(const char *name,const char *src,const char *shown,const char *vars,void (*native)(),void (*compiled)()){
+	if(expr_compile(&e,src,vars)!=0){
+		printf("%s: does not compile at %d\n",name,e.errpos);
+		return;
+	}
+	double tc=best(native),te=best(compiled);
+	printf("%-22s %-32s %5d %10.2f %10.2f %7.2fx\n",name,shown?shown:src,e.ncode,tc,te,te/tc);
+}
+
+int main(){
+	xs=(double*)malloc(N*sizeof(double));
+	ys=(double*)malloc(N*sizeof(double));
+	for(int i=0;i<N;i++) xs[i]=1+3.0*i/N;
+	printf("%-22s %-32s %5s %10s %10s %8s\n","case","expression","insts","c_ns","expr_ns","ratio");
+	row("integrand","sqrt(x)",NULL,"x",c_sqrt,e_integrand);
+	row("integrand batch","sqrt(x)",NULL,"x",cb_sqrt,eb_sqrt);
+	row("ode rhs","-cos(3*x)/3+sin(3*x)/3",NULL,"x,y",c_rhs,e_rhs);
+	row("ensemble rhs batch","exp(x)-y",NULL,"x,y",cb_ens,eb_ens);
+	row("gd objective (dual)","3*x^4-8*x^3+12*x^2-48*x+25",NULL,"x",c_poly,e_poly);
+	//More literals than EXPR_MAXCONST, all but 35*x folded into one constant
+	char chain[256];
+	int len=0;
+	for(int i=1;i<=34;i++) len+=sprintf(chain+len,"%d+",i);
+	sprintf(chain+len,"35*x");
+	row("constant chain",chain,"1+2+...+34+35*x","x",c_lin,e_integrand);
+	//End to end through the kernels
+	double t0,tc,te,A,B;
+	expr_compile(&e,"sqrt(x)","x");
+	t0=now();
+	A=quad_trapezoid(rootx,NULL,1,4,N);
+	tc=now()-t0;
+	t0=now();
+	B=quad_trapezoid(expr_integrand,&e,1,4,N);
+	te=now()-t0;
+	printf("quad_trapezoid n=%d: c %.4g s, expr %.4g s (%.2fx), |diff| %.3g\n",N,tc,te,te/tc,fabs(A-B));
+	gdpoint mn,mx,mn2,mx2;
+	expr_compile(&e,"3*x^4-8*x^3+12*x^2-48*x+25","x");
+	t0=now();
+	for(int r=0;r<100;r++) gd_scan(gdpoly,NULL,0,3,&mn,&mx,NULL);
+	tc=now()-t0;
+	t0=now();
+	for(int r=0;r<100;r++) gd_scan(expr_dualfunc,&e,0,3,&mn2,&mx2,NULL);
+	te=now()-t0;
+	printf("gd_scan x100: c %.4g s, expr %.4g s (%.2fx), min (%g,%g) vs (%g,%g)\n",tc,te,te/tc,mn.x,mn.y,mn2.x,mn2.y);
+	free(xs);
+	free(ys);
+	return 0;
+}
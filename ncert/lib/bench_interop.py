@@ -0,0 +1,48 @@
+# Python-side cost of getting the 9.1.8 trajectory into NumPy, before and after the buffer API
+# Usage: python3 bench_interop.py ../9.1.8/codes/func.so
+import sys
+import timeit
+import numpy as np
+from ctypes import CDLL, Structure, POINTER, c_float, c_int, c_long, c_void_p
+from npbuf import ptr, stride
+
+
+class Coords(Structure):
+    _fields_ = [("x", c_float), ("y", c_float)]
+
+
+lib = CDLL(sys.argv[1] if len(sys.argv) > 1 else "../9.1.8/codes/func.so")
+lib.fx.restype = POINTER(Coords)
+lib.fx.argtypes = [c_float, c_float]
+lib.fxbuf.restype = c_int
+lib.fxbuf.argtypes = [c_float, c_float, c_void_p, c_long, c_void_p, c_long, c_int]
+lib.free.argtypes = [c_void_p]
+N = 2000
+
+
+def before():
+    # malloc'd array copied element by element, then freed
+    results = lib.fx(c_float(0.5), c_float(0.0))
+    xvals = np.array([results[i].x for i in range(N)])
+    yvals = np.array([results[i].y for i in range(N)])
+    lib.free(results)
+    return xvals, yvals
+
+
+xbuf = np.empty(N, dtype=np.float32)
+ybuf = np.empty(N, dtype=np.float32)
+
+
+def after():
+    # C writes straight into preallocated arrays
+    lib.fxbuf(0.5, 0.0, ptr(xbuf, np.float32), stride(xbuf), ptr(ybuf, np.float32), stride(ybuf), N)
+    return xbuf, ybuf
+
+
+xa, ya = before()
+xb, yb = after()
+assert np.array_equal(xa, xb) and np.array_equal(ya, yb)
+for name, fn in [("element copy", before), ("zero copy", after)]:
+    reps = 200
+    t = min(timeit.repeat(fn, number=reps, repeat=5)) / reps
+    print(f"{name:14s} {t * 1e6:10.1f} us/call")
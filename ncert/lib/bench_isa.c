@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <complex.h>
+#include "cpu.h"
+#include "lu.h"
+#include "eigen.h"
+#include "ensemble.h"
+#include "mc.h"
+#include "quad.h"
+#include "rng.h"
+//Throughput of the dispatched hot loops at every instruction set level this CPU supports
+//gcc -O3 -o bench_isa bench_isa.c -L. -lncert -Wl,-rpath,'$ORIGIN' -lm -lpthread
+#define REPS 5
+
+double now(){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC,&t);
+	return t.tv_sec+t.tv_nsec*1e-9;
+}
+
+static rng gen;
+static double *A,*LU;
+static float *Af,*LUf;
+static double complex *Z,*Zw,*Ze;
+static double *y;
+static float *yf;
+#define N 256
+#define QN 64
+#define LANES_N (1<<18)
+
+static void decay(double x,const double *y,double *dy,int n,void *ctx){
+	for(int i=0;i<n;i++) dy[i]=-y[i];
+}
+static void decay_f(float x,const float *y,float *dy,int n,void *ctx){
+	for(int i=0;i<n;i++) dy[i]=-y[i];
+}
+static void brootx(const double *x,double *y,int n,void *ctx){
+	for(int i=0;i<n;i++) y[i]=sqrt(x[i]);
+}
+
+//Each kernel runs once and returns the work done in its unit
+static double k_lu(){
+	lu_decompose(A,N,LU,N,LU,N,N);
+	return 2.0*N*N*N/3;
+}
+static double k_lu_f(){
+	lu_decompose_f(Af,N,LUf,N,LUf,N,N);
+	return 2.0*N*N*N/3;
+}
+static double k_eigen(){
+	for(long i=0;i<QN*QN;i++) Zw[i]=Z[i];
+	qr_eigen(Zw,QN,Ze,Zw+QN*QN,10000,NULL);
+	return 1;
+}
+static double k_ensemble(){
+	for(int i=0;i<LANES_N;i++) y[i]=1;
+	ensemble_rk4(decay,NULL,0,1,100,y,LANES_N,1);
+	return 100.0*LANES_N;
+}
+static double k_ensemble_f(){
+	for(int i=0;i<LANES_N;i++) yf[i]=1;
+	ensemble_rk4_f(decay_f,NULL,0,1,100,yf,LANES_N,1);
+	return 100.0*LANES_N;
+}
+static double k_bernoulli(){
+	mc_bernoulli(1.0/12,1<<24,12345,1);
+	return 1<<24;
+}
+static double k_trapezoid(){
+	quad_trapezoid_batch(brootx,NULL,1,4,1<<24);
+	return (1<<24)+1;
+}
+
+typedef struct kernel{
+	const char *name,*unit;
+	double (*run)();
+}kernel;
+
+static const kernel kernels[]={
+	{"lu","flop",k_lu},
+	{"lu_f","flop",k_lu_f},
+	{"qr_eigen","matrix",k_eigen},
+	{"ensemble_rk4","lane-step",k_ensemble},
+	{"ensemble_rk4_f","lane-step",k_ensemble_f},
+	{"bernoulli","trial",k_bernoulli},
+	{"trapezoid_batch","eval",k_trapezoid},
+};
+
+int main(){
+	rng_init(&gen,2024,0);
+	A=(double*)malloc(N*N*sizeof(double));
+	LU=(double*)malloc(N*N*sizeof(double));
+	Af=(float*)malloc(N*N*sizeof(float));
+	LUf=(float*)malloc(N*N*sizeof(float));
+	for(long i=0;i<N;i++){
+		for(long j=0;j<N;j++) Af[i*N+j]=A[i*N+j]=rng_double(&gen)-0.5+(i==j?N:0);
+	}
+	Z=(double complex*)malloc(QN*QN*sizeof(double complex));
+	Zw=(double complex*)malloc((QN*QN+QR_WORK(QN))*sizeof(double complex));
+	Ze=(double complex*)malloc(QN*sizeof(double complex));
+	for(long i=0;i<QN*QN;i++) Z[i]=rng_double(&gen)-0.5;
+	y=(double*)malloc(LANES_N*sizeof(double));
+	yf=(float*)malloc(LANES_N*sizeof(float));
+	int best=cpu_isa_best();
+	printf("%-16s %-8s %14s %12s\n","kernel","isa","rate","speedup");
+	for(size_t k=0;k<sizeof(kernels)/sizeof(kernels[0]);k++){
+		double base=0;
+		for(int l=ISA_GENERIC;l<=best;l++){
+			cpu_set_isa(l);
+			double work=kernels[k].run(),t=INFINITY;	//warm-up
+			for(int r=0;r<REPS;r++){
+				double t0=now();
+				kernels[k].run();
+				t=fmin(t,now()-t0);
+			}
+			double rate=work/t;
+			if(l==ISA_GENERIC) base=rate;
+			printf("%-16s %-8s %14.4g %11.2fx  %s/s\n",kernels[k].name,cpu_isa_name(l),rate,rate/base,kernels[k].unit);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,32 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "mc.h"
+//Bernoulli trials/sec: rand() loop of 11.16.3.9 against Philox with 1..ncpu threads
+//gcc -O3 -o bench_mc bench_mc.c mc.c cpu.c -lpthread
+
+double now(){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC,&t);
+	return t.tv_sec+t.tv_nsec*1e-9;
+}
+
+int main(){
+	double p=1.0/12,t;
+	uint64_t n=1ull<<28,hits=0;
+	srand(1);
+	t=now();
+	for(uint64_t i=0;i<n/16;i++){
+		hits+=(double)rand()/RAND_MAX<p;
+	}
+	t=now()-t;
+	printf("%-16s %12.4g trials/s  p=%.6f\n","rand()",n/16/t,(double)hits/(n/16));
+	for(int th=1;;th=th*2<mc_ncpu()?th*2:mc_ncpu()){
+		t=now();
+		hits=mc_bernoulli(p,n,12345,th);
+		t=now()-t;
+		printf("philox %2d thread %12.4g trials/s  p=%.6f count=%llu\n",th,n/t,(double)hits/n,(unsigned long long)hits);
+		if(th==mc_ncpu()) break;
+	}
+	return 0;
+}
@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "lbfgs.h"
+#include "mc.h"
+//L-BFGS (m=10, |grad f|_inf<=1e-6) on two Rosenbrock-type problems from x_i=-1.2, 1, -1.2, ...:
+//chained, f=sum_{i<n-1} 100(x_{i+1}-x_i^2)^2+(1-x_i)^2, whose coupling makes the iterations grow with n,
+//and extended, the same over the disjoint pairs (x_2j,x_2j+1), whose iterations do not,
+//then the extended one with 4*10^6 variables evaluated by threads
+//gcc -O3 -o bench_opt bench_opt.c -L. -lncert -Wl,-rpath,'$ORIGIN' -lm -lpthread
+#define M 10
+
+double now(){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC,&t);
+	return t.tv_sec+t.tv_nsec*1e-9;
+}
+
+//Terms i=lo..hi-1 of the chained Rosenbrock function and g[lo..hi-1], which also takes term lo-1
+static double chained(const double *x,double *g,long lo,long hi,long n,void *ctx){
+	(void)ctx;
+	double f=0;
+	for(long i=lo;i<hi;i++){
+		double gi=0;
+		if(i<n-1){
+			double t=x[i+1]-x[i]*x[i],u=1-x[i];
+			f+=100*t*t+u*u;
+			gi=-400*x[i]*t-2*u;
+		}
+		if(i>0) gi+=200*(x[i]-x[i-1]*x[i-1]);
+		g[i]=gi;
+	}
+	return f;
+}
+
+//Pairs (x_2j,x_2j+1) whose first index is in lo..hi-1 and g[lo..hi-1], n even
+static double extended(const double *x,double *g,long lo,long hi,long n,void *ctx){
+	(void)n;
+	(void)ctx;
+	double f=0;
+	for(long i=lo;i<hi;i++){
+		if(i%2){
+			g[i]=200*(x[i]-x[i-1]*x[i-1]);
+			continue;
+		}
+		double t=x[i+1]-x[i]*x[i],u=1-x[i];
+		f+=100*t*t+u*u;
+		g[i]=-400*x[i]*t-2*u;
+	}
+	return f;
+}
+
+static double whole(const double *x,double *g,long n,void *ctx){
+	return ((partfunc)ctx)(x,g,0,n,n,NULL);
+}
+
+static void start(double *x,long n){
+	for(long i=0;i<n;i++) x[i]=i%2?1:-1.2;
+}
+
+//nthreads 0 runs lbfgs on the whole f, otherwise lbfgs_sep
+static void run(const char *name,partfunc f,long n,int nthreads){
+	double *x=(double*)malloc(n*sizeof(double));
+	double *work=(double*)malloc(LBFGS_WORK(n,M)*sizeof(double)),fx;
+	kstats st={0};
+	char th[16]="-";
+	start(x,n);
+	int r;
+	if(nthreads==0) r=lbfgs(whole,(void*)f,x,n,M,1e-6,100000,&fx,work,&st);
+	else{
+		r=lbfgs_sep(f,NULL,x,n,M,1e-6,100000,&fx,work,nthreads,&st);
+		snprintf(th,sizeof(th),"%d",nthreads);
+	}
+	double err=0;
+	for(long i=0;i<n;i++) err=fmax(err,fabs(x[i]-1));
+	printf("%-10s %9ld %8s %8d %8ld %12.4g %12.3g %12.3g %10.3g%s\n",name,n,th,st.iterations,st.nfev,st.seconds,fx,st.residual,err,r<0?"  failed":"");
+	free(x);
+	free(work);
+}
+
+int main(){
+	static const long chain[]={2,100,1000},ext[]={2,100,10000,1000000};
+	printf("%-10s %9s %8s %8s %8s %12s %12s %12s %10s\n","problem","n","threads","iter","nfev","seconds","f","|g|_inf","|x-1|_inf");
+	for(int i=0;i<3;i++) run("chained",chained,chain[i],0);
+	for(int i=0;i<4;i++) run("extended",extended,ext[i],0);
+	//Threads only pay once an evaluation costs much more than starting them
+	for(int th=1;;th=th*2<mc_ncpu()?th*2:mc_ncpu()){
+		run("extended",extended,4000000,th);
+		if(th==mc_ncpu()) break;
+	}
+	return 0;
+}
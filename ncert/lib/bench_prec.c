@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <complex.h>
+#include "lu.h"
+#include "euler.h"
+#include "quad.h"
+#include "gd.h"
+#include "ensemble.h"
+#include "rng.h"
+//Time and error of each precision-generic kernel in float, double, long double and complex,
+//then the float-factor, double-refinement solver against the double one
+//gcc -O3 -o bench_prec bench_prec.c -L. -lncert -Wl,-rpath,'$ORIGIN' -lm -lpthread
+
+double now(){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC,&t);
+	return t.tv_sec+t.tv_nsec*1e-9;
+}
+
+static void report(const char *prec,const char *kernel,long n,double t,double rate,const char *unit,long double err){
+	printf("%-12s %-12s %9ld %12.4g %12.4g %-12s %10.3Lg\n",kernel,prec,n,t,rate,unit,err);
+}
+
+#define PREC 'f'
+#define NAME "float"
+#include "scalar.h"
+#include "bench_prec_impl.h"
+#undef PREC
+#undef NAME
+#define PREC 'd'
+#define NAME "double"
+#include "scalar.h"
+#include "bench_prec_impl.h"
+#undef PREC
+#undef NAME
+#define PREC 'l'
+#define NAME "long double"
+#include "scalar.h"
+#include "bench_prec_impl.h"
+#undef PREC
+#undef NAME
+#define PREC 'c'
+#define NAME "complex"
+#include "scalar.h"
+#include "bench_prec_impl.h"
+#undef PREC
+#undef NAME
+
+static double onesErr(const double *x,int n){
+	double err=0;
+	for(int i=0;i<n;i++) err=fmax(err,fabs(x[i]-1));
+	return err;
+}
+
+//Unpivoted lu_solve and pivoted double factors against lu_solve_mixed on A (x all ones), error is max|x-1|
+static void bench_mixed(const char *name,const double *A,int n){
+	double *b=(double*)malloc(n*sizeof(double)),*x=(double*)malloc(n*sizeof(double));
+	double *work=(double*)malloc(LU_MIXED_WORK(n)*sizeof(double));
+	int *piv=(int*)malloc(n*sizeof(int));
+	kstats st={0};
+	for(long i=0;i<n;i++){
+		b[i]=0;
+		for(long j=0;j<n;j++) b[i]+=A[i*n+j];
+	}
+	double t=now();
+	int r=lu_solve(A,n,b,x,n,work);
+	t=now()-t;
+	printf("%-10s %6d %-8s %10.4g %6s %10.3g%s\n",name,n,"nopivot",t,"-",onesErr(x,n),r<0?"  singular":"");
+	t=now();
+	for(long i=0;i<(long)n*n;i++) work[i]=A[i];
+	r=lu_decompose_piv(work,n,piv,n);
+	lu_subst_piv(work,n,piv,b,x,n);
+	t=now()-t;
+	printf("%-10s %6d %-8s %10.4g %6s %10.3g%s\n",name,n,"double",t,"-",onesErr(x,n),r<0?"  singular":"");
+	r=lu_solve_mixed(A,n,b,x,n,10,work,&st);
+	printf("%-10s %6d %-8s %10.4g %6d %10.3g%s\n",name,n,"mixed",st.seconds,st.iterations,onesErr(x,n),
+		r==1?"  double fallback":r<0?"  failed":"");
+	free(b);
+	free(x);
+	free(work);
+	free(piv);
+}
+
+int main(){
+	printf("%-12s %-12s %9s %12s %12s %-12s %10s\n","kernel","precision","n","time_s","rate","unit","maxerr");
+	bench_lu_f(512);
+	bench_lu(512);
+	bench_lu_l(512);
+	bench_lu_c(512);
+	bench_euler_f(1000000);
+	bench_euler(1000000);
+	bench_euler_l(1000000);
+	bench_trapezoid_f(1000000);
+	bench_trapezoid(1000000);
+	bench_trapezoid_l(1000000);
+	bench_gd_f(16);
+	bench_gd(16);
+	bench_gd_l(16);
+	bench_ensemble_f(1<<20);
+	bench_ensemble(1<<20);
+	bench_ensemble_l(1<<20);
+	printf("\n%-10s %6s %-8s %10s %6s %10s\n","matrix","n","solve","time_s","steps","maxerr");
+	for(int n=512;n<=1024;n*=2){
+		//Diagonally dominant, well conditioned
+		double *A=(double*)malloc((long)n*n*sizeof(double));
+		rng g;
+		rng_init(&g,2024,0);
+		for(long i=0;i<n;i++){
+			for(long j=0;j<n;j++) A[i*n+j]=rng_double(&g)-0.5+(i==j?n:0);
+		}
+		bench_mixed("dominant",A,n);
+		//Uniform entries, well conditioned but with small leading pivots
+		for(long i=0;i<(long)n*n;i++) A[i]=rng_double(&g)-0.5;
+		bench_mixed("random",A,n);
+		free(A);
+	}
+	//A permutation, condition 1 but a zero first pivot
+	static const double P[9]={0,1,0,1,0,0,0,0,1};
+	bench_mixed("permute",P,3);
+	//Hilbert, condition about 1e13, beyond what float factors can refine
+	double H[10*10];
+	for(int i=0;i<10;i++){
+		for(int j=0;j<10;j++) H[i*10+j]=1.0/(i+j+1);
+	}
+	bench_mixed("hilbert",H,10);
+	return 0;
+}
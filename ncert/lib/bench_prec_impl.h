@@ -0,0 +1,97 @@
+//Generic body of bench_prec.c, one instantiation per precision (see scalar.h)
+//Every error is measured against a closed form evaluated in long double
+
+//Ax=b with x all ones on a diagonally dominant random matrix, error is max|x-1|
+static void FN(bench_lu)(int n){
+	T *A=(T*)malloc((long)n*n*sizeof(T)),*lu=(T*)malloc((long)n*n*sizeof(T));
+	T *b=(T*)malloc(n*sizeof(T)),*x=(T*)malloc(n*sizeof(T));
+	rng g;
+	rng_init(&g,2024,0);
+	for(long i=0;i<n;i++){
+		b[i]=0;
+		for(long j=0;j<n;j++){
+			A[i*n+j]=(T)(rng_double(&g)-0.5)+(i==j?n:0);
+#if PREC=='c'
+			A[i*n+j]+=I*(T)(rng_double(&g)-0.5);
+#endif
+			b[i]+=A[i*n+j];
+		}
+	}
+	double t=now();
+	FN(lu_solve)(A,n,b,x,n,lu);
+	t=now()-t;
+	long double err=0;
+	for(int i=0;i<n;i++) err=fmaxl(err,ABS(x[i]-1));
+	report(NAME,"lu_solve",n,t,(2.0*n*n*n/3+2.0*n*n)/t,"flop/s",err);
+	free(A);
+	free(lu);
+	free(b);
+	free(x);
+}
+
+#if PREC!='c'
+static T FN(odeexp)(T x,T y,void *ctx){
+	(void)ctx;
+	return EXP(x)-y;
+}
+static T FN(rootx)(T x,void *ctx){
+	(void)ctx;
+	return SQRT(x);
+}
+static const T FN(gdcoef)[]={3,-8,12,-48,25};
+static FN(dual) FN(gdpoly)(T x,void *ctx){
+	(void)ctx;
+	FN(dual) p={FN(gdcoef)[0],0};
+	for(int i=1;i<5;i++){
+		p.d=p.d*x+p.v;
+		p.v=p.v*x+FN(gdcoef)[i];
+	}
+	return p;
+}
+static void FN(decay)(T x,const T *y,T *dy,int n,void *ctx){
+	(void)x;
+	(void)ctx;
+	for(int i=0;i<n;i++) dy[i]=-y[i];
+}
+
+//y'=e^x-y, y(0)=1/2 over [0,2], exact y=e^x/2
+static void FN(bench_euler)(int n){
+	T *xs=(T*)malloc(n*sizeof(T)),*ys=(T*)malloc(n*sizeof(T));
+	double t=now();
+	FN(euler)(FN(odeexp),NULL,0,(T)0.5,(T)2/(n-1),xs,1,ys,1,n);
+	t=now()-t;
+	report(NAME,"euler",n,t,n/t,"step/s",fabsl(ys[n-1]-expl(2)/2));
+	free(xs);
+	free(ys);
+}
+
+//sqrt(x) on [1,4], exact 14/3
+static void FN(bench_trapezoid)(int n){
+	double t=now();
+	T A=FN(quad_trapezoid)(FN(rootx),NULL,1,4,n);
+	t=now()-t;
+	report(NAME,"trapezoid",n,t,(n+1)/t,"eval/s",fabsl(A-14.0L/3));
+}
+
+//3x^4-8x^3+12x^2-48x+25 on [0,3], global minimum -39 at x=2
+static void FN(bench_gd)(int reps){
+	FN(gdpoint) mn,mx;
+	double t=now();
+	for(int r=0;r<reps;r++) FN(gd_scan)(FN(gdpoly),NULL,0,3,&mn,&mx,NULL);
+	t=now()-t;
+	report(NAME,"gd",reps,t,reps/t,"scan/s",fabsl(mn.x-2));
+}
+
+//y'=-y over [0,1] in 100 RK4 steps on n lanes, exact y0/e
+static void FN(bench_ensemble)(int n){
+	T *y=(T*)malloc(n*sizeof(T));
+	for(int i=0;i<n;i++) y[i]=(T)(i+1)/n;
+	double t=now();
+	FN(ensemble_rk4)(FN(decay),NULL,0,1,100,y,n,1);
+	t=now()-t;
+	long double err=0;
+	for(int i=0;i<n;i++) err=fmaxl(err,fabsl(y[i]-(long double)(i+1)/n*expl(-1)));
+	report(NAME,"ensemble_rk4",n,t,(double)n*100/t,"lane-step/s",err);
+	free(y);
+}
+#endif
@@ -0,0 +1,74 @@
+#include <stdio.h>
+#include <math.h>
+#include "qmc.h"
+#include "mc.h"
+//Error against samples for scrambled Sobol QMC and plain Monte Carlo (16 replicates each):
+//exp(sum x_d/(d+1)) on [0,1]^dim, smooth, and the volume of the unit ball as the mean of its
+//indicator on [-1,1]^dim, discontinuous; then the 20 dimensional one with 1..ncpu threads
+//gcc -O3 -o bench_qmc bench_qmc.c -L. -lncert -Wl,-rpath,'$ORIGIN' -lm -lpthread
+#define REPS 16
+
+static void expsum(const double *x,double *y,int n,int dim,void *ctx){
+	(void)ctx;
+	for(int i=0;i<n;i++){
+		double s=0;
+		for(int d=0;d<dim;d++) s+=x[i*dim+d]/(d+1);
+		y[i]=exp(s);
+	}
+}
+
+static void ball(const double *x,double *y,int n,int dim,void *ctx){
+	(void)ctx;
+	for(int i=0;i<n;i++){
+		double r=0;
+		for(int d=0;d<dim;d++) r+=x[i*dim+d]*x[i*dim+d];
+		y[i]=r<=1;
+	}
+}
+
+static double expsum_exact(int dim){
+	double I=1;
+	for(int d=0;d<dim;d++) I*=(d+1)*(exp(1.0/(d+1))-1);
+	return I;
+}
+
+static double ball_exact(int dim){
+	return pow(M_PI,dim/2.0)/tgamma(dim/2.0+1);
+}
+
+static void row(const char *name,qmcintegrand f,int dim,double a,double b,double exact,long n){
+	double lo[QMC_MAXDIM],hi[QMC_MAXDIM];
+	for(int d=0;d<dim;d++){
+		lo[d]=a;
+		hi[d]=b;
+	}
+	qmcstats q,m;
+	double Iq=qmc_integrate(f,NULL,dim,lo,hi,n,REPS,1,0,&q);
+	double Im=mc_integrate(f,NULL,dim,lo,hi,n,REPS,1,0,&m);
+	printf("%-6s %4d %10ld %12.3g %12.3g %12.3g %12.3g %8.3g\n",name,dim,q.nfev,fabs(Iq-exact)/exact,q.err/exact,
+		fabs(Im-exact)/exact,m.err/exact,m.err*m.err/(q.err*q.err));
+}
+
+int main(){
+	static const int edim[]={3,8,20},bdim[]={3,6};
+	printf("%-6s %4s %10s %12s %12s %12s %12s %8s\n","f","dim","samples","qmc relerr","qmc est","mc relerr","mc est","var gain");
+	for(int k=0;k<3;k++){
+		for(long n=1<<10;n<=1<<18;n<<=4) row("exp",expsum,edim[k],0,1,expsum_exact(edim[k]),n);
+	}
+	for(int k=0;k<2;k++){
+		for(long n=1<<10;n<=1<<18;n<<=4) row("ball",ball,bdim[k],-1,1,ball_exact(bdim[k]),n);
+	}
+	double lo[20],hi[20];
+	for(int d=0;d<20;d++){
+		lo[d]=0;
+		hi[d]=1;
+	}
+	printf("\n%-8s %12s %12s %12s\n","threads","seconds","points/s","relerr");
+	for(int th=1;;th=th*2<mc_ncpu()?th*2:mc_ncpu()){
+		qmcstats st;
+		double I=qmc_integrate(expsum,NULL,20,lo,hi,1<<20,REPS,1,th,&st);
+		printf("%-8d %12.4g %12.4g %12.3g\n",th,st.seconds,st.nfev/st.seconds,fabs(I/expsum_exact(20)-1));
+		if(th==mc_ncpu()) break;
+	}
+	return 0;
+}
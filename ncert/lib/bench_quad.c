@@ -0,0 +1,58 @@
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include "quad.h"
+//Function evaluations and error for the 8.1.1 area under sqrt(x) on [1,4] (exact 14/3)
+//gcc -O2 -o bench_quad bench_quad.c quad.c cpu.c -lm -lpthread
+
+double now(){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC,&t);
+	return t.tv_sec+t.tv_nsec*1e-9;
+}
+
+static long count;
+double rootx(double x,void *ctx){
+	count++;
+	return sqrt(x);
+}
+void brootx(const double *x,double *y,int n,void *ctx){
+	count+=n;
+	for(int i=0;i<n;i++) y[i]=sqrt(x[i]);
+}
+//The original fixed 300000 step trapezoid, two sqrt per step
+double trapezoid(double x1,double x2){
+	int N=300000;
+	double h=(x2-x1)/N,A=0.0,x=x1;
+	for(int i=0;i<N;i++){
+		A+=((rootx(x+h,NULL)+rootx(x,NULL))/2)*h;
+		x+=h;
+	}
+	return A;
+}
+
+void report(const char *name,double A,double t){
+	printf("%-12s %10ld %12.3g %10.3g\n",name,count,fabs(A-14.0/3),t*1e6);
+	count=0;
+}
+
+int main(){
+	double t,A;
+	quadstats st;
+	printf("%-12s %10s %12s %10s\n","method","nfev","abs error","time(us)");
+	t=now();
+	A=trapezoid(1,4);
+	report("trapezoid",A,now()-t);
+	for(double tol=1e-6;tol>=1e-14;tol*=1e-4){
+		t=now();
+		A=quad_gk(rootx,NULL,1,4,tol,&st);
+		report("gk7/15",A,now()-t);
+		t=now();
+		A=quad_gk_batch(brootx,NULL,1,4,tol,&st);
+		report("gk batch",A,now()-t);
+		t=now();
+		A=quad_romberg(rootx,NULL,1,4,tol,&st);
+		report("romberg",A,now()-t);
+	}
+	return 0;
+}
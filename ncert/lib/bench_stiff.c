@@ -0,0 +1,164 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "bdf.h"
+#include "rk45.h"
+#include "euler.h"
+//Steps, right hand side evaluations and wall time of bdf() against explicit methods on stiff problems
+//Prothero-Robinson (scalar, against rk45 and euler), Robertson and Van der Pol mu=1000 (systems,
+//against fixed step forward Euler and RK4 near the largest stable step); errors against bdf at rtol 1e-10
+//gcc -O3 -o bench_stiff bench_stiff.c -L. -lncert -Wl,-rpath,'$ORIGIN' -lm -lpthread
+
+double now(){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC,&t);
+	return t.tv_sec+t.tv_nsec*1e-9;
+}
+
+#define LAMBDA 1e4
+
+//y'=-lambda(y-cos x)-sin x, solution cos x from y(0)=1
+static double pr(double x,double y,void *ctx){
+	(void)ctx;
+	return -LAMBDA*(y-cos(x))-sin(x);
+}
+static void prsys(double x,const double *y,double *dy,int n,void *ctx){
+	(void)n;
+	dy[0]=pr(x,y[0],ctx);
+}
+static void prjac(double x,const double *y,double *J,int n,void *ctx){
+	(void)x;
+	(void)y;
+	(void)n;
+	(void)ctx;
+	J[0]=-LAMBDA;
+}
+
+static void robertson(double x,const double *y,double *dy,int n,void *ctx){
+	(void)x;
+	(void)n;
+	(void)ctx;
+	dy[0]=-0.04*y[0]+1e4*y[1]*y[2];
+	dy[2]=3e7*y[1]*y[1];
+	dy[1]=-dy[0]-dy[2];
+}
+static void robertsonjac(double x,const double *y,double *J,int n,void *ctx){
+	(void)x;
+	(void)n;
+	(void)ctx;
+	double j[9]={-0.04,1e4*y[2],1e4*y[1],
+		0.04,-1e4*y[2]-6e7*y[1],-1e4*y[1],
+		0,6e7*y[1],0};
+	memcpy(J,j,sizeof(j));
+}
+
+#define MU 1000.0
+static void vanderpol(double x,const double *y,double *dy,int n,void *ctx){
+	(void)x;
+	(void)n;
+	(void)ctx;
+	dy[0]=y[1];
+	dy[1]=MU*(1-y[0]*y[0])*y[1]-y[0];
+}
+static void vanderpoljac(double x,const double *y,double *J,int n,void *ctx){
+	(void)x;
+	(void)n;
+	(void)ctx;
+	J[0]=0;
+	J[1]=1;
+	J[2]=-2*MU*y[0]*y[1]-1;
+	J[3]=MU*(1-y[0]*y[0]);
+}
+
+//Fixed step explicit baselines for systems of up to 4 equations
+static void eulersys(sysfunc f,int n,double x1,double *y,long nsteps){
+	double h=x1/nsteps,dy[4];
+	for(long s=0;s<nsteps;s++){
+		f(s*h,y,dy,n,NULL);
+		for(int i=0;i<n;i++) y[i]+=h*dy[i];
+	}
+}
+static void rk4sys(sysfunc f,int n,double x1,double *y,long nsteps){
+	double h=x1/nsteps,k1[4],k2[4],k3[4],k4[4],t[4];
+	for(long s=0;s<nsteps;s++){
+		double x=s*h;
+		f(x,y,k1,n,NULL);
+		for(int i=0;i<n;i++) t[i]=y[i]+h/2*k1[i];
+		f(x+h/2,t,k2,n,NULL);
+		for(int i=0;i<n;i++) t[i]=y[i]+h/2*k2[i];
+		f(x+h/2,t,k3,n,NULL);
+		for(int i=0;i<n;i++) t[i]=y[i]+h*k3[i];
+		f(x+h,t,k4,n,NULL);
+		for(int i=0;i<n;i++) y[i]+=h/6*(k1[i]+2*k2[i]+2*k3[i]+k4[i]);
+	}
+}
+
+static double maxerr(const double *a,const double *b,int n){
+	double e=0;
+	for(int i=0;i<n;i++){
+		if(!isfinite(a[i])) return NAN;
+		e=fmax(e,fabs(a[i]-b[i])/fmax(fabs(b[i]),1e-6));
+	}
+	return e;
+}
+
+static void row(const char *problem,const char *method,long steps,long nfev,double t,double err){
+	printf("%-18s %-22s %10ld %10ld %12.4g %12.3g\n",problem,method,steps,nfev,t,err);
+}
+
+//One system problem: bdf with a finite difference and an analytic Jacobian, then the explicit baselines
+static void stiff(const char *name,sysfunc f,jacfunc jac,int n,const double *y0,double x1,long eulersteps,long rk4steps){
+	double *work=(double*)malloc(BDF_WORK(n)*sizeof(double)),ref[4],y[4],t0;
+	bdfopts tight={1e-10,1e-14,0,0,10000000},o={1e-6,1e-10,0,0,1000000};
+	bdfstats st;
+	bdf(f,jac,NULL,n,0,y0,&x1,ref,1,&tight,work,&st);
+	t0=now();
+	bdf(f,NULL,NULL,n,0,y0,&x1,y,1,&o,work,&st);
+	row(name,"bdf, fd jacobian",st.accepted+st.rejected,st.nfev,now()-t0,maxerr(y,ref,n));
+	t0=now();
+	bdf(f,jac,NULL,n,0,y0,&x1,y,1,&o,work,&st);
+	row(name,"bdf, jacobian",st.accepted+st.rejected,st.nfev,now()-t0,maxerr(y,ref,n));
+	memcpy(y,y0,n*sizeof(double));
+	t0=now();
+	eulersys(f,n,x1,y,eulersteps);
+	row(name,"euler, stable h",eulersteps,eulersteps,now()-t0,maxerr(y,ref,n));
+	memcpy(y,y0,n*sizeof(double));
+	t0=now();
+	rk4sys(f,n,x1,y,rk4steps);
+	row(name,"rk4, stable h",rk4steps,4*rk4steps,now()-t0,maxerr(y,ref,n));
+	free(work);
+}
+
+int main(){
+	printf("%-18s %-22s %10s %10s %12s %12s\n","problem","method","steps","nfev","seconds","rel_err");
+	//Prothero-Robinson on [0,10], exact solution cos(10)
+	double x1=10,y0=1,y,t0,exact=cos(x1),work[BDF_WORK(1)];
+	bdfopts o={1e-6,1e-10,0,0,1000000};
+	bdfstats bs;
+	rk45opts ro={1e-6,1e-10,0,0,10000000};
+	rk45stats rs;
+	t0=now();
+	bdf(prsys,prjac,NULL,1,0,&y0,&x1,&y,1,&o,work,&bs);
+	row("prothero-robinson","bdf",bs.accepted+bs.rejected,bs.nfev,now()-t0,fabs(y-exact));
+	t0=now();
+	rk45(pr,NULL,0,y0,&x1,&y,1,&ro,&rs);
+	row("prothero-robinson","rk45",rs.accepted+rs.rejected,rs.nfev,now()-t0,fabs(y-exact));
+	//Forward Euler is stable for h<2/lambda
+	long n=(long)(x1*LAMBDA);
+	double *ys=(double*)malloc(n*sizeof(double)),*xs=(double*)malloc(n*sizeof(double));
+	t0=now();
+	euler(pr,NULL,0,y0,x1/(n-1),xs,1,ys,1,(int)n);
+	row("prothero-robinson","euler, h=1/lambda",n,n,now()-t0,fabs(ys[n-1]-exact));
+	free(ys);
+	free(xs);
+	//Robertson on [0,40]: the fast eigenvalue reaches about -3400 (Euler needs h<5.9e-4, RK4 h<8.2e-4)
+	static const double rob0[3]={1,0,0};
+	stiff("robertson",robertson,robertsonjac,3,rob0,40,100000,60000);
+	//Van der Pol, mu=1000 on [0,3000]: |lambda| is 3 mu on the slow branch and larger in the jumps,
+	//where Euler needs h<5e-4 to stay finite; the explicit errors are phase errors of the cycle
+	static const double vdp0[2]={2,0};
+	stiff("van der pol",vanderpol,vanderpoljac,2,vdp0,3000,10000000,4000000);
+	return 0;
+}
@@ -0,0 +1,19 @@
+#!/bin/bash
+# Builds libncert.so from every kernel in this directory, the benchmark suite,
+# and each ../*/codes/func.so linked against the library
+cd "$(dirname "$0")"
+CFLAGS="-O3 -Wall -fPIC"
+SRC="cpu.c stats.c expr.c npysink.c lu.c band.c sparse.c krylov.c eigen.c eigs.c newton.c gd.c lbfgs.c euler.c quad.c rk45.c bdf.c ensemble.c mc.c qmc.c alias.c arena.c"
+gcc $CFLAGS -shared -o libncert.so $SRC -lm -lpthread || exit 1
+gcc $CFLAGS -o bench bench.c -L. -lncert -Wl,-rpath,'$ORIGIN' -lm -lpthread || exit 1
+gcc $CFLAGS -o bench_prec bench_prec.c -L. -lncert -Wl,-rpath,'$ORIGIN' -lm -lpthread || exit 1
+gcc $CFLAGS -o bench_isa bench_isa.c -L. -lncert -Wl,-rpath,'$ORIGIN' -lm -lpthread || exit 1
+gcc $CFLAGS -o bench_expr bench_expr.c -L. -lncert -Wl,-rpath,'$ORIGIN' -lm -lpthread || exit 1
+gcc $CFLAGS -o bench_eigs bench_eigs.c -L. -lncert -Wl,-rpath,'$ORIGIN' -lm -lpthread || exit 1
+gcc $CFLAGS -o bench_stiff bench_stiff.c -L. -lncert -Wl,-rpath,'$ORIGIN' -lm -lpthread || exit 1
+gcc $CFLAGS -o bench_opt bench_opt.c -L. -lncert -Wl,-rpath,'$ORIGIN' -lm -lpthread || exit 1
+gcc $CFLAGS -o bench_qmc bench_qmc.c -L. -lncert -Wl,-rpath,'$ORIGIN' -lm -lpthread || exit 1
+gcc $CFLAGS -o bench_arena bench_arena.c -L. -lncert -Wl,-rpath,'$ORIGIN' -lm -lpthread -ldl || exit 1
+for d in ../*/codes; do
+	gcc $CFLAGS -shared -o $d/func.so $d/func.c -L. -lncert -Wl,-rpath,'$ORIGIN/../../lib' -lm -lpthread || exit 1
+done
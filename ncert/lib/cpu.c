@@ -0,0 +1,40 @@
+#include <stdlib.h>
+#include <string.h>
+#include "cpu.h"
+
+static const char *names[ISA_LEVELS]={"generic","avx2","avx512"};
+static int best=ISA_GENERIC,level=ISA_GENERIC;
+
+const char *cpu_isa_name(int l){
+	return l>=0&&l<ISA_LEVELS?names[l]:"unknown";
+}
+
+int cpu_isa(void){
+	return level;
+}
+
+int cpu_isa_best(void){
+	return best;
+}
+
+int cpu_set_isa(int l){
+	if(l<ISA_GENERIC) l=ISA_GENERIC;
+	level=l<best?l:best;	//a level above the CPU's would fault with SIGILL
+	return level;
+}
+
+//Runs when the library (or a program linking cpu.c) is loaded, before any kernel
+__attribute__((constructor)) static void cpu_init(void){
+#if defined(__x86_64__) && defined(__GNUC__)
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2")&&__builtin_cpu_supports("fma")) best=ISA_AVX2;
+	if(best==ISA_AVX2&&__builtin_cpu_supports("avx512f")&&__builtin_cpu_supports("avx512vl")&&__builtin_cpu_supports("avx512dq")) best=ISA_AVX512;
+#endif
+	level=best;
+	const char *env=getenv("NCERT_ISA");
+	if(env){
+		for(int l=0;l<ISA_LEVELS;l++){
+			if(strcmp(env,names[l])==0) cpu_set_isa(l);
+		}
+	}
+}
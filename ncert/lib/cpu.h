@@ -0,0 +1,39 @@
+#ifndef CPU_H
+#define CPU_H
+//Runtime instruction set dispatch for the hot loops in libncert
+//Each hot loop is compiled once per level and the level is picked once when the library loads:
+//the best one cpuid reports, or NCERT_ISA=generic|avx2|avx512 to force a lower one for testing
+
+enum{ISA_GENERIC,ISA_AVX2,ISA_AVX512,ISA_LEVELS};
+
+//Level in use, best level this CPU supports, and the name of a level
+int cpu_isa(void);
+int cpu_isa_best(void);
+const char *cpu_isa_name(int level);
+
+//Switches the level in use, clamped to what the CPU supports; returns the level now in use
+//Not thread safe, meant for benchmarks that compare levels in one process
+int cpu_set_isa(int level);
+
+//Hot loop bodies are written once as HOT functions and cloned per level with ISA_CLONES,
+//which defines name_isa[ISA_LEVELS], called as ISA_CALL(name)(args)
+//The body is inlined into each clone and so compiled for that clone's target
+#define HOT static inline __attribute__((always_inline))
+#if defined(__x86_64__) && defined(__GNUC__)
+#define ISA_ATTR_AVX2 __attribute__((target("avx2,fma")))
+#define ISA_ATTR_AVX512 __attribute__((target("avx512f,avx512vl,avx512dq,avx2,fma")))
+#else
+#define ISA_ATTR_AVX2
+#define ISA_ATTR_AVX512
+#endif
+#define ISA_CLONES(ret,name,params,args) ISA_CLONES_(ret,name,params,args,return)
+#define ISA_CLONES_VOID(name,params,args) ISA_CLONES_(void,name,params,args,)
+#define ISA_CLONES_(ret,name,params,args,ret_kw) ISA_CLONES__(ret,name,params,args,ret_kw)
+#define ISA_CLONES__(ret,name,params,args,ret_kw) \
+	static ret name##_generic params{ret_kw name args;} \
+	ISA_ATTR_AVX2 static ret name##_avx2 params{ret_kw name args;} \
+	ISA_ATTR_AVX512 static ret name##_avx512 params{ret_kw name args;} \
+	static ret (*const name##_isa[ISA_LEVELS]) params={name##_generic,name##_avx2,name##_avx512};
+#define ISA_CALL(name) ISA_CALL_(name)
+#define ISA_CALL_(name) name##_isa[cpu_isa()]
+#endif
@@ -0,0 +1,92 @@
+#ifndef DUAL_H
+#define DUAL_H
+#include <math.h>
+//Forward mode automatic differentiation using dual numbers
+//A dual number carries a value v and its derivative d, so one definition of f gives both f and f'
+typedef struct dual{
+	double v,d;
+}dual;
+//Single and extended precision duals for the float and long double kernels
+typedef struct dual_f{
+	float v,d;
+}dual_f;
+typedef struct dual_l{
+	long double v,d;
+}dual_l;
+
+//Constant (derivative 0) and variable (derivative 1) seeds
+static inline dual dconst(double c){
+	dual r={c,0};
+	return r;
+}
+static inline dual dvar(double x){
+	dual r={x,1};
+	return r;
+}
+
+//Arithmetic
+static inline dual dadd(dual a,dual b){
+	dual r={a.v+b.v,a.d+b.d};
+	return r;
+}
+static inline dual dsub(dual a,dual b){
+	dual r={a.v-b.v,a.d-b.d};
+	return r;
+}
+static inline dual dmul(dual a,dual b){
+	dual r={a.v*b.v,a.d*b.v+a.v*b.d};
+	return r;
+}
+static inline dual ddiv(dual a,dual b){
+	dual r={a.v/b.v,(a.d*b.v-a.v*b.d)/(b.v*b.v)};
+	return r;
+}
+static inline dual dscale(dual a,double c){
+	dual r={a.v*c,a.d*c};
+	return r;
+}
+
+//Elementary functions (chain rule)
+static inline dual dexp(dual a){
+	double e=exp(a.v);
+	dual r={e,e*a.d};
+	return r;
+}
+static inline dual dsin(dual a){
+	dual r={sin(a.v),cos(a.v)*a.d};
+	return r;
+}
+static inline dual dcos(dual a){
+	dual r={cos(a.v),-sin(a.v)*a.d};
+	return r;
+}
+static inline dual dsqrt(dual a){
+	double s=sqrt(a.v);
+	dual r={s,a.d/(2*s)};
+	return r;
+}
+static inline dual dlog(dual a){
+	dual r={log(a.v),a.d/a.v};
+	return r;
+}
+
+//Horner evaluation of c[0]*x^(n-1)+c[1]*x^(n-2)+...+c[n-1]
+//Called with a constant coefficient array, the loop is fully unrolled by the compiler
+static inline double horner(const double *c,int n,double x){
+	double p=c[0];
+	for(int i=1;i<n;i++){
+		p=p*x+c[i];
+	}
+	return p;
+}
+
+//Fused Horner: value and derivative of the polynomial in a single pass
+static inline dual dhorner(const double *c,int n,double x){
+	dual p={c[0],0};
+	for(int i=1;i<n;i++){
+		p.d=p.d*x+p.v;
+		p.v=p.v*x+c[i];
+	}
+	return p;
+}
+#endif
@@ -0,0 +1,117 @@
+#include <math.h>
+#include "eigen.h"
+#include "cpu.h"
+
+//Eigenvalue of [[a,b],[c,d]] closest to d
+static double complex wilkinson(double complex a,double complex b,double complex c,double complex d){
+	double complex delta=(a-d)/2,disc=csqrt(delta*delta+b*c);
+	double complex mu1=d+delta+disc,mu2=d+delta-disc;
+	return cabs(mu1-d)<cabs(mu2-d)?mu1:mu2;
+}
+
+//t=RQ on the leading m x m block (row stride n), R upper triangular so row i sums from k=i
+//Runs over rows of q in real arithmetic so the inner loop vectorises, cloned per level (see cpu.h)
+HOT void rqgemm(const double complex *A,int n,int m,const double complex *q,double complex *t){
+	for(int i=0;i<m;i++){
+		double *ti=(double*)(t+(long)i*n);
+		for(int j=0;j<2*m;j++) ti[j]=0;
+		for(int k=i;k<m;k++){
+			double ar=creal(A[(long)i*n+k]),ai=cimag(A[(long)i*n+k]);
+			const double *qk=(const double*)(q+(long)k*n);
+			for(int j=0;j<2*m;j+=2){
+				ti[j]+=ar*qk[j]-ai*qk[j+1];
+				ti[j+1]+=ar*qk[j+1]+ai*qk[j];
+			}
+		}
+	}
+}
+ISA_CLONES_VOID(rqgemm,(const double complex *A,int n,int m,const double complex *q,double complex *t),(A,n,m,q,t))
+
+//A[0..m-1][0..m-1]=RQ for the QR decomposition of the leading m x m block (row stride n)
+//Q is accumulated in q, v is one Householder vector, t holds the product
+static void qrstep(double complex *A,int n,int m,double complex *q,double complex *t,double complex *v){
+	for(int i=0;i<m;i++){
+		for(int j=0;j<m;j++){
+			q[i*n+j]=(i==j);
+		}
+	}
+	for(int k=0;k<m-1;k++){
+		double norm=0;
+		for(int i=k;i<m;i++){
+			v[i]=A[i*n+k];
+			norm+=creal(v[i]*conj(v[i]));
+		}
+		norm=sqrt(norm);
+		if(norm==0) continue;
+		//Reflect x onto -e^{i arg x0}|x| e1 to avoid cancellation
+		double complex phase=cabs(v[k])>0?v[k]/cabs(v[k]):1;
+		v[k]+=phase*norm;
+		double vn=0;
+		for(int i=k;i<m;i++) vn+=creal(v[i]*conj(v[i]));
+		vn=sqrt(vn);
+		for(int i=k;i<m;i++) v[i]/=vn;
+		//R=(I-2vv*)R on rows k..m-1
+		for(int j=k;j<m;j++){
+			double complex s=0;
+			for(int i=k;i<m;i++) s+=conj(v[i])*A[i*n+j];
+			for(int i=k;i<m;i++) A[i*n+j]-=2*v[i]*s;
+		}
+		//Q=Q(I-2vv*) on columns k..m-1
+		for(int i=0;i<m;i++){
+			double complex s=0;
+			for(int j=k;j<m;j++) s+=q[i*n+j]*v[j];
+			for(int j=k;j<m;j++) q[i*n+j]-=2*s*conj(v[j]);
+		}
+	}
+	ISA_CALL(rqgemm)(A,n,m,q,t);
+	for(int i=0;i<m;i++){
+		for(int j=0;j<m;j++){
+			A[i*n+j]=t[i*n+j];
+		}
+	}
+}
+
+int qr_eigen(double complex *A,int n,double complex *eig,double complex *work,int maxiter,kstats *st){
+	double t0=kstats_begin(st);
+	double complex *q=work,*t=work+n*n,*v=work+2*n*n;
+	double norm=0;
+	for(int i=0;i<n*n;i++) norm+=creal(A[i]*conj(A[i]));
+	double tol=1e-14*sqrt(norm);
+	int m=n,it=0,stall=0;
+	while(m>1){
+		//The last row of the active block has converged when its off-diagonal part vanishes
+		double off=0;
+		for(int j=0;j<m-1;j++) off+=cabs(A[(m-1)*n+j]);
+		if(off<=tol){
+			eig[m-1]=A[(m-1)*n+m-1];
+			m--;
+			stall=0;
+			if(st){
+				st->deflations++;
+				if(off>st->residual) st->residual=off;
+			}
+			continue;
+		}
+		if(it>=maxiter) break;
+		double complex mu=wilkinson(A[(m-2)*n+m-2],A[(m-2)*n+m-1],A[(m-1)*n+m-2],A[(m-1)*n+m-1]);
+		//Exceptional shift if the block is cycling
+		if(++stall%11==0) mu+=off;
+		for(int i=0;i<m;i++) A[i*n+i]-=mu;
+		qrstep(A,n,m,q,t,v);
+		for(int i=0;i<m;i++) A[i*n+i]+=mu;
+		it++;
+		KTRACE(st,"qr_eigen",it,off);
+	}
+	//Unconverged rows fall back to the diagonal
+	for(int i=0;i<m;i++) eig[i]=A[i*n+i];
+	if(st){
+		st->iterations=it;
+		if(m>1){
+			double off=0;
+			for(int j=0;j<m-1;j++) off+=cabs(A[(m-1)*n+j]);
+			st->residual=off;
+		}
+	}
+	kstats_end(st,t0);
+	return m>1?-1:it;
+}
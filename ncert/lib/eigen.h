@@ -0,0 +1,15 @@
+#ifndef EIGEN_H
+#define EIGEN_H
+#include <complex.h>
+#include "stats.h"
+//Eigenvalues of a dense complex matrix by the shifted QR algorithm
+//Householder QR, Wilkinson shift from the trailing 2x2 block, deflation of converged rows
+
+//Complex scratch needed by qr_eigen for an n x n matrix
+#define QR_WORK(n) (2*(n)*(n)+(n))
+
+//A (n x n, row-major) is overwritten; eigenvalues go to eig[0..n-1]
+//work must hold QR_WORK(n) values, returns the number of iterations or -1 if maxiter ran out
+//st (may be NULL) receives iterations, deflations, the residual and the wall time, nfev stays 0
+int qr_eigen(double complex *A,int n,double complex *eig,double complex *work,int maxiter,kstats *st);
+#endif
@@ -0,0 +1,422 @@
+#include <math.h>
+#include <string.h>
+#include "eigs.h"
+#include "eigen.h"
+#include "rng.h"
+#include "mc.h"
+#include "krylov.h"
+
+//Passes over the rows of the basis, split between threads; column c of the basis is V+c*n
+enum{DOTS,SUBDOTS,SUBNORM,SCALE,RESTART};
+
+typedef struct pass{
+	int op;
+	double *V,*w;		//basis and the vector being orthogonalised against columns 0..j
+	long n;
+	int j,m,kk;
+	const double *h;	//coefficients to subtract, or the scale factor in h[0]
+	double *part;		//partial sums, stride m+1 per thread
+	const double *Q;	//restart: columns 0..kk of VQ, then f=(VQ)e_kk*hsub+V_m*fq goes to column kk
+	double hsub,fq;
+	long lo,hi;
+	int t;
+}pass;
+
+static void *run(void *arg){
+	pass *p=(pass*)arg;
+	long lo=p->lo,len=p->hi-p->lo,n=p->n;
+	double *w=p->w+lo,*part=p->part+p->t*(p->m+1);
+	switch(p->op){
+	case SUBDOTS:
+	case SUBNORM:
+		for(int i=0;i<=p->j;i++){
+			const double *v=p->V+i*n+lo;
+			double h=p->h[i];
+			for(long r=0;r<len;r++) w[r]-=h*v[r];
+		}
+		if(p->op==SUBNORM){
+			part[0]=krylov_dot(w,w,len);
+			break;
+		}
+		//fall through
+	case DOTS:
+		for(int i=0;i<=p->j;i++){
+			part[i]=krylov_dot(p->V+i*n+lo,w,len);
+		}
+		break;
+	case SCALE:
+		for(long r=0;r<len;r++) w[r]*=p->h[0];
+		break;
+	case RESTART:{
+		double t[EIGS_MAXM+1];
+		int m=p->m,kk=p->kk;
+		for(long r=lo;r<p->hi;r++){
+			for(int c=0;c<=kk;c++) t[c]=0;
+			for(int i=0;i<m;i++){
+				double v=p->V[i*n+r];
+				const double *q=p->Q+i*m;
+				for(int c=0;c<=kk;c++) t[c]+=v*q[c];
+			}
+			t[kk]=t[kk]*p->hsub+p->V[m*n+r]*p->fq;
+			for(int c=0;c<=kk;c++) p->V[c*n+r]=t[c];
+		}
+		break;
+	}
+	}
+	return NULL;
+}
+
+//Runs the pass on every row block, block 0 on the calling thread, and sums the partial sums into sum
+static void rows(pass *p,int nthreads,double *sum,int nsum){
+	pass jobs[MC_MAXTHREADS];
+	for(int t=0;t<nthreads;t++){
+		jobs[t]=*p;
+		jobs[t].lo=p->n*t/nthreads;
+		jobs[t].hi=p->n*(t+1)/nthreads;
+		jobs[t].t=t;
+	}
+	parallel_for(nthreads,run,jobs,sizeof(pass));
+	for(int i=0;i<nsum;i++){
+		sum[i]=0;
+		for(int t=0;t<nthreads;t++) sum[i]+=p->part[t*(p->m+1)+i];
+	}
+}
+
+//Working state of one solve
+typedef struct eigs{
+	matvec A;
+	void *ctx;
+	long n;
+	int m,sym,nthreads;
+	double *V,*H,*Q,*Qs,*M,*T,*part;
+	double complex *Z,*qw,*ritz,*y;
+	rng gen;
+	long nfev;
+}eigs;
+
+//w is orthogonalised against columns 0..j twice (classical Gram-Schmidt), h gets the coefficients
+//Returns |w|
+static double orthogonalise(eigs *e,double *w,int j,double *h){
+	double h1[EIGS_MAXM+1],h2[EIGS_MAXM+1],nrm;
+	pass p={DOTS,e->V,w,e->n,j,e->m,0,h1,e->part,NULL,0,0,0,0,0};
+	rows(&p,e->nthreads,h1,j+1);
+	p.op=SUBDOTS;
+	rows(&p,e->nthreads,h2,j+1);
+	p.op=SUBNORM;
+	p.h=h2;
+	rows(&p,e->nthreads,&nrm,1);
+	for(int i=0;i<=j;i++) h[i]=h1[i]+h2[i];
+	return sqrt(nrm);
+}
+
+static void scale(eigs *e,double *w,double s){
+	pass p={SCALE,e->V,w,e->n,0,e->m,0,&s,e->part,NULL,0,0,0,0,0};
+	rows(&p,e->nthreads,NULL,0);
+}
+
+//Column j+1 becomes a unit vector orthogonal to columns 0..j: w/|w|, or a fresh random
+//direction if w is numerically in their span; returns the norm of w or 0 in the second case
+static double extendbasis(eigs *e,int j,double *h,double hnorm){
+	double *w=e->V+(long)(j+1)*e->n;
+	double beta=orthogonalise(e,w,j,h),hh[EIGS_MAXM+1];
+	if(beta>1e-12*hnorm){
+		scale(e,w,1/beta);
+		return beta;
+	}
+	for(int tries=0;tries<3;tries++){
+		for(long r=0;r<e->n;r++) w[r]=rng_double(&e->gen)-0.5;
+		double b=orthogonalise(e,w,j,hh);
+		if(b>0){
+			scale(e,w,1/b);
+			break;
+		}
+	}
+	return 0;
+}
+
+//Arnoldi steps j0..m-1, fnorm gets |f| of AV=VH+fe_m' with f/|f| kept in column m
+static void extend(eigs *e,int j0,double *fnorm){
+	int m=e->m;
+	double h[EIGS_MAXM+1],hnorm=0;
+	for(int i=0;i<m*m;i++) hnorm+=e->H[i]*e->H[i];
+	for(int j=j0;j<m;j++){
+		e->A(e->V+(long)j*e->n,e->V+(long)(j+1)*e->n,e->n,e->ctx);
+		e->nfev++;
+		double beta=extendbasis(e,j,h,sqrt(hnorm)+1);
+		if(e->sym){
+			//Only the tridiagonal part is kept, the rest is rounding after reorthogonalisation
+			e->H[j*m+j]=h[j];
+			if(j>0) e->H[(j-1)*m+j]=e->H[j*m+j-1];
+		}else{
+			for(int i=0;i<=j;i++) e->H[i*m+j]=h[i];
+		}
+		if(j+1<m) e->H[(j+1)*m+j]=beta;
+		else *fnorm=beta;
+		for(int i=0;i<=j;i++) hnorm+=h[i]*h[i];
+		hnorm+=beta*beta;
+	}
+}
+
+//Sort key for the wanted end of the spectrum, smallest first
+static double key(double complex z,int which){
+	switch(which){
+	case EIGS_SM: return cabs(z);
+	case EIGS_LR: return -creal(z);
+	case EIGS_SR: return creal(z);
+	default: return -cabs(z);
+	}
+}
+
+static int conjugates(double complex a,double complex b){
+	return cimag(a)!=0&&cabs(a-conj(b))<=1e-8*cabs(a);
+}
+
+//Ritz values of H into e->ritz, wanted ones first
+static void ritz(eigs *e,int which){
+	int m=e->m;
+	for(int i=0;i<m*m;i++) e->Z[i]=e->H[i];
+	qr_eigen(e->Z,m,e->ritz,e->qw,100*m,NULL);
+	if(e->sym){
+		for(int i=0;i<m;i++) e->ritz[i]=creal(e->ritz[i]);
+	}
+	for(int i=1;i<m;i++){
+		double complex z=e->ritz[i];
+		double kz=key(z,which);
+		int j=i-1;
+		while(j>=0&&(key(e->ritz[j],which)>kz||(key(e->ritz[j],which)==kz&&cimag(e->ritz[j])<cimag(z)))){
+			e->ritz[j+1]=e->ritz[j];
+			j--;
+		}
+		e->ritz[j+1]=z;
+	}
+	//Keys of a conjugate pair differ by rounding, so put the positive imaginary part first here
+	for(int i=0;i+1<m;i++){
+		if(conjugates(e->ritz[i],e->ritz[i+1])&&cimag(e->ritz[i])<0){
+			double complex z=e->ritz[i];
+			e->ritz[i]=e->ritz[i+1];
+			e->ritz[i+1]=z;
+			i++;
+		}
+	}
+}
+
+//Eigenvector y of H for the Ritz value th by two steps of inverse iteration with partial pivoting
+static void ritzvec(eigs *e,double complex th,double hnorm){
+	int m=e->m,piv[EIGS_MAXM];
+	double complex *Z=e->Z,*y=e->y;
+	double eps=1e-14*hnorm+1e-300;
+	th+=eps;	//keeps H-th I invertible when th is exact
+	for(int i=0;i<m*m;i++) Z[i]=e->H[i];
+	for(int i=0;i<m;i++) Z[i*m+i]-=th;
+	for(int c=0;c<m;c++){
+		int p=c;
+		for(int r=c+1;r<m;r++) if(cabs(Z[r*m+c])>cabs(Z[p*m+c])) p=r;
+		piv[c]=p;
+		if(p!=c){
+			for(int j=0;j<m;j++){
+				double complex t=Z[c*m+j];
+				Z[c*m+j]=Z[p*m+j];
+				Z[p*m+j]=t;
+			}
+		}
+		if(cabs(Z[c*m+c])<eps) Z[c*m+c]=eps;
+		for(int r=c+1;r<m;r++){
+			double complex l=Z[r*m+c]/Z[c*m+c];
+			Z[r*m+c]=l;
+			for(int j=c+1;j<m;j++) Z[r*m+j]-=l*Z[c*m+j];
+		}
+	}
+	for(int i=0;i<m;i++) y[i]=1;
+	for(int it=0;it<2;it++){
+		for(int c=0;c<m;c++){
+			double complex t=y[c];
+			y[c]=y[piv[c]];
+			y[piv[c]]=t;
+			for(int r=c+1;r<m;r++) y[r]-=Z[r*m+c]*y[c];
+		}
+		for(int i=m-1;i>=0;i--){
+			double complex s=y[i];
+			for(int j=i+1;j<m;j++) s-=Z[i*m+j]*y[j];
+			y[i]=s/Z[i*m+i];
+		}
+		double nrm=0;
+		for(int i=0;i<m;i++) nrm+=creal(y[i]*conj(y[i]));
+		nrm=sqrt(nrm);
+		for(int i=0;i<m;i++) y[i]/=nrm;
+	}
+}
+
+//H=Qs'HQs and Q=Q Qs for the Householder QR Qs R of M=p(H), p(x)=x-s or x^2-s x+t
+static void shift(eigs *e,double s,double t,int quadratic){
+	int m=e->m;
+	double *H=e->H,*M=e->M,*Qs=e->Qs,*T=e->T,v[EIGS_MAXM];
+	for(int i=0;i<m;i++){
+		for(int j=0;j<m;j++){
+			double x=quadratic?0:H[i*m+j];
+			if(quadratic){
+				for(int k=0;k<m;k++) x+=H[i*m+k]*H[k*m+j];
+				x-=s*H[i*m+j];
+			}
+			M[i*m+j]=x+(i==j)*(quadratic?t:-s);
+			Qs[i*m+j]=(i==j);
+		}
+	}
+	for(int k=0;k<m-1;k++){
+		double norm=0;
+		for(int i=k;i<m;i++){
+			v[i]=M[i*m+k];
+			norm+=v[i]*v[i];
+		}
+		norm=sqrt(norm);
+		if(norm==0) continue;
+		v[k]+=v[k]<0?-norm:norm;
+		double vn=0;
+		for(int i=k;i<m;i++) vn+=v[i]*v[i];
+		vn=sqrt(vn);
+		for(int i=k;i<m;i++) v[i]/=vn;
+		for(int j=k;j<m;j++){
+			double d=0;
+			for(int i=k;i<m;i++) d+=v[i]*M[i*m+j];
+			for(int i=k;i<m;i++) M[i*m+j]-=2*v[i]*d;
+		}
+		for(int i=0;i<m;i++){
+			double d=0;
+			for(int j=k;j<m;j++) d+=Qs[i*m+j]*v[j];
+			for(int j=k;j<m;j++) Qs[i*m+j]-=2*d*v[j];
+		}
+	}
+	//T=HQs, H=Qs'T, then Q=Q Qs through T
+	for(int i=0;i<m;i++){
+		for(int j=0;j<m;j++){
+			double x=0;
+			for(int k=0;k<m;k++) x+=H[i*m+k]*Qs[k*m+j];
+			T[i*m+j]=x;
+		}
+	}
+	for(int i=0;i<m;i++){
+		for(int j=0;j<m;j++){
+			double x=0;
+			for(int k=0;k<m;k++) x+=Qs[k*m+i]*T[k*m+j];
+			H[i*m+j]=x;
+		}
+	}
+	for(int i=0;i<m;i++){
+		for(int j=0;j<m;j++){
+			double x=0;
+			for(int k=0;k<m;k++) x+=e->Q[i*m+k]*Qs[k*m+j];
+			T[i*m+j]=x;
+		}
+	}
+	memcpy(e->Q,T,(size_t)m*m*sizeof(double));
+}
+
+static int solve(matvec A,void *ctx,long n,int k,int m,int which,int sym,double tol,int maxiter,
+	double complex *eig,double *work,int nthreads,kstats *st){
+	double t0=kstats_begin(st);
+	if(k<1||k+1>=m||m>EIGS_MAXM||m>n){
+		kstats_end(st,t0);
+		return -1;
+	}
+	eigs e;
+	e.A=A;
+	e.ctx=ctx;
+	e.n=n;
+	e.m=m;
+	e.sym=sym;
+	e.nthreads=nthreads;
+	if(e.nthreads>MC_MAXTHREADS) e.nthreads=MC_MAXTHREADS;
+	if(e.nthreads>n/EIGS_CHUNK) e.nthreads=(int)(n/EIGS_CHUNK);
+	if(e.nthreads<1) e.nthreads=1;
+	e.V=work;
+	e.H=e.V+(long)(m+1)*n;
+	e.Q=e.H+m*m;
+	e.Qs=e.Q+m*m;
+	e.M=e.Qs+m*m;
+	e.T=e.M+m*m;
+	e.part=e.T+m*m;
+	e.Z=(double complex*)(e.part+MC_MAXTHREADS*(m+1));
+	e.qw=e.Z+m*m;
+	e.ritz=e.qw+QR_WORK(m);
+	e.y=e.ritz+m;
+	e.nfev=0;
+	rng_init(&e.gen,2024,0);
+	memset(e.H,0,(size_t)m*m*sizeof(double));
+	for(long r=0;r<n;r++) e.V[r]=rng_double(&e.gen)-0.5;
+	scale(&e,e.V,1/sqrt(krylov_dot(e.V,e.V,n)));
+	double fnorm=0,worst=0;
+	int it=0,j0=0,done=0;
+	for(;;){
+		extend(&e,j0,&fnorm);
+		ritz(&e,which);
+		double hnorm=0;
+		for(int i=0;i<m*m;i++) hnorm+=e.H[i]*e.H[i];
+		hnorm=sqrt(hnorm);
+		//Ritz residual |f||e_m'y| of each wanted value
+		worst=0;
+		for(int i=0;i<k;i++){
+			ritzvec(&e,e.ritz[i],hnorm);
+			double a=cabs(e.ritz[i]),r=fnorm*cabs(e.y[m-1])/(a>0?a:1);
+			if(r>worst) worst=r;
+		}
+		KTRACE(st,sym?"lanczos_eigs":"arnoldi_eigs",it,worst);
+		if(worst<=tol){
+			done=1;
+			break;
+		}
+		if(it>=maxiter) break;
+		it++;
+		//Keep conjugate pairs together, then apply the unwanted values as shifts
+		int kk=k;
+		if(!sym&&conjugates(e.ritz[k-1],e.ritz[k])) kk++;
+		for(int i=0;i<m;i++){
+			for(int j=0;j<m;j++) e.Q[i*m+j]=(i==j);
+		}
+		for(int i=kk;i<m;i++){
+			double complex z=e.ritz[i];
+			if(!sym&&i+1<m&&conjugates(z,e.ritz[i+1])){
+				shift(&e,2*creal(z),creal(z*conj(z)),1);
+				i++;
+			}else{
+				shift(&e,creal(z),0,0);
+			}
+		}
+		//The compressed factorisation AV_kk=V_kk H_kk+f e_kk' with V=VQ and f=(VQ)e_kk h+f Q[m-1][kk-1]
+		double h[EIGS_MAXM+1];
+		pass p={RESTART,e.V,NULL,n,0,m,kk,NULL,e.part,e.Q,e.H[kk*m+kk-1],fnorm*e.Q[(m-1)*m+kk-1],0,0,0};
+		rows(&p,e.nthreads,NULL,0);
+		//H below the subdiagonal (and outside the tridiagonal for Lanczos) holds only rounding
+		for(int i=0;i<m;i++){
+			for(int j=0;j<m;j++){
+				if(i>j+1||i>=kk||j>=kk||(sym&&j>i+1)) e.H[i*m+j]=0;
+			}
+		}
+		if(sym){
+			for(int j=0;j+1<kk;j++) e.H[j*m+j+1]=e.H[(j+1)*m+j];
+		}
+		//f is orthogonal to V_kk in exact arithmetic, once more here
+		double beta=extendbasis(&e,kk-1,h,hnorm+1);
+		e.H[kk*m+kk-1]=beta;
+		j0=kk;
+	}
+	for(int i=0;i<k;i++) eig[i]=e.ritz[i];
+	if(st){
+		st->iterations=it;
+		st->nfev=e.nfev;
+		st->residual=worst;
+	}
+	kstats_end(st,t0);
+	return done?it:-1;
+}
+
+int lanczos_eigs(matvec A,void *ctx,long n,int k,int m,int which,double tol,int maxiter,
+	double *eig,double *work,int nthreads,kstats *st){
+	double complex z[EIGS_MAXM]={0};
+	int ret=solve(A,ctx,n,k,m,which,1,tol,maxiter,z,work,nthreads,st);
+	for(int i=0;i<k&&i<EIGS_MAXM;i++) eig[i]=creal(z[i]);
+	return ret;
+}
+
+int arnoldi_eigs(matvec A,void *ctx,long n,int k,int m,int which,double tol,int maxiter,
+	double complex *eig,double *work,int nthreads,kstats *st){
+	return solve(A,ctx,n,k,m,which,0,tol,maxiter,eig,work,nthreads,st);
+}
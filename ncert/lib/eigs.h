@@ -0,0 +1,33 @@
+#ifndef EIGS_H
+#define EIGS_H
+#include <complex.h>
+#include "krylov.h"
+//A few eigenvalues of a large operator seen only through a matvec (see krylov.h)
+//Implicitly restarted Arnoldi: an m step Krylov factorisation AV=VH+fe_m' is compressed to the
+//k wanted Ritz values with the m-k unwanted ones as exact shifts, then extended to m steps again
+//The Ritz values of the small m x m H come from qr_eigen in eigen.h
+
+//Which end of the spectrum is wanted
+enum{EIGS_LM,EIGS_SM,EIGS_LR,EIGS_SR};	//largest or smallest magnitude, largest or smallest real part
+
+//Largest Krylov dimension m
+#define EIGS_MAXM 256
+//Rows per thread below which orthogonalisation uses fewer threads
+#define EIGS_CHUNK 16384
+
+//Doubles of work for an n dimensional operator and m Krylov vectors (basis, then the small matrices)
+#define EIGS_WORK(n,m) ((long)((m)+1)*(n)+11L*(m)*(m)+70L*(m)+64)
+
+//Symmetric A (Lanczos): H is kept tridiagonal and the eigenvalues are real, eig[0..k-1]
+//Non-symmetric A (Arnoldi): complex conjugate shifts are applied in pairs in real arithmetic,
+//a conjugate pair is never split between the kept and the discarded Ritz values
+//Both need k<m<=EIGS_MAXM and m<=n (2k+1 to 2k+20 is usual), take the k wanted values in the order
+//of which, stop when every Ritz residual |f||e_m'y| is at most tol*|theta|, and return the
+//number of restarts or -1 if maxiter restarts did not converge (eig then holds the estimates)
+//Basis vectors are orthogonalised twice by classical Gram-Schmidt, split by rows over nthreads
+//kstats gets the restarts, the products with A in nfev and the largest relative Ritz residual
+int lanczos_eigs(matvec A,void *ctx,long n,int k,int m,int which,double tol,int maxiter,
+	double *eig,double *work,int nthreads,kstats *st);
+int arnoldi_eigs(matvec A,void *ctx,long n,int k,int m,int which,double tol,int maxiter,
+	double complex *eig,double *work,int nthreads,kstats *st);
+#endif
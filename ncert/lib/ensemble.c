@@ -0,0 +1,16 @@
+#include "ensemble.h"
+#include "cpu.h"
+#include "mc.h"
+
+#define PREC 'f'
+#include "scalar.h"
+#include "ensemble_impl.h"
+#undef PREC
+#define PREC 'd'
+#include "scalar.h"
+#include "ensemble_impl.h"
+#undef PREC
+#define PREC 'l'
+#include "scalar.h"
+#include "ensemble_impl.h"
+#undef PREC
@@ -0,0 +1,22 @@
+#ifndef ENSEMBLE_H
+#define ENSEMBLE_H
+//Lockstep RK4 integration of many trajectories of the same ODE y'=f(x,y)
+//All trajectories share the x grid, state is one array of y values (structure of arrays)
+
+//Batch right hand side: dy[i]=f(x,y[i]) for i<n
+typedef void (*batchfunc)(double x,const double *y,double *dy,int n,void *ctx);
+
+//Trajectories are processed in blocks of this many lanes so the stage arrays stay in L1/L2
+#define ENS_BLOCK 512
+
+//Advances y[0..n-1] from x0 to x1 in nsteps RK4 steps, in place
+//nthreads<=1 runs on the calling thread, otherwise blocks are split across threads
+//Returns 0, or -1 if a worker thread could not be started (its share is then run inline)
+int ensemble_rk4(batchfunc f,void *ctx,double x0,double x1,int nsteps,double *y,int n,int nthreads);
+
+//The same in float (_f), twice the lanes per vector, and long double (_l)
+typedef void (*batchfunc_f)(float x,const float *y,float *dy,int n,void *ctx);
+typedef void (*batchfunc_l)(long double x,const long double *y,long double *dy,int n,void *ctx);
+int ensemble_rk4_f(batchfunc_f f,void *ctx,float x0,float x1,int nsteps,float *y,int n,int nthreads);
+int ensemble_rk4_l(batchfunc_l f,void *ctx,long double x0,long double x1,int nsteps,long double *y,int n,int nthreads);
+#endif
@@ -0,0 +1,73 @@
+//Generic lockstep RK4 body, instantiated by ensemble.c for each precision (see scalar.h)
+
+//t[i]=y[i]+a*k[i]
+HOT void FN(axpy)(T *restrict t,const T *restrict y,const T *restrict k,T a,int n){
+	for(int i=0;i<n;i++){
+		t[i]=y[i]+a*k[i];
+	}
+}
+ISA_CLONES_VOID(FN(axpy),(T *restrict t,const T *restrict y,const T *restrict k,T a,int n),(t,y,k,a,n))
+
+//y[i]+=h/6*(k1+2k2+2k3+k4)
+HOT void FN(rk4sum)(T *restrict y,const T *restrict k1,const T *restrict k2,const T *restrict k3,const T *restrict k4,T h,int n){
+	T c=h/6;
+	for(int i=0;i<n;i++){
+		y[i]+=c*(k1[i]+2*(k2[i]+k3[i])+k4[i]);
+	}
+}
+ISA_CLONES_VOID(FN(rk4sum),(T *restrict y,const T *restrict k1,const T *restrict k2,const T *restrict k3,const T *restrict k4,T h,int n),(y,k1,k2,k3,k4,h,n))
+
+//Integrates one block of at most ENS_BLOCK lanes through every step
+static void FN(block)(FN(batchfunc) f,void *ctx,T x0,T h,int nsteps,T *y,int n){
+	T k1[ENS_BLOCK],k2[ENS_BLOCK],k3[ENS_BLOCK],k4[ENS_BLOCK],t[ENS_BLOCK];
+	for(int s=0;s<nsteps;s++){
+		T x=x0+s*h;	//no drift from repeated x+=h
+		f(x,y,k1,n,ctx);
+		ISA_CALL(FN(axpy))(t,y,k1,h/2,n);
+		f(x+h/2,t,k2,n,ctx);
+		ISA_CALL(FN(axpy))(t,y,k2,h/2,n);
+		f(x+h/2,t,k3,n,ctx);
+		ISA_CALL(FN(axpy))(t,y,k3,h,n);
+		f(x+h,t,k4,n,ctx);
+		ISA_CALL(FN(rk4sum))(y,k1,k2,k3,k4,h,n);
+	}
+}
+
+//Share of the ensemble given to one thread
+typedef struct FN(job){
+	FN(batchfunc) f;
+	void *ctx;
+	T x0,h;
+	int nsteps,n;
+	T *y;
+}FN(job);
+
+static void *FN(run)(void *arg){
+	FN(job) *j=(FN(job)*)arg;
+	for(int i=0;i<j->n;i+=ENS_BLOCK){
+		int m=j->n-i<ENS_BLOCK?j->n-i:ENS_BLOCK;
+		FN(block)(j->f,j->ctx,j->x0,j->h,j->nsteps,j->y+i,m);
+	}
+	return NULL;
+}
+
+int FN(ensemble_rk4)(FN(batchfunc) f,void *ctx,T x0,T x1,int nsteps,T *y,int n,int nthreads){
+	T h=(x1-x0)/nsteps;
+	int nblocks=(n+ENS_BLOCK-1)/ENS_BLOCK;
+	if(nthreads>MC_MAXTHREADS) nthreads=MC_MAXTHREADS;
+	if(nthreads>nblocks) nthreads=nblocks;
+	if(nthreads<=1){
+		FN(job) j={f,ctx,x0,h,nsteps,n,y};
+		FN(run)(&j);
+		return 0;
+	}
+	//Whole blocks per thread so no two threads touch the same cache lines
+	FN(job) jobs[MC_MAXTHREADS];
+	for(int t=0;t<nthreads;t++){
+		int b0=nblocks*t/nthreads,b1=nblocks*(t+1)/nthreads;
+		int lo=b0*ENS_BLOCK,hi=b1*ENS_BLOCK<n?b1*ENS_BLOCK:n;
+		FN(job) j={f,ctx,x0,h,nsteps,hi-lo,y+lo};
+		jobs[t]=j;
+	}
+	return parallel_for(nthreads,FN(run),jobs,sizeof(FN(job)));
+}
@@ -0,0 +1,14 @@
+#include "euler.h"
+
+#define PREC 'f'
+#include "scalar.h"
+#include "euler_impl.h"
+#undef PREC
+#define PREC 'd'
+#include "scalar.h"
+#include "euler_impl.h"
+#undef PREC
+#define PREC 'l'
+#include "scalar.h"
+#include "euler_impl.h"
+#undef PREC
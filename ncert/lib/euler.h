@@ -0,0 +1,14 @@
+#ifndef EULER_H
+#define EULER_H
+#include "rk45.h"
+//Fixed step forward Euler for y'=f(x,y) into caller buffers
+
+//x_i goes to xs[i*xstride] and y_i to ys[i*ystride] for i<n, returns -1 if n<1
+int euler(odefunc f,void *ctx,double x0,double y0,double h,double *xs,long xstride,double *ys,long ystride,int n);
+
+//The same in float (_f) and long double (_l)
+typedef float (*odefunc_f)(float x,float y,void *ctx);
+typedef long double (*odefunc_l)(long double x,long double y,void *ctx);
+int euler_f(odefunc_f f,void *ctx,float x0,float y0,float h,float *xs,long xstride,float *ys,long ystride,int n);
+int euler_l(odefunc_l f,void *ctx,long double x0,long double y0,long double h,long double *xs,long xstride,long double *ys,long ystride,int n);
+#endif
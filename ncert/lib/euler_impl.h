@@ -0,0 +1,15 @@
+//Generic forward Euler body, instantiated by euler.c for each precision (see scalar.h)
+
+int FN(euler)(FN(odefunc) f,void *ctx,T x0,T y0,T h,T *xs,long xstride,T *ys,long ystride,int n){
+	T x=x0,y=y0;
+	if(n<1) return -1;
+	xs[0]=x;
+	ys[0]=y;
+	for(int i=1;i<n;i++){
+		y+=h*f(x,y,ctx);	//y_(n+1)=y_n+h*f(x_n,y_n)
+		x=x0+i*h;		//no drift from repeated x+=h
+		xs[i*xstride]=x;
+		ys[i*ystride]=y;
+	}
+	return 0;
+}
@@ -0,0 +1,628 @@
+#include <math.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include "expr.h"
+#include "cpu.h"
+
+//Opcodes, binary ones first; functions are everything from EX_SIN on
+enum{EX_ADD,EX_SUB,EX_MUL,EX_DIV,EX_POW,EX_POWI,EX_NEG,EX_HORNER,EX_SIN,EX_COS,EX_TAN,EX_ASIN,EX_ACOS,EX_ATAN,EX_SQRT,EX_CBRT,EX_LN,EX_LOG,EX_EXP,EX_ABS};
+#define BINARY(op) ((op)<=EX_POW)
+#define FUNC(op) ((op)>=EX_SIN)
+#define LPAREN -1
+//Highest degree a whole program can be fused into one EX_HORNER for
+#define HORNER_MAXDEG 16
+
+static const struct{
+	const char *name;
+	int op;
+}funcs[]={
+	{"sin",EX_SIN},{"cos",EX_COS},{"tan",EX_TAN},{"asin",EX_ASIN},{"acos",EX_ACOS},{"atan",EX_ATAN},
+	{"sininv",EX_ASIN},{"cosinv",EX_ACOS},{"taninv",EX_ATAN},	//calculator keypad names
+	{"sqrt",EX_SQRT},{"cbrt",EX_CBRT},{"ln",EX_LN},{"log",EX_LOG},{"exp",EX_EXP},{"abs",EX_ABS},
+};
+
+//Same levels as the calculator, with unary minus binding tighter than * and looser than ^
+static int precedence(int op){
+	if(op==EX_ADD||op==EX_SUB) return 1;
+	if(op==EX_MUL||op==EX_DIV) return 2;
+	if(op==EX_NEG) return 3;
+	if(op==EX_POW) return 4;
+	return 0;
+}
+
+//a^n by squaring
+static inline double powi(double a,int n){
+	unsigned m=n<0?-(unsigned)n:(unsigned)n;
+	double r=1;
+	while(m){
+		if(m&1) r*=a;
+		a*=a;
+		m>>=1;
+	}
+	return n<0?1/r:r;
+}
+
+//One instruction on scalars, also used to fold constants at compile time
+static inline double apply(int op,double a,double b,int n){
+	switch(op){
+		case EX_ADD: return a+b;
+		case EX_SUB: return a-b;
+		case EX_MUL: return a*b;
+		case EX_DIV: return b!=0?a/b:NAN;	//as in the calculator
+		case EX_POW: return pow(a,b);
+		case EX_POWI: return powi(a,n);
+		case EX_NEG: return -a;
+		case EX_SIN: return sin(a);
+		case EX_COS: return cos(a);
+		case EX_TAN: return tan(a);
+		case EX_ASIN: return asin(a);
+		case EX_ACOS: return acos(a);
+		case EX_ATAN: return atan(a);
+		case EX_SQRT: return sqrt(a);
+		case EX_CBRT: return cbrt(a);
+		case EX_LN: return log(a);
+		case EX_LOG: return log10(a);
+		case EX_EXP: return exp(a);
+		case EX_ABS: return fabs(a);
+	}
+	return NAN;
+}
+
+//One instruction on dual numbers (chain rule)
+static inline dual dapply(int op,dual a,dual b,int n){
+	dual r;
+	switch(op){
+		case EX_ADD: return dadd(a,b);
+		case EX_SUB: return dsub(a,b);
+		case EX_MUL: return dmul(a,b);
+		case EX_DIV:
+			if(b.v==0) break;
+			return ddiv(a,b);
+		case EX_POW:
+			r.v=pow(a.v,b.v);
+			r.d=b.v*pow(a.v,b.v-1)*a.d+(b.d!=0?r.v*log(a.v)*b.d:0);	//log only for a variable exponent
+			return r;
+		case EX_POWI:{
+			double p=powi(a.v,n-1);	//a^(n-1) serves both parts
+			r.v=p*a.v;
+			r.d=n*p*a.d;
+			return r;
+		}
+		case EX_NEG: return dscale(a,-1);
+		case EX_SIN: return dsin(a);
+		case EX_COS: return dcos(a);
+		case EX_TAN:
+			r.v=tan(a.v);
+			r.d=(1+r.v*r.v)*a.d;
+			return r;
+		case EX_ASIN:
+			r.v=asin(a.v);
+			r.d=a.d/sqrt(1-a.v*a.v);
+			return r;
+		case EX_ACOS:
+			r.v=acos(a.v);
+			r.d=-a.d/sqrt(1-a.v*a.v);
+			return r;
+		case EX_ATAN:
+			r.v=atan(a.v);
+			r.d=a.d/(1+a.v*a.v);
+			return r;
+		case EX_SQRT: return dsqrt(a);
+		case EX_CBRT:
+			r.v=cbrt(a.v);
+			r.d=a.d/(3*r.v*r.v);
+			return r;
+		case EX_LN: return dlog(a);
+		case EX_LOG:
+			r.v=log10(a.v);
+			r.d=a.d/(a.v*M_LN10);
+			return r;
+		case EX_EXP: return dexp(a);
+		case EX_ABS:
+			r.v=fabs(a.v);
+			r.d=a.v<0?-a.d:a.d;
+			return r;
+	}
+	r.v=r.d=NAN;
+	return r;
+}
+
+//Operand ids while compiling: variables, then constants, then one temporary per stack slot
+//They are renumbered to the packed register layout once the constant count is known
+#define CONST0 EXPR_MAXVARS
+#define TEMP0 (EXPR_MAXVARS+EXPR_MAXCONST)
+
+//Shunting-yard state: the operand stack holds ids instead of the calculator's values
+typedef struct compiler{
+	expr *e;
+	int vals[EXPR_MAXDEPTH],nv,depth;
+	int ops[2*EXPR_MAXDEPTH],no;
+}compiler;
+
+//Constant slot for v: an equal one, else a new one, else one nothing refers to any more
+//Folding pops its operands before asking for the result's slot, so a long chain of constants
+//keeps reusing the slots it has consumed instead of running out
+static int constant(compiler *c,double v){
+	expr *e=c->e;
+	for(int i=0;i<e->nconst;i++){
+		if(e->k[i]==v) return CONST0+i;
+	}
+	if(e->nconst<EXPR_MAXCONST){
+		e->k[e->nconst]=v;
+		return CONST0+e->nconst++;
+	}
+	char used[EXPR_MAXCONST]={0};
+	for(int i=0;i<c->nv;i++){
+		if(c->vals[i]>=CONST0&&c->vals[i]<TEMP0) used[c->vals[i]-CONST0]=1;
+	}
+	for(int i=0;i<e->ncode;i++){
+		const exprinst *in=&e->code[i];
+		if(in->a>=CONST0&&in->a<TEMP0) used[in->a-CONST0]=1;
+		if(in->b>=CONST0&&in->b<TEMP0) used[in->b-CONST0]=1;
+	}
+	for(int i=0;i<EXPR_MAXCONST;i++){
+		if(!used[i]){
+			e->k[i]=v;
+			return CONST0+i;
+		}
+	}
+	return -1;
+}
+
+static int pushval(compiler *c,int id){
+	if(id<0||c->nv==EXPR_MAXDEPTH) return -1;
+	c->vals[c->nv++]=id;
+	if(c->nv>c->depth) c->depth=c->nv;
+	return 0;
+}
+
+static int pushop(compiler *c,int op){
+	if(c->no==2*EXPR_MAXDEPTH) return -1;
+	c->ops[c->no++]=op;
+	return 0;
+}
+
+//Pops the operands of op and pushes its result, folding it if every operand is a constant
+static int reduce(compiler *c,int op){
+	expr *e=c->e;
+	int nargs=BINARY(op)?2:1,n=0;
+	if(c->nv<nargs) return -1;
+	int a=c->vals[c->nv-nargs],b=c->vals[c->nv-1];
+	int ka=a>=CONST0&&a<TEMP0,kb=b>=CONST0&&b<TEMP0;
+	if(op==EX_POW&&kb){
+		double p=e->k[b-CONST0];
+		if(p==floor(p)&&fabs(p)<=64){
+			op=EX_POWI;
+			n=(int)p;
+			nargs=1;
+		}
+	}
+	c->nv-=BINARY(op)||op==EX_POWI?2:1;
+	if(ka&&(nargs==1||kb)){
+		double v=apply(op,e->k[a-CONST0],nargs==2?e->k[b-CONST0]:0,n);
+		return pushval(c,constant(c,v));
+	}
+	int t=TEMP0+c->nv;
+	if(op==EX_POWI&&n>=0&&n<=4){
+		//x^0..x^4 as products, x^3 squares into the next slot so a temporary x is not overwritten
+		static const int len[5]={0,0,1,2,2};
+		if(n==0) return pushval(c,constant(c,1));
+		if(n==1) return pushval(c,a);
+		if(e->ncode+len[n]>EXPR_MAXCODE||(n==3&&c->nv+1>=EXPR_MAXDEPTH)) return -1;
+		exprinst sq={EX_MUL,(unsigned char)(n==3?t+1:t),(unsigned char)a,(unsigned char)a,0};
+		e->code[e->ncode++]=sq;
+		if(n==3){
+			exprinst cube={EX_MUL,(unsigned char)t,(unsigned char)(t+1),(unsigned char)a,0};
+			e->code[e->ncode++]=cube;
+			if(c->nv+2>c->depth) c->depth=c->nv+2;
+		}
+		if(n==4){
+			exprinst quad={EX_MUL,(unsigned char)t,(unsigned char)t,(unsigned char)t,0};
+			e->code[e->ncode++]=quad;
+		}
+		return pushval(c,t);
+	}
+	if(e->ncode==EXPR_MAXCODE) return -1;
+	exprinst in={(unsigned char)op,(unsigned char)t,(unsigned char)a,(unsigned char)(nargs==2?b:a),n};
+	e->code[e->ncode++]=in;
+	return pushval(c,t);
+}
+
+//Packed register of a compile time operand id, map gives the new index of each constant
+static int reg(const expr *e,const int *map,int id){
+	if(id<CONST0) return id;
+	if(id<TEMP0) return e->nvars+map[id-CONST0];
+	return e->nvars+e->nconst+id-TEMP0;
+}
+
+//A packed program that is a polynomial in the first variable alone (+ - *, division by a constant,
+//integer powers) becomes one EX_HORNER instruction: dst=c_0 x^(n-1)+...+c_(n-1) with x in register a
+//and the n coefficients, highest first, in the constant registers from b on. Expanding the
+//polynomial can round differently from the original order of operations
+static void fusehorner(expr *e){
+	double poly[EXPR_MAXREG][HORNER_MAXDEG+1];	//coefficient of x^j at [j]
+	int deg[EXPR_MAXREG];
+	if(e->ncode<2) return;
+	for(int i=0;i<e->nreg;i++){
+		for(int j=0;j<=HORNER_MAXDEG;j++) poly[i][j]=0;
+		deg[i]=i==0?1:i<e->nvars?-1:0;	//-1: not a polynomial in x
+	}
+	poly[0][1]=1;
+	for(int i=0;i<e->nconst;i++) poly[e->nvars+i][0]=e->k[i];
+	for(int i=0;i<e->ncode;i++){
+		const exprinst *in=&e->code[i];
+		int a=in->a,b=in->b,t=in->dst,d=-1;
+		double r[HORNER_MAXDEG+1]={0};
+		if(deg[a]<0||(BINARY(in->op)&&deg[b]<0)) return;
+		switch(in->op){
+			case EX_ADD:
+			case EX_SUB:
+				d=deg[a]>deg[b]?deg[a]:deg[b];
+				for(int j=0;j<=d;j++) r[j]=in->op==EX_ADD?poly[a][j]+poly[b][j]:poly[a][j]-poly[b][j];
+				break;
+			case EX_NEG:
+				d=deg[a];
+				for(int j=0;j<=d;j++) r[j]=-poly[a][j];
+				break;
+			case EX_DIV:
+				if(deg[b]!=0||poly[b][0]==0) return;
+				d=deg[a];
+				for(int j=0;j<=d;j++) r[j]=poly[a][j]/poly[b][0];
+				break;
+			case EX_MUL:
+			case EX_POWI:{
+				//a*b is one product, a^n is a times itself n-1 more times
+				const double *f=in->op==EX_MUL?poly[b]:poly[a];
+				int df=in->op==EX_MUL?deg[b]:deg[a],n=in->op==EX_MUL?1:in->n-1;
+				if(in->op==EX_POWI&&in->n<0) return;
+				if(in->op==EX_POWI&&in->n==0){
+					d=0;
+					r[0]=1;
+					break;
+				}
+				d=deg[a];
+				for(int j=0;j<=d;j++) r[j]=poly[a][j];
+				for(int m=0;m<n;m++){
+					double p[HORNER_MAXDEG+1]={0};
+					if(d+df>HORNER_MAXDEG) return;
+					for(int j=0;j<=d;j++){
+						for(int l=0;l<=df;l++) p[j+l]+=r[j]*f[l];
+					}
+					d+=df;
+					for(int j=0;j<=d;j++) r[j]=p[j];
+				}
+				break;
+			}
+			default:
+				return;
+		}
+		deg[t]=d;
+		for(int j=0;j<=HORNER_MAXDEG;j++) poly[t][j]=r[j];
+	}
+	int n=deg[e->result]+1;
+	const double *c=poly[e->result];
+	if(n<2) return;
+	e->nconst=n;
+	for(int j=0;j<n;j++) e->k[j]=c[n-1-j];
+	exprinst h={EX_HORNER,(unsigned char)(e->nvars+n),0,(unsigned char)e->nvars,n};
+	e->code[0]=h;
+	e->ncode=1;
+	e->result=e->nvars+n;
+	e->nreg=e->nvars+n+1;
+}
+
+int expr_compile(expr *e,const char *src,const char *vars){
+	char names[EXPR_MAXVARS][16];
+	compiler c={e,{0},0,0,{0},0};
+	const char *p=vars;
+	e->ncode=e->nvars=e->nconst=0;
+	e->errpos=-1;
+	//Variable names
+	while(p&&*p){
+		int len=0;
+		while(isspace((unsigned char)*p)) p++;
+		while(isalnum((unsigned char)*p)||*p=='_'){
+			if(len==15||e->nvars==EXPR_MAXVARS) return -1;
+			names[e->nvars][len++]=*p++;
+		}
+		while(isspace((unsigned char)*p)) p++;
+		if(len==0||(*p&&*p!=',')) return -1;
+		names[e->nvars++][len]='\0';
+		if(*p==',') p++;
+	}
+	int operand=1;	//an operand is expected next, so '-' is unary
+	p=src;
+	while(*p){
+		if(isspace((unsigned char)*p)){
+			p++;
+		}
+		else if(isdigit((unsigned char)*p)||*p=='.'){
+			char *end;
+			double v=strtod(p,&end);
+			if(!operand||end==p||pushval(&c,constant(&c,v))) goto fail;
+			p=end;
+			operand=0;
+		}
+		else if(isalpha((unsigned char)*p)||*p=='_'){
+			const char *s=p;
+			int id=-1,op=-1;
+			if(!operand) goto fail;
+			while(isalnum((unsigned char)*p)||*p=='_') p++;
+			size_t len=p-s;
+			for(int j=0;j<e->nvars;j++){
+				if(strlen(names[j])==len&&strncmp(names[j],s,len)==0) id=j;
+			}
+			if(id<0&&len==2&&(strncmp(s,"pi",2)==0||strncmp(s,"Pi",2)==0)) id=constant(&c,M_PI);
+			if(id<0&&len==1&&*s=='e') id=constant(&c,M_E);
+			for(size_t j=0;id<0&&j<sizeof(funcs)/sizeof(funcs[0]);j++){
+				if(strlen(funcs[j].name)==len&&strncmp(funcs[j].name,s,len)==0) op=funcs[j].op;
+			}
+			if(id>=0){
+				if(pushval(&c,id)) goto fail;
+				operand=0;
+			}
+			else{
+				const char *q=p;
+				while(isspace((unsigned char)*q)) q++;
+				if(op<0||*q!='('){
+					p=s;
+					goto fail;
+				}
+				if(pushop(&c,op)) goto fail;
+			}
+		}
+		else if(*p=='('){
+			if(!operand||pushop(&c,LPAREN)) goto fail;
+			p++;
+		}
+		else if(*p==')'){
+			if(operand) goto fail;
+			while(c.no>0&&c.ops[c.no-1]!=LPAREN){
+				if(reduce(&c,c.ops[--c.no])) goto fail;
+			}
+			if(c.no==0) goto fail;
+			c.no--;
+			if(c.no>0&&FUNC(c.ops[c.no-1])&&reduce(&c,c.ops[--c.no])) goto fail;
+			p++;
+		}
+		else{
+			const char *sym="+-*/^";
+			const char *q=strchr(sym,*p);
+			if(!q) goto fail;
+			int op=(int)(q-sym);	//EX_ADD..EX_POW in the same order
+			if(operand){
+				//Prefix sign
+				if(op==EX_SUB&&pushop(&c,EX_NEG)) goto fail;
+				if(op!=EX_SUB&&op!=EX_ADD) goto fail;
+				p++;
+				continue;
+			}
+			//^ is right associative, the rest left associative
+			while(c.no>0&&c.ops[c.no-1]!=LPAREN&&!FUNC(c.ops[c.no-1])&&
+				(precedence(c.ops[c.no-1])>precedence(op)||(precedence(c.ops[c.no-1])==precedence(op)&&op!=EX_POW))){
+				if(reduce(&c,c.ops[--c.no])) goto fail;
+			}
+			if(pushop(&c,op)) goto fail;
+			operand=1;
+			p++;
+		}
+	}
+	if(operand) goto fail;
+	while(c.no>0){
+		if(c.ops[c.no-1]==LPAREN||reduce(&c,c.ops[--c.no])) goto fail;
+	}
+	if(c.nv!=1) goto fail;
+	//Drop the constants that folding left unused, then pack the registers:
+	//variables, constants, temporaries
+	int map[EXPR_MAXCONST],used[EXPR_MAXCONST]={0},nk=0;
+	for(int i=0;i<e->ncode;i++){
+		exprinst *in=&e->code[i];
+		if(in->a>=CONST0&&in->a<TEMP0) used[in->a-CONST0]=1;
+		if(in->b>=CONST0&&in->b<TEMP0) used[in->b-CONST0]=1;
+	}
+	if(c.vals[0]>=CONST0&&c.vals[0]<TEMP0) used[c.vals[0]-CONST0]=1;
+	for(int i=0;i<e->nconst;i++){
+		if(used[i]){
+			e->k[nk]=e->k[i];
+			map[i]=nk++;
+		}
+	}
+	e->nconst=nk;
+	for(int i=0;i<e->ncode;i++){
+		exprinst *in=&e->code[i];
+		in->dst=(unsigned char)reg(e,map,in->dst);
+		in->a=(unsigned char)reg(e,map,in->a);
+		in->b=(unsigned char)reg(e,map,in->b);
+	}
+	e->result=reg(e,map,c.vals[0]);
+	e->nreg=e->nvars+e->nconst+c.depth;
+	fusehorner(e);
+	return 0;
+fail:
+	e->errpos=(int)(p-src);
+	return -1;
+}
+
+double expr_eval(const expr *e,const double *vars){
+	double r[EXPR_MAXREG];
+	//A fused polynomial reads its coefficients straight from k[], no register file needed
+	if(e->ncode==1&&e->code[0].op==EX_HORNER) return horner(e->k,e->code[0].n,vars[0]);
+	for(int i=0;i<e->nvars;i++) r[i]=vars[i];
+	for(int i=0;i<e->nconst;i++) r[e->nvars+i]=e->k[i];
+	for(int i=0;i<e->ncode;i++){
+		const exprinst *in=&e->code[i];
+		if(in->op==EX_HORNER) r[in->dst]=horner(r+in->b,in->n,r[in->a]);
+		else r[in->dst]=apply(in->op,r[in->a],r[in->b],in->n);
+	}
+	return r[e->result];
+}
+
+dual expr_eval_dual(const expr *e,const double *vars){
+	//Values and derivatives in separate files, the arithmetic is inline and the rest goes through dapply
+	double v[EXPR_MAXREG],d[EXPR_MAXREG];
+	if(e->ncode==1&&e->code[0].op==EX_HORNER) return dhorner(e->k,e->code[0].n,vars[0]);
+	for(int i=0;i<e->nvars;i++){
+		v[i]=vars[i];
+		d[i]=i==0;
+	}
+	for(int i=0;i<e->nconst;i++){
+		v[e->nvars+i]=e->k[i];
+		d[e->nvars+i]=0;
+	}
+	for(int i=0;i<e->ncode;i++){
+		const exprinst *in=&e->code[i];
+		int a=in->a,b=in->b,t=in->dst;
+		switch(in->op){
+			case EX_ADD:
+				v[t]=v[a]+v[b];
+				d[t]=d[a]+d[b];
+				break;
+			case EX_SUB:
+				v[t]=v[a]-v[b];
+				d[t]=d[a]-d[b];
+				break;
+			case EX_MUL:
+				d[t]=d[a]*v[b]+v[a]*d[b];
+				v[t]=v[a]*v[b];
+				break;
+			case EX_NEG:
+				v[t]=-v[a];
+				d[t]=-d[a];
+				break;
+			case EX_HORNER:{
+				dual p=dhorner(v+b,in->n,v[a]);
+				v[t]=p.v;
+				d[t]=p.d*d[a];
+				break;
+			}
+			default:{
+				dual x={v[a],d[a]},y={v[b],d[b]},r=dapply(in->op,x,y,in->n);
+				v[t]=r.v;
+				d[t]=r.d;
+			}
+		}
+	}
+	dual r={v[e->result],d[e->result]};
+	return r;
+}
+
+//Runs the program over m<=EXPR_LANES lanes, one loop per instruction
+//Instructions flagged uniform (every operand the same in all lanes) are evaluated once and broadcast
+//The arithmetic loops vectorise, cloned per instruction set level (see cpu.h)
+HOT void exprblock(const expr *e,const char *uniform,double (*r)[EXPR_LANES],int m){
+	for(int i=0;i<e->ncode;i++){
+		const exprinst *in=&e->code[i];
+		double *d=r[in->dst];
+		const double *a=r[in->a],*b=r[in->b];
+		if(in->op==EX_HORNER){
+			//Coefficients are constant registers, so lane 0 of each is its value
+			for(int l=0;l<m;l++){
+				double p=b[0];
+				for(int j=1;j<in->n;j++) p=p*a[l]+b[j*EXPR_LANES];
+				d[l]=p;
+			}
+			continue;
+		}
+		if(uniform[i]){
+			double v=apply(in->op,a[0],b[0],in->n);
+			for(int l=0;l<m;l++) d[l]=v;
+			continue;
+		}
+		switch(in->op){
+			case EX_ADD:
+				for(int l=0;l<m;l++) d[l]=a[l]+b[l];
+				break;
+			case EX_SUB:
+				for(int l=0;l<m;l++) d[l]=a[l]-b[l];
+				break;
+			case EX_MUL:
+				for(int l=0;l<m;l++) d[l]=a[l]*b[l];
+				break;
+			case EX_DIV:
+				for(int l=0;l<m;l++) d[l]=b[l]!=0?a[l]/b[l]:NAN;
+				break;
+			case EX_POWI:{
+				//Same square and multiply sequence in every lane
+				double base[EXPR_LANES],acc[EXPR_LANES];
+				unsigned k=in->n<0?-(unsigned)in->n:(unsigned)in->n;
+				for(int l=0;l<m;l++){
+					base[l]=a[l];
+					acc[l]=1;
+				}
+				for(;k;k>>=1){
+					if(k&1) for(int l=0;l<m;l++) acc[l]*=base[l];
+					for(int l=0;l<m;l++) base[l]*=base[l];
+				}
+				if(in->n<0) for(int l=0;l<m;l++) d[l]=1/acc[l];
+				else for(int l=0;l<m;l++) d[l]=acc[l];
+				break;
+			}
+			case EX_NEG:
+				for(int l=0;l<m;l++) d[l]=-a[l];
+				break;
+			case EX_SQRT:
+				for(int l=0;l<m;l++) d[l]=sqrt(a[l]);
+				break;
+			case EX_ABS:
+				for(int l=0;l<m;l++) d[l]=fabs(a[l]);
+				break;
+			default:
+				for(int l=0;l<m;l++) d[l]=apply(in->op,a[l],b[l],in->n);
+		}
+	}
+}
+ISA_CLONES_VOID(exprblock,(const expr *e,const char *uniform,double (*r)[EXPR_LANES],int m),(e,uniform,r,m))
+
+void expr_eval_batch(const expr *e,const double *const *vars,const long *stride,double *out,int n){
+	double r[EXPR_MAXREG][EXPR_LANES];
+	//Constants and broadcast variables are the same in every block
+	for(int c=0;c<e->nconst;c++){
+		for(int l=0;l<EXPR_LANES;l++) r[e->nvars+c][l]=e->k[c];
+	}
+	for(int j=0;j<e->nvars;j++){
+		if(stride[j]==0) for(int l=0;l<EXPR_LANES;l++) r[j][l]=vars[j][0];
+	}
+	//Uniformity flows forward through the registers, e.g. exp(x) in exp(x)-y for a broadcast x
+	char uni[EXPR_MAXREG],uniform[EXPR_MAXCODE];
+	for(int j=0;j<e->nreg;j++) uni[j]=j>=e->nvars||stride[j]==0;
+	for(int j=e->nvars+e->nconst;j<e->nreg;j++) uni[j]=0;
+	for(int i=0;i<e->ncode;i++){
+		const exprinst *in=&e->code[i];
+		uniform[i]=uni[in->a]&&uni[in->b];
+		uni[in->dst]=uniform[i];
+	}
+	for(int i0=0;i0<n;i0+=EXPR_LANES){
+		int m=n-i0<EXPR_LANES?n-i0:EXPR_LANES;
+		for(int j=0;j<e->nvars;j++){
+			if(stride[j]) for(int l=0;l<m;l++) r[j][l]=vars[j][(long)(i0+l)*stride[j]];
+		}
+		ISA_CALL(exprblock)(e,uniform,r,m);
+		memcpy(out+i0,r[e->result],m*sizeof(double));
+	}
+}
+
+double expr_integrand(double x,void *ctx){
+	return expr_eval((const expr*)ctx,&x);
+}
+
+void expr_batchintegrand(const double *x,double *y,int n,void *ctx){
+	const double *v[1]={x};
+	long s[1]={1};
+	expr_eval_batch((const expr*)ctx,v,s,y,n);
+}
+
+double expr_odefunc(double x,double y,void *ctx){
+	double v[2]={x,y};
+	return expr_eval((const expr*)ctx,v);
+}
+
+void expr_batchfunc(double x,const double *y,double *dy,int n,void *ctx){
+	const double *v[2]={&x,y};
+	long s[2]={0,1};
+	expr_eval_batch((const expr*)ctx,v,s,dy,n);
+}
+
+dual expr_dualfunc(double x,void *ctx){
+	return expr_eval_dual((const expr*)ctx,&x);
+}
@@ -0,0 +1,50 @@
+#ifndef EXPR_H
+#define EXPR_H
+#include "dual.h"
+//Runtime expressions for the kernels: the infix grammar of Calculator/codes/calculator.c
+//(+ - * / ^, parentheses, sin cos tan asin acos atan sqrt ln, Pi) plus unary minus, cbrt, log, exp, abs,
+//the keypad names sininv/cosinv/taninv and named variables, compiled to register bytecode
+//Registers hold the variables, then the constants, then the temporaries of the operand stack
+
+#define EXPR_MAXCODE 128	//instructions
+#define EXPR_MAXVARS 8
+#define EXPR_MAXCONST 32
+#define EXPR_MAXDEPTH 24	//operand stack depth, one temporary register each
+#define EXPR_MAXREG (EXPR_MAXVARS+EXPR_MAXCONST+EXPR_MAXDEPTH)
+//Lanes per register in batch evaluation, EXPR_MAXREG of them fit in 32 KiB
+#define EXPR_LANES 64
+
+typedef struct exprinst{
+	unsigned char op,dst,a,b;
+	int n;			//exponent of an integer power
+}exprinst;
+
+typedef struct expr{
+	int ncode,nvars,nconst,nreg;
+	int result;		//register holding the value of the whole expression
+	int errpos;		//offset of the first character that could not be compiled, or -1
+	exprinst code[EXPR_MAXCODE];
+	double k[EXPR_MAXCONST];
+}expr;
+
+//Compiles src over the comma separated variable names in vars ("x" or "x,y")
+//Constant subexpressions are folded and small integer powers become repeated products
+//A program that is a polynomial of degree <=16 in the first variable alone compiles to one Horner step
+//Returns 0, or -1 with e->errpos set if src does not parse or exceeds the limits above
+int expr_compile(expr *e,const char *src,const char *vars);
+
+//Value at vars[0..nvars-1]
+double expr_eval(const expr *e,const double *vars);
+//Value and derivative with respect to the first variable
+dual expr_eval_dual(const expr *e,const double *vars);
+//out[i] for i<n, variable j of lane i read from vars[j][i*stride[j]] (stride 0 broadcasts one value)
+//Each instruction runs over EXPR_LANES lanes at a time, so dispatch is paid once per block
+void expr_eval_batch(const expr *e,const double *const *vars,const long *stride,double *out,int n);
+
+//Adapters with the expr as ctx, for quad (x), rk45/euler (x,y), ensemble (x,y) and gd/newton (x)
+double expr_integrand(double x,void *ctx);
+void expr_batchintegrand(const double *x,double *y,int n,void *ctx);
+double expr_odefunc(double x,double y,void *ctx);
+void expr_batchfunc(double x,const double *y,double *dy,int n,void *ctx);
+dual expr_dualfunc(double x,void *ctx);
+#endif
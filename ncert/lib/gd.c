@@ -0,0 +1,15 @@
+#include <math.h>
+#include "gd.h"
+
+#define PREC 'f'
+#include "scalar.h"
+#include "gd_impl.h"
+#undef PREC
+#define PREC 'd'
+#include "scalar.h"
+#include "gd_impl.h"
+#undef PREC
+#define PREC 'l'
+#include "scalar.h"
+#include "gd_impl.h"
+#undef PREC
@@ -0,0 +1,34 @@
+#ifndef GD_H
+#define GD_H
+#include "newton.h"
+#include "stats.h"
+//One dimensional gradient descent/ascent and a scan for the global extrema on an interval
+
+typedef struct gdpoint{
+	double x,y;
+}gdpoint;
+
+//Most steps one walk takes before it stops where it is
+#define GD_MAXITER 1000000
+
+//Fixed step walk x+=sign*h*f'(x) from cur while |f'(x)|>precision and x<up
+//sign=-1 descends to a minimum, sign=+1 ascends to a maximum
+//st (may be NULL) receives steps, evaluations, the final |f'| and the wall time
+double gd_walk(dualfunc f,void *ctx,double cur,double up,double h,double precision,double sign,kstats *st);
+
+//Scans [lower,upper] alternating descent and ascent from every stationary point it reaches
+//st totals the steps and evaluations of every walk, the residual is that of the last one
+void gd_scan(dualfunc f,void *ctx,double lower,double upper,gdpoint *min,gdpoint *max,kstats *st);
+
+//The same in float (_f) and long double (_l)
+typedef struct gdpoint_f{
+	float x,y;
+}gdpoint_f;
+typedef struct gdpoint_l{
+	long double x,y;
+}gdpoint_l;
+float gd_walk_f(dualfunc_f f,void *ctx,float cur,float up,float h,float precision,float sign,kstats *st);
+void gd_scan_f(dualfunc_f f,void *ctx,float lower,float upper,gdpoint_f *min,gdpoint_f *max,kstats *st);
+long double gd_walk_l(dualfunc_l f,void *ctx,long double cur,long double up,long double h,long double precision,long double sign,kstats *st);
+void gd_scan_l(dualfunc_l f,void *ctx,long double lower,long double upper,gdpoint_l *min,gdpoint_l *max,kstats *st);
+#endif
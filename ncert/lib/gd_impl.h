@@ -0,0 +1,69 @@
+//Generic gradient walk and extrema scan, instantiated by gd.c for each precision (see scalar.h)
+
+//Walk shared by gd_walk and gd_scan, adds its steps and evaluations to st
+static T FN(walk)(FN(dualfunc) f,void *ctx,T cur,T up,T h,T precision,T sign,kstats *st){
+	T s=f(cur,ctx).d;	//slope is evaluated once per step
+	int it=0;
+	while((ABS(s)>precision)&&(cur<up)&&it<GD_MAXITER){
+		cur+=sign*h*s;
+		s=f(cur,ctx).d;
+		it++;
+		KTRACE(st,"gd_walk",it,(double)ABS(s));
+	}
+	if(st){
+		st->iterations+=it;
+		st->nfev+=it+1;
+		st->residual=(double)ABS(s);
+	}
+	return cur;
+}
+
+T FN(gd_walk)(FN(dualfunc) f,void *ctx,T cur,T up,T h,T precision,T sign,kstats *st){
+	double t0=kstats_begin(st);
+	cur=FN(walk)(f,ctx,cur,up,h,precision,sign,st);
+	kstats_end(st,t0);
+	return cur;
+}
+
+void FN(gd_scan)(FN(dualfunc) f,void *ctx,T lower,T upper,FN(gdpoint) *min,FN(gdpoint) *max,kstats *st){
+	double t0=kstats_begin(st);
+	T h=0.001,precision=0.0001;
+	FN(gdpoint) globalmax={0,-1e10},globalmin={0,1e10};
+	while(upper>lower){	//terminating condition of scanning the entire region
+		FN(dual) y=f(lower,ctx);
+		if(st) st->nfev++;
+		if(y.d<0){
+			//Going downhill: the current point may be a maximum, the end of the walk a minimum
+			if(y.v>globalmax.y){
+				globalmax.x=lower;
+				globalmax.y=y.v;
+			}
+			T X=FN(walk)(f,ctx,lower,upper,h,precision,-1,st);
+			T fX=f(X,ctx).v;
+			if(st) st->nfev++;
+			if(fX<globalmin.y){
+				globalmin.x=X;
+				globalmin.y=fX;
+			}
+			lower=X;
+		}
+		else if(y.d>0){
+			if(y.v<globalmin.y){
+				globalmin.x=lower;
+				globalmin.y=y.v;
+			}
+			T X=FN(walk)(f,ctx,lower,upper,h,precision,1,st);
+			T fX=f(X,ctx).v;
+			if(st) st->nfev++;
+			if(fX>globalmax.y){
+				globalmax.x=X;
+				globalmax.y=fX;
+			}
+			lower=X;
+		}
+		lower+=(T)0.1;	//Not to get stuck
+	}
+	*min=globalmin;
+	*max=globalmax;
+	kstats_end(st,t0);
+}
@@ -0,0 +1,158 @@
+#include <math.h>
+#include <string.h>
+#include "krylov.h"
+#include "cpu.h"
+
+//Four partial sums so the loop vectorises without reassociation flags
+HOT double dot(const double *x,const double *y,long n){
+	double s[4]={0,0,0,0};
+	long i;
+	for(i=0;i+4<=n;i+=4){
+		for(int k=0;k<4;k++) s[k]+=x[i+k]*y[i+k];
+	}
+	for(;i<n;i++) s[0]+=x[i]*y[i];
+	return (s[0]+s[1])+(s[2]+s[3]);
+}
+ISA_CLONES(double,dot,(const double *x,const double *y,long n),(x,y,n))
+
+double krylov_dot(const double *x,const double *y,long n){
+	return ISA_CALL(dot)(x,y,n);
+}
+
+//r=b-Ax
+static void residual(matvec A,void *actx,const double *b,const double *x,double *r,long n){
+	A(x,r,n,actx);
+	for(long i=0;i<n;i++) r[i]=b[i]-r[i];
+}
+
+static int finish(kstats *st,double t0,int it,long nfev,double res,int converged){
+	if(st){
+		st->iterations=it;
+		st->nfev=nfev;
+		st->residual=res;
+	}
+	kstats_end(st,t0);
+	return converged?it:-1;
+}
+
+int cg(matvec A,void *actx,matvec M,void *mctx,const double *b,double *x,long n,
+	double tol,int maxiter,double *work,kstats *st){
+	double t0=kstats_begin(st);
+	double *r=work,*z=work+n,*p=work+2*n,*q=work+3*n;
+	double bn=sqrt(krylov_dot(b,b,n));
+	if(bn==0){
+		memset(x,0,n*sizeof(double));
+		return finish(st,t0,0,0,0,1);
+	}
+	residual(A,actx,b,x,r,n);
+	long nfev=1;
+	int it=0;
+	double res=sqrt(krylov_dot(r,r,n))/bn;
+	if(M) M(r,z,n,mctx);
+	else memcpy(z,r,n*sizeof(double));
+	memcpy(p,z,n*sizeof(double));
+	double rz=krylov_dot(r,z,n);
+	while(res>tol&&it<maxiter){
+		A(p,q,n,actx);
+		nfev++;
+		double pq=krylov_dot(p,q,n);
+		if(pq<=0) break;	//A is not positive definite along p
+		double alpha=rz/pq;
+		for(long i=0;i<n;i++){
+			x[i]+=alpha*p[i];
+			r[i]-=alpha*q[i];
+		}
+		it++;
+		res=sqrt(krylov_dot(r,r,n))/bn;
+		KTRACE(st,"cg",it,res);
+		if(M) M(r,z,n,mctx);
+		else memcpy(z,r,n*sizeof(double));
+		double rz1=krylov_dot(r,z,n),beta=rz1/rz;
+		rz=rz1;
+		for(long i=0;i<n;i++){
+			p[i]=z[i]+beta*p[i];
+		}
+	}
+	return finish(st,t0,it,nfev,res,res<=tol);
+}
+
+int gmres(matvec A,void *actx,matvec M,void *mctx,const double *b,double *x,long n,int m,
+	double tol,int maxiter,double *work,kstats *st){
+	double t0=kstats_begin(st);
+	double *V=work,*w=work+(long)(m+1)*n;	//Krylov basis, one vector per n doubles
+	double *H=w+n,*cs=H+(m+1)*m,*sn=cs+m,*g=sn+m,*y=g+m+1;	//H column j at H+j*(m+1)
+	double bn=sqrt(krylov_dot(b,b,n)),res=1;
+	long nfev=0;
+	int it=0;
+	if(bn==0){
+		memset(x,0,n*sizeof(double));
+		return finish(st,t0,0,0,0,1);
+	}
+	while(it<maxiter){
+		residual(A,actx,b,x,V,n);
+		nfev++;
+		double beta=sqrt(krylov_dot(V,V,n));
+		res=beta/bn;
+		if(res<=tol) break;
+		for(long i=0;i<n;i++) V[i]/=beta;
+		memset(g,0,(m+1)*sizeof(double));
+		g[0]=beta;
+		int k=0;
+		while(k<m&&it<maxiter){
+			double *v=V+(long)(k+1)*n,*h=H+k*(m+1);
+			//v=AM^-1 v_k, orthogonalised against the basis
+			if(M){
+				M(V+(long)k*n,w,n,mctx);
+				A(w,v,n,actx);
+			}else{
+				A(V+(long)k*n,v,n,actx);
+			}
+			nfev++;
+			for(int i=0;i<=k;i++){
+				h[i]=krylov_dot(v,V+(long)i*n,n);
+				for(long l=0;l<n;l++) v[l]-=h[i]*V[(long)i*n+l];
+			}
+			h[k+1]=sqrt(krylov_dot(v,v,n));
+			if(h[k+1]!=0){
+				for(long l=0;l<n;l++) v[l]/=h[k+1];
+			}
+			//Earlier rotations on the new column, then the one that zeroes h[k+1]
+			for(int i=0;i<k;i++){
+				double t=cs[i]*h[i]+sn[i]*h[i+1];
+				h[i+1]=-sn[i]*h[i]+cs[i]*h[i+1];
+				h[i]=t;
+			}
+			double d=hypot(h[k],h[k+1]);
+			cs[k]=d!=0?h[k]/d:1;
+			sn[k]=d!=0?h[k+1]/d:0;
+			h[k]=d;
+			h[k+1]=0;
+			g[k+1]=-sn[k]*g[k];
+			g[k]*=cs[k];
+			k++;
+			it++;
+			res=fabs(g[k])/bn;
+			KTRACE(st,"gmres",it,res);
+			if(res<=tol||H[(k-1)*(m+1)+k-1]==0) break;
+		}
+		//Hy=g by back substitution, then x+=M^-1 Vy
+		for(int i=k-1;i>=0;i--){
+			double s=g[i];
+			for(int j=i+1;j<k;j++) s-=H[j*(m+1)+i]*y[j];
+			if(H[i*(m+1)+i]==0) return finish(st,t0,it,nfev,res,0);
+			y[i]=s/H[i*(m+1)+i];
+		}
+		memset(w,0,n*sizeof(double));
+		for(int j=0;j<k;j++){
+			for(long l=0;l<n;l++) w[l]+=y[j]*V[(long)j*n+l];
+		}
+		if(M){
+			M(w,V,n,mctx);	//the basis is rebuilt on restart
+			for(long l=0;l<n;l++) x[l]+=V[l];
+		}else{
+			for(long l=0;l<n;l++) x[l]+=w[l];
+		}
+		if(res<=tol) break;
+	}
+	return finish(st,t0,it,nfev,res,res<=tol);
+}
@@ -0,0 +1,29 @@
+#ifndef KRYLOV_H
+#define KRYLOV_H
+#include "stats.h"
+//Matrix-free Krylov solvers for Ax=b: A and the preconditioner are only seen through matvec callbacks
+//csr_matvec, jacobi_apply and ilu0_apply in sparse.h are ready made ones for CSR matrices
+
+//y=Ax for the n vector x; preconditioners use the same form for z=M^-1 r
+typedef void (*matvec)(const double *x,double *y,long n,void *ctx);
+
+//x.y over n entries, the loop cloned per instruction set level (see cpu.h); eigs and lbfgs use it too
+double krylov_dot(const double *x,const double *y,long n);
+
+//Both solvers start from the x passed in and stop when |b-Ax|<=tol*|b|
+//M may be NULL for no preconditioning; maxiter bounds the matrix-vector products
+//They return the number of iterations, or -1 if maxiter ran out or the method broke down
+//kstats gets the iterations, the products with A in nfev and the final relative residual
+
+//Preconditioned conjugate gradients for symmetric positive definite A (and M)
+//work must hold 4n doubles
+int cg(matvec A,void *actx,matvec M,void *mctx,const double *b,double *x,long n,
+	double tol,int maxiter,double *work,kstats *st);
+
+//Restarted GMRES(m) for general A, right preconditioned so the residual tested is that of A
+//Arnoldi with modified Gram-Schmidt, the least squares problem kept up to date by Givens rotations
+#define GMRES_WORK(n,m) ((long)((m)+2)*(n)+((m)+1)*((m)+4))
+//work must hold GMRES_WORK(n,m) doubles
+int gmres(matvec A,void *actx,matvec M,void *mctx,const double *b,double *x,long n,int m,
+	double tol,int maxiter,double *work,kstats *st);
+#endif
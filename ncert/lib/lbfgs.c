@@ -0,0 +1,216 @@
+#include <math.h>
+#include <string.h>
+#include "lbfgs.h"
+#include "cpu.h"
+#include "mc.h"
+#include "krylov.h"
+
+#define C1 1e-4		//sufficient decrease
+#define C2 0.9		//curvature
+#define LS_MAXEVAL 20	//evaluations one line search may take
+
+HOT void axpy(double a,const double *x,double *restrict y,long n){
+	for(long i=0;i<n;i++) y[i]+=a*x[i];
+}
+
+//d=-Hg from the k newest pairs, pair j (0 oldest) in slot (head+j)%m of S and Y
+HOT void twoloop(const double *S,const double *Y,const double *rho,double *alpha,const double *g,double *restrict d,
+	long n,int m,int k,int head){
+	for(long i=0;i<n;i++) d[i]=-g[i];
+	for(int j=k-1;j>=0;j--){
+		int s=(head+j)%m;
+		alpha[s]=rho[s]*krylov_dot(S+s*n,d,n);
+		axpy(-alpha[s],Y+s*n,d,n);
+	}
+	if(k>0){
+		int s=(head+k-1)%m;
+		double gamma=1/(rho[s]*krylov_dot(Y+s*n,Y+s*n,n));	//s.y/y.y
+		for(long i=0;i<n;i++) d[i]*=gamma;
+	}
+	for(int j=0;j<k;j++){
+		int s=(head+j)%m;
+		axpy(alpha[s]-rho[s]*krylov_dot(Y+s*n,d,n),S+s*n,d,n);
+	}
+}
+ISA_CLONES_VOID(twoloop,(const double *S,const double *Y,const double *rho,double *alpha,const double *g,double *d,
+	long n,int m,int k,int head),(S,Y,rho,alpha,g,d,n,m,k,head))
+
+typedef struct objective{
+	gradfunc f;
+	partfunc part;
+	void *ctx;
+	long n;
+	int nthreads;
+	long nfev;
+}objective;
+
+typedef struct job{
+	const objective *o;
+	const double *x;
+	double *g;
+	long lo,hi;
+	double f;
+}job;
+
+static void *run(void *arg){
+	job *j=(job*)arg;
+	j->f=j->o->part(j->x,j->g,j->lo,j->hi,j->o->n,j->o->ctx);
+	return NULL;
+}
+
+//f(x) and g, the shares of a separable f split over threads and added in index order
+static double evaluate(objective *o,const double *x,double *g){
+	o->nfev++;
+	if(o->f) return o->f(x,g,o->n,o->ctx);
+	int nthreads=o->nthreads;
+	if(nthreads<=1) return o->part(x,g,0,o->n,o->n,o->ctx);
+	job jobs[MC_MAXTHREADS];
+	for(int t=0;t<nthreads;t++){
+		job j={o,x,g,o->n*t/nthreads,o->n*(t+1)/nthreads,0};
+		jobs[t]=j;
+	}
+	parallel_for(nthreads,run,jobs,sizeof(job));
+	double f=jobs[0].f;
+	for(int t=1;t<nthreads;t++) f+=jobs[t].f;
+	return f;
+}
+
+//Minimiser of the cubic through (a,fa,da) and (b,fb,db), or the midpoint when it is not inside the
+//middle 80% of the interval
+static double cubic(double a,double fa,double da,double b,double fb,double db){
+	double d1=da+db-3*(fa-fb)/(a-b),disc=d1*d1-da*db,mid=(a+b)/2;
+	if(!(disc>=0)) return mid;
+	double d2=copysign(sqrt(disc),b-a),c=b-(b-a)*(db+d2-d1)/(db-da+2*d2);
+	double lo=fmin(a,b),w=fabs(b-a);
+	if(!(c>=lo+0.1*w&&c<=lo+0.9*w)) return mid;
+	return c;
+}
+
+//One trial point x+a*d into xt, gt; returns phi'(a)
+static double trial(objective *o,const double *x,const double *d,double a,double *xt,double *gt,double *ft){
+	long n=o->n;
+	for(long i=0;i<n;i++) xt[i]=x[i]+a*d[i];
+	*ft=evaluate(o,xt,gt);
+	return krylov_dot(gt,d,n);
+}
+
+//Strong Wolfe line search along the descent direction d from (x,f0,g) with phi'(0)=d0<0
+//On success the accepted point is left in xt, gt, ft and its step returned, otherwise 0
+static double search(objective *o,const double *x,double f0,double d0,const double *d,double a,
+	double *xt,double *gt,double *ft){
+	double prev=0,fprev=f0,dprev=d0;
+	double lo=0,flo=0,dlo=0,hi=0,fhi=0,dhi=0;
+	int e=0,zoom=0;
+	while(e<LS_MAXEVAL&&!zoom){
+		double da=trial(o,x,d,a,xt,gt,ft);
+		e++;
+		if(!isfinite(*ft)||*ft>f0+C1*a*d0||(e>1&&*ft>=fprev)){
+			if(!isfinite(*ft)){
+				a=prev+(a-prev)/4;	//stepped out of the domain, come back
+				continue;
+			}
+			lo=prev; flo=fprev; dlo=dprev;
+			hi=a; fhi=*ft; dhi=da;
+			zoom=1;
+		}
+		else if(fabs(da)<=-C2*d0) return a;
+		else if(da>=0){
+			lo=a; flo=*ft; dlo=da;
+			hi=prev; fhi=fprev; dhi=dprev;
+			zoom=1;
+		}
+		else{
+			prev=a; fprev=*ft; dprev=da;
+			a*=4;
+		}
+	}
+	//lo satisfies sufficient decrease and has the lowest f so far, the minimum lies between lo and hi
+	while(zoom&&e<LS_MAXEVAL){
+		a=cubic(lo,flo,dlo,hi,fhi,dhi);
+		double da=trial(o,x,d,a,xt,gt,ft);
+		e++;
+		if(!(*ft<=f0+C1*a*d0)||*ft>=flo){
+			hi=a; fhi=*ft; dhi=da;
+		}
+		else{
+			if(fabs(da)<=-C2*d0) return a;
+			if(da*(hi-lo)>=0){
+				hi=lo; fhi=flo; dhi=dlo;
+			}
+			lo=a; flo=*ft; dlo=da;
+		}
+		if(fabs(hi-lo)<=1e-16*fabs(lo)) break;
+	}
+	return 0;
+}
+
+static double infnorm(const double *g,long n){
+	double r=0;
+	for(long i=0;i<n;i++) r=fmax(r,fabs(g[i]));
+	return r;
+}
+
+static int minimise(objective *o,double *x,int m,double gtol,int maxiter,double *fx,double *work,kstats *st){
+	double t0=kstats_begin(st);
+	long n=o->n;
+	double *S=work,*Y=S+(long)m*n,*d=Y+(long)m*n,*g=d+n,*xt=g+n,*gt=xt+n,*rho=gt+n,*alpha=rho+m;
+	double f=evaluate(o,x,g),gn=infnorm(g,n);
+	int it=0,k=0,head=0,converged=gn<=gtol;
+	while(!converged&&it<maxiter){
+		ISA_CALL(twoloop)(S,Y,rho,alpha,g,d,n,m,k,head);
+		double d0=krylov_dot(g,d,n),ft;
+		if(!(d0<0)){	//lost descent to rounding, restart from steepest descent
+			if(k==0) break;
+			k=0;
+			continue;
+		}
+		//Unit steps once the pairs have scaled d, a first step of length 1 before that
+		double a=k>0?1:1/sqrt(krylov_dot(d,d,n));
+		a=search(o,x,f,d0,d,a,xt,gt,&ft);
+		if(a==0){
+			if(k==0) break;
+			k=0;	//the pairs gave a poor direction, forget them and retry
+			continue;
+		}
+		//The new pair overwrites the oldest once m are held
+		int s=k<m?(head+k)%m:head;
+		if(k<m) k++;
+		else head=(head+1)%m;
+		double *sv=S+s*n,*yv=Y+s*n;
+		for(long i=0;i<n;i++){
+			sv[i]=xt[i]-x[i];
+			yv[i]=gt[i]-g[i];
+		}
+		double sy=krylov_dot(sv,yv,n);
+		if(sy>0) rho[s]=1/sy;
+		else k--;	//strong Wolfe makes s.y>0 in exact arithmetic, drop the pair if rounding did not
+		memcpy(x,xt,n*sizeof(double));
+		memcpy(g,gt,n*sizeof(double));
+		f=ft;
+		gn=infnorm(g,n);
+		it++;
+		KTRACE(st,"lbfgs",it,gn);
+		converged=gn<=gtol;
+	}
+	if(fx) *fx=f;
+	if(st){
+		st->iterations=it;
+		st->nfev=o->nfev;
+		st->residual=gn;
+	}
+	kstats_end(st,t0);
+	return converged?it:-1;
+}
+
+int lbfgs(gradfunc f,void *ctx,double *x,long n,int m,double gtol,int maxiter,double *fx,double *work,kstats *st){
+	objective o={f,NULL,ctx,n,1,0};
+	return minimise(&o,x,m,gtol,maxiter,fx,work,st);
+}
+
+int lbfgs_sep(partfunc f,void *ctx,double *x,long n,int m,double gtol,int maxiter,double *fx,double *work,
+	int nthreads,kstats *st){
+	if(nthreads>MC_MAXTHREADS) nthreads=MC_MAXTHREADS;
+	if(nthreads>n/LBFGS_CHUNK) nthreads=(int)(n/LBFGS_CHUNK);
+	objective o={NULL,f,ctx,n,nthreads,0};
+	return minimise(&o,x,m,gtol,maxiter,fx,work,st);
+}
@@ -0,0 +1,31 @@
+#ifndef LBFGS_H
+#define LBFGS_H
+#include "stats.h"
+//Limited memory BFGS minimisation of f over R^n, the n dimensional counterpart of gd_walk
+//The search direction comes from the two-loop recursion over the last m correction pairs,
+//the step from a line search satisfying the strong Wolfe conditions (Nocedal and Wright, alg. 3.5/3.6)
+
+//Returns f(x) and writes its gradient into g[0..n-1]
+typedef double (*gradfunc)(const double *x,double *g,long n,void *ctx);
+//Separable f, split over the indices: returns the share of f owned by lo..hi-1 and writes g[lo..hi-1]
+//in full (x may be read anywhere), so that the shares of a partition of 0..n-1 sum to f
+//Disjoint ranges are evaluated concurrently
+typedef double (*partfunc)(const double *x,double *g,long lo,long hi,long n,void *ctx);
+
+//Fewest indices per thread for lbfgs_sep
+#define LBFGS_CHUNK 16384
+
+//work must hold LBFGS_WORK(n,m) doubles
+#define LBFGS_WORK(n,m) (2L*((m)+2)*(n)+2L*(m))
+
+//Minimises from the x passed in until |grad f|_inf<=gtol and leaves the minimiser in x, f there in *fx
+//(fx may be NULL); maxiter bounds the iterations, each of which takes one or more evaluations
+//Returns the number of iterations, or -1 if maxiter ran out or no step along the steepest descent
+//direction satisfies the line search
+//kstats gets the iterations, the evaluations (value and gradient together) and the final |grad f|_inf
+int lbfgs(gradfunc f,void *ctx,double *x,long n,int m,double gtol,int maxiter,double *fx,double *work,kstats *st);
+
+//The same for a separable f evaluated by up to nthreads threads of at least LBFGS_CHUNK indices each
+int lbfgs_sep(partfunc f,void *ctx,double *x,long n,int m,double gtol,int maxiter,double *fx,double *work,
+	int nthreads,kstats *st);
+#endif
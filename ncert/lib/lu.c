@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <math.h>
+#include <float.h>
+#include "lu.h"
+#include "cpu.h"
+
+#define PREC 'f'
+#include "scalar.h"
+#include "lu_impl.h"
+#undef PREC
+#define PREC 'd'
+#include "scalar.h"
+#include "lu_impl.h"
+#undef PREC
+#define PREC 'l'
+#include "scalar.h"
+#include "lu_impl.h"
+#undef PREC
+#define PREC 'c'
+#include "scalar.h"
+#include "lu_impl.h"
+#undef PREC
+
+//r=b-Ax in double, each row a contiguous dot product that vectorises; returns |r|_inf
+HOT double residual(const double *A,long lda,const double *b,const double *x,double *r,int n){
+	double rmax=0;
+	for(int i=0;i<n;i++){
+		const double *a=A+i*lda;
+		double s=0;
+		for(int j=0;j<n;j++) s+=a[j]*x[j];
+		r[i]=b[i]-s;
+		rmax=fmax(rmax,fabs(r[i]));
+	}
+	return rmax;
+}
+ISA_CLONES(double,residual,(const double *A,long lda,const double *b,const double *x,double *r,int n),(A,lda,b,x,r,n))
+
+//Refines x with residuals in double and corrections from the float factors luf, or the double ones lud
+//if luf is NULL, through step *k of at most maxiter; returns 1 once |b-Ax|_inf<=n*eps*|A|_inf*|x|_inf,
+//0 if a step fails to halve the residual (or it is not finite) or the steps run out
+static int refine(const double *A,long lda,const double *b,double *x,int n,double anorm,
+	const float *luf,const double *lud,const int *piv,double *r,float *cf,int maxiter,int *k,kstats *st){
+	double prev=INFINITY;
+	for(int step=0;;step++){
+		double rnorm=ISA_CALL(residual)(A,lda,b,x,r,n),xnorm=0;
+		for(int i=0;i<n;i++) xnorm=fmax(xnorm,fabs(x[i]));
+		if(st){
+			st->nfev++;
+			st->residual=xnorm>0?rnorm/(anorm*xnorm):rnorm;
+		}
+		KTRACE(st,"lu_solve_mixed",*k,xnorm>0?rnorm/(anorm*xnorm):rnorm);
+		if(rnorm<=n*DBL_EPSILON*anorm*xnorm) return 1;
+		if(!(rnorm<0.5*prev)||step==maxiter) return 0;
+		prev=rnorm;
+		//Correction A d=r, x+=d
+		if(luf){
+			for(int i=0;i<n;i++) cf[i]=(float)r[i];
+			lu_subst_piv_f(luf,n,piv,cf,cf,n);
+			for(int i=0;i<n;i++) x[i]+=cf[i];
+		}else{
+			lu_subst_piv(lud,n,piv,r,r,n);
+			for(int i=0;i<n;i++) x[i]+=r[i];
+		}
+		(*k)++;
+		if(st) st->iterations=*k;
+	}
+}
+
+int lu_solve_mixed(const double *A,long lda,const double *b,double *x,int n,int maxiter,double *work,kstats *st){
+	double t0=kstats_begin(st);
+	//The float factors take the first half of the n*n doubles the double fallback needs
+	float *luf=(float*)work,*cf=(float*)(work+(long)n*n+n);
+	double *r=work+(long)n*n,anorm=0;
+	int *piv=(int*)(work+(long)n*n+2L*n),k=0,ret=-1;
+	for(int i=0;i<n;i++){
+		double s=0;
+		for(int j=0;j<n;j++){
+			s+=fabs(A[i*lda+j]);
+			luf[(long)i*n+j]=(float)A[i*lda+j];
+		}
+		anorm=fmax(anorm,s);
+	}
+	if(lu_decompose_piv_f(luf,n,piv,n)==0){
+		for(int i=0;i<n;i++) cf[i]=(float)b[i];
+		lu_subst_piv_f(luf,n,piv,cf,cf,n);
+		for(int i=0;i<n;i++) x[i]=cf[i];
+		if(refine(A,lda,b,x,n,anorm,luf,NULL,piv,r,cf,maxiter,&k,st)){
+			kstats_end(st,t0);
+			return 0;
+		}
+	}
+	//Float factors singular (underflow) or not enough: double factors, refined the same way
+	for(int i=0;i<n;i++){
+		for(int j=0;j<n;j++) work[(long)i*n+j]=A[i*lda+j];
+	}
+	if(lu_decompose_piv(work,n,piv,n)==0){
+		lu_subst_piv(work,n,piv,b,x,n);
+		if(refine(A,lda,b,x,n,anorm,NULL,work,piv,r,cf,maxiter,&k,st)) ret=1;
+	}
+	kstats_end(st,t0);
+	return ret;
+}
+
+void mat_print(const double *M,long ld,int n,const char *name){
+	printf("%s:\n",name);
+	for(int i=0;i<n;i++){
+		for(int j=0;j<n;j++){
+			printf("%8.4f ",M[i*ld+j]);
+		}
+		printf("\n");
+	}
+	printf("\n");
+}
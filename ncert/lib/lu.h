@@ -0,0 +1,54 @@
+#ifndef LU_H
+#define LU_H
+#include <complex.h>
+#include "stats.h"
+//Dense LU decomposition (Doolittle, no pivoting) and triangular solves on row-major buffers
+//Row i of a matrix starts at i*ld, so sub-blocks and NumPy arrays can be passed as they are
+
+//A=LU into L (unit lower) and U (upper), L and U may be the same buffer (compact storage)
+//Returns -1 if a pivot other than the last one is zero
+int lu_decompose(const double *A,long lda,double *L,long ldl,double *U,long ldu,int n);
+
+//Solve Ax=b for x, lu must hold n*n doubles of scratch; returns -1 if A is singular
+int lu_solve(const double *A,long lda,const double *b,double *x,int n,double *lu);
+
+//Forward and back substitution with compact factors from lu_decompose, b and x may alias
+void lu_subst(const double *lu,long ld,const double *b,double *x,int n);
+
+//In place LU with partial pivoting on the n x n matrix at lu: PA=LU with compact factors, row k
+//swapped with row piv[k] before step k; returns -1 if a whole pivot column is zero (A singular)
+int lu_decompose_piv(double *lu,long ld,int *piv,int n);
+//Solve with factors from lu_decompose_piv, b and x may alias
+void lu_subst_piv(const double *lu,long ld,const int *piv,const double *b,double *x,int n);
+
+//The same kernels in float (_f), long double (_l) and double complex (_c)
+int lu_decompose_f(const float *A,long lda,float *L,long ldl,float *U,long ldu,int n);
+int lu_solve_f(const float *A,long lda,const float *b,float *x,int n,float *lu);
+void lu_subst_f(const float *lu,long ld,const float *b,float *x,int n);
+int lu_decompose_piv_f(float *lu,long ld,int *piv,int n);
+void lu_subst_piv_f(const float *lu,long ld,const int *piv,const float *b,float *x,int n);
+int lu_decompose_l(const long double *A,long lda,long double *L,long ldl,long double *U,long ldu,int n);
+int lu_solve_l(const long double *A,long lda,const long double *b,long double *x,int n,long double *lu);
+void lu_subst_l(const long double *lu,long ld,const long double *b,long double *x,int n);
+int lu_decompose_piv_l(long double *lu,long ld,int *piv,int n);
+void lu_subst_piv_l(const long double *lu,long ld,const int *piv,const long double *b,long double *x,int n);
+int lu_decompose_c(const double complex *A,long lda,double complex *L,long ldl,double complex *U,long ldu,int n);
+int lu_solve_c(const double complex *A,long lda,const double complex *b,double complex *x,int n,double complex *lu);
+void lu_subst_c(const double complex *lu,long ld,const double complex *b,double complex *x,int n);
+int lu_decompose_piv_c(double complex *lu,long ld,int *piv,int n);
+void lu_subst_piv_c(const double complex *lu,long ld,const int *piv,const double complex *b,double complex *x,int n);
+
+//Mixed precision solve of Ax=b: A is factored in float with partial pivoting, then x is refined with
+//residuals b-Ax computed in double until |b-Ax|_inf<=n*eps*|A|_inf*|x|_inf, so double accuracy costs
+//O(n^2) per step. If a step fails to halve the residual, or maxiter steps do not converge, A is factored
+//again in double with partial pivoting and refined the same way with the double factors
+//Returns 0 when the float factors converged, 1 when the double ones did, -1 if A is singular or
+//neither converged; st (NULL or a kstats) gets all refinement steps, residual products and the
+//final relative residual
+//work holds the factors (n*n), the residual and correction (2n) and the pivots
+#define LU_MIXED_WORK(n) ((long)(n)*(n)+2L*(n)+((n)+1)/2)
+int lu_solve_mixed(const double *A,long lda,const double *b,double *x,int n,int maxiter,double *work,kstats *st);
+
+//Prints an n x n matrix under a heading
+void mat_print(const double *M,long ld,int n,const char *name);
+#endif
@@ -0,0 +1,117 @@
+//Generic LU body, instantiated by lu.c for each precision (see scalar.h)
+
+//Factorisation loops, cloned per instruction set level (see cpu.h)
+HOT int FN(lu_factor)(const T *A,long lda,T *L,long ldl,T *U,long ldu,int n){
+	int i,j,k;
+	//Initialize L and U
+	for(i=0;i<n;i++){
+		for(j=0;j<n;j++){
+			L[i*ldl+j]=(i==j);	//Diagonal elements of L are 1
+			U[i*ldu+j]=0;
+		}
+	}
+	for(i=0;i<n;i++){
+		//Row i of U, the update runs along contiguous rows so it vectorises
+		for(j=i;j<n;j++){
+			U[i*ldu+j]=A[i*lda+j];
+		}
+		for(k=0;k<i;k++){
+			T l=L[i*ldl+k];
+			for(j=i;j<n;j++){
+				U[i*ldu+j]-=l*U[k*ldu+j];
+			}
+		}
+		if(i<n-1&&U[i*ldu+i]==0){
+			return -1;
+		}
+		//Column i of L
+		for(j=i+1;j<n;j++){
+			T s=A[j*lda+i];
+			for(k=0;k<i;k++){
+				s-=L[j*ldl+k]*U[k*ldu+i];
+			}
+			L[j*ldl+i]=s/U[i*ldu+i];
+		}
+	}
+	return 0;
+}
+ISA_CLONES(int,FN(lu_factor),(const T *A,long lda,T *L,long ldl,T *U,long ldu,int n),(A,lda,L,ldl,U,ldu,n))
+
+int FN(lu_decompose)(const T *A,long lda,T *L,long ldl,T *U,long ldu,int n){
+	return ISA_CALL(FN(lu_factor))(A,lda,L,ldl,U,ldu,n);
+}
+
+void FN(lu_subst)(const T *lu,long ld,const T *b,T *x,int n){
+	//Forward substitution Ly=b, y is kept in x
+	for(int i=0;i<n;i++){
+		T s=b[i];
+		for(int k=0;k<i;k++){
+			s-=lu[i*ld+k]*x[k];
+		}
+		x[i]=s;
+	}
+	//Back substitution Ux=y
+	for(int i=n-1;i>=0;i--){
+		T s=x[i];
+		for(int k=i+1;k<n;k++){
+			s-=lu[i*ld+k]*x[k];
+		}
+		x[i]=s/lu[i*ld+i];
+	}
+}
+
+int FN(lu_solve)(const T *A,long lda,const T *b,T *x,int n,T *lu){
+	if(FN(lu_decompose)(A,lda,lu,n,lu,n,n)!=0||lu[(long)n*n-1]==0){
+		return -1;
+	}
+	FN(lu_subst)(lu,n,b,x,n);
+	return 0;
+}
+
+//In place LU with partial pivoting, PA=LU: row k was swapped with row piv[k] before step k
+//Right looking, so every update runs along a contiguous row and vectorises
+HOT int FN(lu_factor_piv)(T *lu,long ld,int *piv,int n){
+	for(int k=0;k<n;k++){
+		int p=k;
+		R big=ABS(lu[k*ld+k]);
+		for(int i=k+1;i<n;i++){
+			if(ABS(lu[i*ld+k])>big){
+				big=ABS(lu[i*ld+k]);
+				p=i;
+			}
+		}
+		piv[k]=p;
+		if(big==0) return -1;
+		if(p!=k){
+			for(int j=0;j<n;j++){
+				T t=lu[k*ld+j];
+				lu[k*ld+j]=lu[p*ld+j];
+				lu[p*ld+j]=t;
+			}
+		}
+		const T *u=lu+k*ld;
+		for(int i=k+1;i<n;i++){
+			T *row=lu+i*ld;
+			T l=row[k]/=u[k];
+			for(int j=k+1;j<n;j++) row[j]-=l*u[j];
+		}
+	}
+	return 0;
+}
+ISA_CLONES(int,FN(lu_factor_piv),(T *lu,long ld,int *piv,int n),(lu,ld,piv,n))
+
+int FN(lu_decompose_piv)(T *lu,long ld,int *piv,int n){
+	return ISA_CALL(FN(lu_factor_piv))(lu,ld,piv,n);
+}
+
+void FN(lu_subst_piv)(const T *lu,long ld,const int *piv,const T *b,T *x,int n){
+	if(x!=b){
+		for(int i=0;i<n;i++) x[i]=b[i];
+	}
+	for(int k=0;k<n;k++){
+		T t=x[k];
+		x[k]=x[piv[k]];
+		x[piv[k]]=t;
+	}
+	FN(lu_subst)(lu,ld,x,x,n);
+}
@@ -0,0 +1,144 @@
+#include <pthread.h>
+#include <unistd.h>
+#include "rng.h"
+#include "mc.h"
+#include "cpu.h"
+
+int mc_ncpu(void){
+	long n=sysconf(_SC_NPROCESSORS_ONLN);
+	return n<1?1:(n>MC_MAXTHREADS?MC_MAXTHREADS:(int)n);
+}
+
+//Worker w runs job w of each dispatch; busy is held by the parallel_for that owns the workers
+static struct{
+	pthread_mutex_t busy,m;
+	pthread_cond_t go,done;
+	pthread_t tid[MC_MAXTHREADS];
+	int nworkers,njobs,pending;
+	unsigned long gen;
+	void *(*fn)(void*);
+	char *jobs;
+	size_t size;
+}pool={PTHREAD_MUTEX_INITIALIZER,PTHREAD_MUTEX_INITIALIZER,PTHREAD_COND_INITIALIZER,PTHREAD_COND_INITIALIZER};
+
+static void *worker(void *arg){
+	int w=(int)(size_t)arg;
+	unsigned long seen=0;
+	pthread_mutex_lock(&pool.m);
+	for(;;){
+		while(pool.gen==seen) pthread_cond_wait(&pool.go,&pool.m);
+		seen=pool.gen;
+		if(w>=pool.njobs) continue;
+		void *(*fn)(void*)=pool.fn;
+		void *job=pool.jobs+(size_t)w*pool.size;
+		pthread_mutex_unlock(&pool.m);
+		fn(job);
+		pthread_mutex_lock(&pool.m);
+		if(--pool.pending==0) pthread_cond_signal(&pool.done);
+	}
+	return NULL;
+}
+
+//The old fork/join, for calls that find the workers busy
+static int forkjoin(int njobs,void *(*fn)(void*),char *jobs,size_t size){
+	pthread_t tid[MC_MAXTHREADS];
+	int started[MC_MAXTHREADS],ret=0;
+	for(int t=1;t<njobs;t++){
+		started[t]=pthread_create(&tid[t],NULL,fn,jobs+(size_t)t*size)==0;
+		if(!started[t]) ret=-1;
+	}
+	fn(jobs);
+	for(int t=1;t<njobs;t++){
+		if(started[t]) pthread_join(tid[t],NULL);
+		else fn(jobs+(size_t)t*size);
+	}
+	return ret;
+}
+
+int parallel_for(int njobs,void *(*fn)(void*),void *jobs,size_t size){
+	char *j=(char*)jobs;
+	if(njobs>MC_MAXTHREADS) njobs=MC_MAXTHREADS;
+	if(njobs<=1){
+		if(njobs==1) fn(j);
+		return 0;
+	}
+	if(pthread_mutex_trylock(&pool.busy)!=0) return forkjoin(njobs,fn,j,size);
+	//Workers 1..njobs-1, the ones that fail to start leave their jobs to this thread
+	while(pool.nworkers<njobs-1){
+		int w=pool.nworkers+1;
+		if(pthread_create(&pool.tid[w],NULL,worker,(void*)(size_t)w)!=0) break;
+		pthread_detach(pool.tid[w]);
+		pool.nworkers++;
+	}
+	int nw=pool.nworkers<njobs-1?pool.nworkers:njobs-1;
+	pthread_mutex_lock(&pool.m);
+	pool.fn=fn;
+	pool.jobs=j;
+	pool.size=size;
+	pool.njobs=nw+1;
+	pool.pending=nw;
+	pool.gen++;
+	pthread_cond_broadcast(&pool.go);
+	pthread_mutex_unlock(&pool.m);
+	fn(j);
+	for(int t=nw+1;t<njobs;t++) fn(j+(size_t)t*size);
+	pthread_mutex_lock(&pool.m);
+	while(pool.pending>0) pthread_cond_wait(&pool.done,&pool.m);
+	pthread_mutex_unlock(&pool.m);
+	pthread_mutex_unlock(&pool.busy);
+	return nw<njobs-1?-1:0;
+}
+
+//Successes among the 4*m words of counters c0..c0+m-1, compared against an integer threshold
+//Every lane is independent so the loop vectorises across counters
+HOT uint64_t countblocks(uint64_t c0,uint64_t m,uint32_t k0,uint32_t k1,uint64_t thr){
+	uint64_t hits=0;
+	for(uint64_t i=0;i<m;i++){
+		uint64_t c=c0+i;
+		uint32_t ctr[4]={(uint32_t)c,(uint32_t)(c>>32),0,0},key[2]={k0,k1},out[4];
+		philox4x32(ctr,key,out);
+		hits+=(out[0]<thr)+(out[1]<thr)+(out[2]<thr)+(out[3]<thr);
+	}
+	return hits;
+}
+ISA_CLONES(uint64_t,countblocks,(uint64_t c0,uint64_t m,uint32_t k0,uint32_t k1,uint64_t thr),(c0,m,k0,k1,thr))
+
+//Share of the counter range given to one thread
+typedef struct job{
+	uint64_t c0,m,thr,hits;
+	uint32_t k0,k1;
+}job;
+
+static void *run(void *arg){
+	job *j=(job*)arg;
+	j->hits=ISA_CALL(countblocks)(j->c0,j->m,j->k0,j->k1,j->thr);
+	return NULL;
+}
+
+uint64_t mc_bernoulli(double p,uint64_t n,uint64_t seed,int nthreads){
+	if(p<=0) return 0;
+	if(p>=1) return n;
+	//p*2^32 as an integer: u<thr happens with probability p to within 2^-32
+	uint64_t thr=(uint64_t)(p*4294967296.0);
+	uint32_t k0=(uint32_t)seed,k1=(uint32_t)(seed>>32);
+	uint64_t full=n/4,hits=0;
+	if(nthreads<=0) nthreads=mc_ncpu();
+	if(nthreads>MC_MAXTHREADS) nthreads=MC_MAXTHREADS;
+	if((uint64_t)nthreads>full) nthreads=full>0?(int)full:1;
+	job jobs[MC_MAXTHREADS];
+	for(int t=0;t<nthreads;t++){
+		job j={full*t/nthreads,full*(t+1)/nthreads-full*t/nthreads,thr,0,k0,k1};
+		jobs[t]=j;
+	}
+	parallel_for(nthreads,run,jobs,sizeof(job));
+	for(int t=0;t<nthreads;t++) hits+=jobs[t].hits;
+	//Last n%4 trials use the leading words of one more block
+	if(n%4){
+		uint32_t ctr[4]={(uint32_t)full,(uint32_t)(full>>32),0,0},key[2]={k0,k1},out[4];
+		philox4x32(ctr,key,out);
+		for(uint64_t i=0;i<n%4;i++){
+			hits+=out[i]<thr;
+		}
+	}
+	return hits;
+}
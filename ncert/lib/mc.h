@@ -0,0 +1,23 @@
+#ifndef MC_H
+#define MC_H
+#include <stdint.h>
+#include <stddef.h>
+//Multithreaded Monte Carlo on top of the Philox generator in rng.h
+
+//Number of successes in n Bernoulli(p) trials
+//Trial i always uses the same random word for a given seed, so the count does not
+//depend on nthreads; nthreads<=0 uses every online CPU
+uint64_t mc_bernoulli(double p,uint64_t n,uint64_t seed,int nthreads);
+
+//Most threads any call in the lib uses
+#define MC_MAXTHREADS 64
+
+//Online CPU count, used as the default thread count by the lib
+int mc_ncpu(void);
+
+//Runs fn on each of the njobs<=MC_MAXTHREADS records of size bytes at jobs, job 0 on the calling
+//thread and the rest on workers started on first use and kept for later calls; returns once all are done
+//A call made while the workers are busy (from a job, or from another thread) starts threads of its own
+//Returns 0, or -1 if a worker could not be started (its job then ran on the calling thread)
+int parallel_for(int njobs,void *(*fn)(void*),void *jobs,size_t size);
+#endif
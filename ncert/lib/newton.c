@@ -0,0 +1,25 @@
+#include <math.h>
+#include "newton.h"
+
+int newton_root(dualfunc f,void *ctx,double x0,double tol,int maxiter,double *root,kstats *st){
+	double t0=kstats_begin(st);
+	double x=x0;
+	dual y=f(x,ctx);
+	int it=0,ret;
+	while(fabs(y.v)>tol){
+		if(it>=maxiter||y.d==0) break;
+		x-=y.v/y.d;	//Update using Newton-Raphson
+		y=f(x,ctx);
+		it++;
+		KTRACE(st,"newton_root",it,fabs(y.v));
+	}
+	ret=fabs(y.v)>tol?-1:it;
+	*root=x;
+	if(st){
+		st->iterations=it;
+		st->nfev=it+1;
+		st->residual=fabs(y.v);
+	}
+	kstats_end(st,t0);
+	return ret;
+}
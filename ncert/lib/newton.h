@@ -0,0 +1,15 @@
+#ifndef NEWTON_H
+#define NEWTON_H
+#include "dual.h"
+#include "stats.h"
+//Newton-Raphson root finding on a function that returns its value and derivative together
+
+typedef dual (*dualfunc)(double x,void *ctx);
+typedef dual_f (*dualfunc_f)(float x,void *ctx);
+typedef dual_l (*dualfunc_l)(long double x,void *ctx);
+
+//Iterates from x0 until |f(x)|<=tol and stores the root
+//Returns the number of iterations, or -1 if maxiter ran out or f'(x) became 0
+//st (may be NULL) receives iterations, evaluations, the final |f| and the wall time
+int newton_root(dualfunc f,void *ctx,double x0,double tol,int maxiter,double *root,kstats *st);
+#endif
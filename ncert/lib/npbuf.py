@@ -0,0 +1,34 @@
+# Zero-copy helpers for handing NumPy arrays to the ncert C kernels through ctypes
+# The C variants (fxbuf, solvebuf, QRAlgorithmbuf, ...) write straight into these buffers
+import ctypes
+import numpy as np
+
+
+def ptr(a, dtype):
+    """Data pointer of the ndarray a, which must already have the given dtype (no copy is made)"""
+    if not isinstance(a, np.ndarray) or a.dtype != np.dtype(dtype):
+        raise TypeError(f"expected an ndarray of {np.dtype(dtype)}")
+    return ctypes.c_void_p(a.ctypes.data)
+
+
+def stride(a, axis=0):
+    """Stride of a along axis in elements, the unit the C side expects"""
+    if a.strides[axis] % a.itemsize:
+        raise ValueError("stride is not a whole number of elements")
+    return a.strides[axis] // a.itemsize
+
+
+def rows(a, dtype):
+    """Pointer and row stride of a 2-D array whose rows are contiguous"""
+    if a.ndim != 2 or a.strides[1] != a.itemsize:
+        raise ValueError("expected a 2-D array with contiguous rows")
+    return ptr(a, dtype), stride(a, 0)
+
+
+def mapped(path, dtype=None, ncols=1):
+    """Read-only memory map of a file written by an npysink, no copy is made
+    .npy files carry their own dtype and shape, raw ones (npy=0) need dtype and ncols"""
+    if dtype is None:
+        return np.load(path, mmap_mode="r")
+    m = np.memmap(path, dtype=dtype, mode="r")
+    return m if ncols == 1 else m.reshape(-1, ncols)
@@ -0,0 +1,136 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "npysink.h"
+
+//pwrite until everything is out, a short write is not an error
+static void *flushjob(void *arg){
+	npywrite *w=(npywrite*)arg;
+	const char *p=(const char*)w->p;
+	long len=w->len,off=w->off;
+	while(len>0){
+		ssize_t k=pwrite(w->fd,p,len,off);
+		if(k<=0){
+			w->err=1;
+			break;
+		}
+		p+=k;
+		len-=k;
+		off+=k;
+	}
+	return NULL;
+}
+
+static void join(npysink *s){
+	if(s->writing){
+		pthread_join(s->writer,NULL);
+		s->writing=0;
+		if(s->w.err) s->err=1;
+	}
+}
+
+//Hands the current buffer to the writer and switches to the other one
+static void flush(npysink *s){
+	if(s->fill==0) return;
+	join(s);
+	npywrite w={s->fd,0,s->buf[s->cur],s->fill*s->ncols*s->itemsize,s->off};
+	s->w=w;
+	if(pthread_create(&s->writer,NULL,flushjob,&s->w)==0) s->writing=1;
+	else{
+		flushjob(&s->w);	//no thread, write inline
+		if(s->w.err) s->err=1;
+	}
+	s->off+=s->w.len;
+	s->cur^=1;
+	s->fill=0;
+}
+
+//Version 1.0 header padded with spaces to NPYSINK_HEADER bytes
+static int header(npysink *s){
+	char h[NPYSINK_HEADER];
+	char dict[NPYSINK_HEADER];
+	int n;
+	if(s->ncols==1) n=snprintf(dict,sizeof(dict),"{'descr': '%s', 'fortran_order': False, 'shape': (%ld,), }",s->descr,s->rows);
+	else n=snprintf(dict,sizeof(dict),"{'descr': '%s', 'fortran_order': False, 'shape': (%ld, %d), }",s->descr,s->rows,s->ncols);
+	int len=NPYSINK_HEADER-10;
+	if(n<0||n>=len) return -1;
+	memcpy(h,"\x93NUMPY\x01\x00",8);
+	h[8]=(char)(len&0xff);
+	h[9]=(char)(len>>8);
+	memset(h+10,' ',len);
+	memcpy(h+10,dict,n);
+	h[NPYSINK_HEADER-1]='\n';
+	npywrite w={s->fd,0,h,NPYSINK_HEADER,0};
+	flushjob(&w);
+	return w.err?-1:0;
+}
+
+int npysink_open(npysink *s,const char *path,const char *descr,int ncols,int npy){
+	memset(s,0,sizeof(*s));
+	if(ncols<1||strlen(descr)!=3||(descr[1]!='f'&&descr[1]!='i')) return -1;
+	strcpy(s->descr,descr);
+	s->itemsize=descr[2]-'0';
+	if(s->itemsize!=4&&s->itemsize!=8) return -1;
+	s->ncols=ncols;
+	s->npy=npy;
+	s->rowcap=NPYSINK_CHUNK/(ncols*s->itemsize);
+	if(s->rowcap<1) s->rowcap=1;
+	s->buf[0]=(char*)malloc(s->rowcap*ncols*s->itemsize);
+	s->buf[1]=(char*)malloc(s->rowcap*ncols*s->itemsize);
+	s->fd=open(path,O_WRONLY|O_CREAT|O_TRUNC,0644);
+	if(!s->buf[0]||!s->buf[1]||s->fd<0||(npy&&header(s))){
+		if(s->fd>=0) close(s->fd);
+		free(s->buf[0]);
+		free(s->buf[1]);
+		return -1;
+	}
+	s->off=npy?NPYSINK_HEADER:0;
+	return 0;
+}
+
+void *npysink_reserve(npysink *s,long *nrows){
+	if(s->fill==s->rowcap||(s->fill>0&&s->fill+*nrows>s->rowcap)) flush(s);
+	if(*nrows>s->rowcap-s->fill) *nrows=s->rowcap-s->fill;
+	return s->buf[s->cur]+s->fill*s->ncols*s->itemsize;
+}
+
+void npysink_commit(npysink *s,long nrows){
+	s->fill+=nrows;
+	s->rows+=nrows;
+	if(s->fill==s->rowcap) flush(s);
+}
+
+int npysink_write(npysink *s,const void *v,long nrows){
+	const char *p=(const char*)v;
+	while(nrows>0){
+		long m=nrows;
+		void *d=npysink_reserve(s,&m);
+		memcpy(d,p,m*s->ncols*s->itemsize);
+		npysink_commit(s,m);
+		p+=m*s->ncols*s->itemsize;
+		nrows-=m;
+	}
+	return s->err?-1:0;
+}
+
+int npysink_close(npysink *s){
+	flush(s);
+	join(s);
+	if(s->npy&&header(s)) s->err=1;
+	if(close(s->fd)) s->err=1;
+	free(s->buf[0]);
+	free(s->buf[1]);
+	s->buf[0]=s->buf[1]=NULL;
+	return s->err?-1:0;
+}
+
+void npysink_ode(double x,double y,void *ctx){
+	npysink *s=(npysink*)ctx;
+	long one=1;
+	double *row=(double*)npysink_reserve(s,&one);
+	row[0]=x;
+	row[1]=y;
+	npysink_commit(s,1);
+}
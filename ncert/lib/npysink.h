@@ -0,0 +1,52 @@
+#ifndef NPYSINK_H
+#define NPYSINK_H
+#include <pthread.h>
+//Streaming output of long kernel runs to a .npy (or raw binary) file with double buffering
+//Kernels fill one buffer while a writer thread pwrite()s the other, so compute and I/O overlap
+//and only two buffers are ever in memory; the result opens with np.load(path, mmap_mode="r")
+
+//Bytes per buffer
+#define NPYSINK_CHUNK (1<<20)
+//Bytes reserved for the .npy header, rewritten with the final row count on close
+#define NPYSINK_HEADER 128
+
+typedef struct npywrite{
+	int fd,err;
+	const void *p;
+	long len,off;
+}npywrite;
+
+typedef struct npysink{
+	int fd,ncols,itemsize,npy,err;
+	char descr[8];
+	long rows;		//rows committed so far
+	long rowcap;		//rows per buffer
+	char *buf[2];
+	int cur;		//buffer being filled
+	long fill;		//rows in it
+	long off;		//file offset of its first byte
+	pthread_t writer;
+	int writing;		//a write of the other buffer is in flight
+	npywrite w;
+}npysink;
+
+//Creates path for rows of ncols values of the NumPy type descr ("<f8", "<f4", "<i8" or "<i4")
+//npy=0 writes raw values with no header, for np.memmap(path, dtype, shape=(rows, ncols))
+//Returns 0, or -1 if the file or buffers could not be created
+int npysink_open(npysink *s,const char *path,const char *descr,int ncols,int npy);
+
+//Space for up to *nrows rows in the current buffer, *nrows is lowered to what fits
+//Write the rows there and then npysink_commit() the number actually used
+void *npysink_reserve(npysink *s,long *nrows);
+void npysink_commit(npysink *s,long nrows);
+
+//Copies nrows rows from v, returns 0 or -1 after a write error
+int npysink_write(npysink *s,const void *v,long nrows);
+
+//Writes what is left, fixes up the header shape and closes the file
+//Returns 0, or -1 if any write failed
+int npysink_close(npysink *s);
+
+//odesink for rk45_stream writing (x,y) rows, ctx is an npysink of "<f8" with 2 columns
+void npysink_ode(double x,double y,void *ctx);
+#endif
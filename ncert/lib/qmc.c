@@ -0,0 +1,201 @@
+#include <math.h>
+#include "qmc.h"
+#include "mc.h"
+#include "rng.h"
+#include "cpu.h"
+#include "stats.h"
+
+#define BITS 32
+
+//Joe-Kuo (new-joe-kuo-6.21201) primitive polynomials for dimensions 2..QMC_MAXDIM: degree s,
+//inner coefficients a and initial direction numbers m_1..m_s; dimension 1 is van der Corput
+static const struct{
+	int s,a,m[7];
+}poly[QMC_MAXDIM-1]={
+	{1,0,{1}},{2,1,{1,3}},{3,1,{1,3,1}},{3,2,{1,1,1}},
+	{4,1,{1,1,3,3}},{4,4,{1,3,5,13}},{5,2,{1,1,5,5,17}},{5,4,{1,1,5,5,5}},
+	{5,7,{1,1,7,11,19}},{5,11,{1,1,5,1,1}},{5,13,{1,1,1,3,11}},{5,14,{1,3,5,5,31}},
+	{6,1,{1,3,3,9,7,49}},{6,13,{1,1,1,15,21,21}},{6,16,{1,3,1,13,27,49}},{6,19,{1,1,1,15,7,5}},
+	{6,22,{1,3,1,15,13,25}},{6,25,{1,1,5,5,19,61}},{7,1,{1,3,7,11,23,15,103}},{7,4,{1,3,7,13,13,15,69}}};
+
+//Direction numbers v[b*QMC_MAXDIM+d] for bit b of the point index, most significant digit first
+//Stored bit-major so one Gray code step is a contiguous XOR across the dimensions
+static void directions(uint32_t *v,int dim){
+	for(int b=0;b<BITS;b++) v[b*QMC_MAXDIM]=1u<<(BITS-1-b);
+	for(int d=1;d<dim;d++){
+		int s=poly[d-1].s,a=poly[d-1].a;
+		for(int b=0;b<BITS;b++){
+			uint32_t w;
+			if(b<s) w=(uint32_t)poly[d-1].m[b]<<(BITS-1-b);
+			else{
+				uint32_t old=v[(b-s)*QMC_MAXDIM+d];
+				w=old^(old>>s);
+				for(int k=1;k<s;k++){
+					if((a>>(s-1-k))&1) w^=v[(b-k)*QMC_MAXDIM+d];
+				}
+			}
+			v[b*QMC_MAXDIM+d]=w;
+		}
+	}
+}
+
+//Random lower triangular bit matrix with unit diagonal applied to every direction number of each
+//dimension (Matousek's linear scramble), and a random digital shift; both drawn from r
+//The scramble is linear over XOR, so Gray code stepping still works on the scrambled numbers
+static void scramble(const uint32_t *v,uint32_t *sv,uint32_t *shift,int dim,rng *r){
+	for(int d=0;d<dim;d++){
+		uint32_t col[BITS];
+		for(int j=0;j<BITS;j++){
+			uint32_t diag=1u<<(BITS-1-j);
+			col[j]=diag|(rng_u32(r)&(diag-1));
+		}
+		for(int b=0;b<BITS;b++){
+			uint32_t w=v[b*QMC_MAXDIM+d],out=0;
+			for(int j=0;j<BITS;j++){
+				if((w>>(BITS-1-j))&1) out^=col[j];
+			}
+			sv[b*QMC_MAXDIM+d]=out;
+		}
+		shift[d]=rng_u32(r);
+	}
+}
+
+//m points from index i on into pts, x holding the digits of point i and left at point i+m
+//Point i is the Gray code gray(i)=i^(i>>1), and gray(i+1) differs from it in bit ctz(i+1) only
+HOT void sobolfill(uint32_t *x,const uint32_t *sv,int dim,long i,int m,const double *lo,const double *w,double *pts){
+	for(int k=0;k<m;k++){
+		double *p=pts+(long)k*dim;
+		for(int d=0;d<dim;d++) p[d]=lo[d]+w[d]*(x[d]*(1.0/4294967296.0)+(0.5/4294967296.0));
+		const uint32_t *s=sv+__builtin_ctzl((unsigned long)(i+k+1))*QMC_MAXDIM;
+		for(int d=0;d<dim;d++) x[d]^=s[d];
+	}
+}
+ISA_CLONES_VOID(sobolfill,(uint32_t *x,const uint32_t *sv,int dim,long i,int m,const double *lo,const double *w,double *pts),(x,sv,dim,i,m,lo,w,pts))
+
+//Pseudo-random points i..i+m-1, point i taken from Philox block i*ceil(dim/2) of stream rep
+static void randfill(rng *r,int dim,long i,int m,const double *lo,const double *w,double *pts){
+	for(int k=0;k<m;k++){
+		double *p=pts+(long)k*dim;
+		rng_seek(r,(uint64_t)(i+k)*((dim+1)/2));
+		for(int d=0;d<dim;d++) p[d]=lo[d]+w[d]*rng_double(r);
+	}
+}
+
+//Neumaier compensated sum
+typedef struct ksum{
+	double s,c;
+}ksum;
+static void kadd(ksum *k,double v){
+	double t=k->s+v;
+	if(fabs(k->s)>=fabs(v)) k->c+=(k->s-t)+v;
+	else k->c+=(v-t)+k->s;
+	k->s=t;
+}
+
+//Point range i0..i1-1 of every replicate given to one thread
+typedef struct job{
+	qmcintegrand f;
+	void *ctx;
+	int dim,reps,sobol;
+	const double *lo,*w;
+	const uint32_t *v;
+	long i0,i1;
+	uint64_t seed;
+	double sum[QMC_MAXREPS];
+}job;
+
+static void *run(void *arg){
+	job *j=(job*)arg;
+	int dim=j->dim;
+	double pts[QMC_CHUNK*QMC_MAXDIM],y[QMC_CHUNK];
+	uint32_t sv[BITS*QMC_MAXDIM],shift[QMC_MAXDIM],x[QMC_MAXDIM];
+	for(int rep=0;rep<j->reps;rep++){
+		//Philox stream rep draws the scramble, or the points for plain Monte Carlo
+		rng r;
+		rng_init(&r,j->seed,(uint64_t)rep);
+		if(j->sobol){
+			scramble(j->v,sv,shift,dim,&r);
+			//Digits of point i0 straight from its Gray code
+			unsigned long g=(unsigned long)j->i0^((unsigned long)j->i0>>1);
+			for(int d=0;d<dim;d++) x[d]=shift[d];
+			for(int b=0;g;b++,g>>=1){
+				if(g&1){
+					for(int d=0;d<dim;d++) x[d]^=sv[b*QMC_MAXDIM+d];
+				}
+			}
+		}
+		ksum acc={0,0};
+		for(long i=j->i0;i<j->i1;i+=QMC_CHUNK){
+			int m=j->i1-i<QMC_CHUNK?(int)(j->i1-i):QMC_CHUNK;
+			if(j->sobol) ISA_CALL(sobolfill)(x,sv,dim,i,m,j->lo,j->w,pts);
+			else randfill(&r,dim,i,m,j->lo,j->w,pts);
+			j->f(pts,y,m,dim,j->ctx);
+			double s=0;
+			for(int k=0;k<m;k++) s+=y[k];
+			kadd(&acc,s);
+		}
+		j->sum[rep]=acc.s+acc.c;
+	}
+	return NULL;
+}
+
+static double integrate(int sobol,qmcintegrand f,void *ctx,int dim,const double *lo,const double *hi,long n,int reps,uint64_t seed,int nthreads,qmcstats *st){
+	double t0=kstats_now();
+	if(dim<1||dim>QMC_MAXDIM||reps<1||reps>QMC_MAXREPS||n<1) return NAN;
+	//Sobol indices past 2^32 would need more direction bits
+	if(sobol&&n>4294967295L) return NAN;
+	double w[QMC_MAXDIM],vol=1;
+	for(int d=0;d<dim;d++){
+		w[d]=hi[d]-lo[d];
+		vol*=w[d];
+	}
+	uint32_t v[BITS*QMC_MAXDIM];
+	if(sobol) directions(v,dim);
+	if(nthreads<=0) nthreads=mc_ncpu();
+	if(nthreads>MC_MAXTHREADS) nthreads=MC_MAXTHREADS;
+	//At least a chunk per thread
+	long chunks=(n+QMC_CHUNK-1)/QMC_CHUNK;
+	if(nthreads>chunks) nthreads=(int)chunks;
+	job jobs[MC_MAXTHREADS];
+	for(int t=0;t<nthreads;t++){
+		//Ranges on chunk boundaries so the calls to f see full chunks
+		long c0=chunks*t/nthreads,c1=chunks*(t+1)/nthreads;
+		job *j=&jobs[t];
+		j->f=f;
+		j->ctx=ctx;
+		j->dim=dim;
+		j->reps=reps;
+		j->sobol=sobol;
+		j->lo=lo;
+		j->w=w;
+		j->v=v;
+		j->i0=c0*QMC_CHUNK;
+		j->i1=c1*QMC_CHUNK<n?c1*QMC_CHUNK:n;
+		j->seed=seed;
+	}
+	parallel_for(nthreads,run,jobs,sizeof(job));
+	//Replicate means in the order of the point ranges, then their mean and spread
+	double mean[QMC_MAXREPS],I=0,var=0;
+	for(int rep=0;rep<reps;rep++){
+		ksum acc={0,0};
+		for(int t=0;t<nthreads;t++) kadd(&acc,jobs[t].sum[rep]);
+		mean[rep]=vol*(acc.s+acc.c)/n;
+		I+=mean[rep];
+	}
+	I/=reps;
+	for(int rep=0;rep<reps;rep++) var+=(mean[rep]-I)*(mean[rep]-I);
+	if(st){
+		st->nfev=n*reps;
+		st->err=reps>1?sqrt(var/(reps-1)/reps):NAN;
+		st->seconds=kstats_now()-t0;
+	}
+	return I;
+}
+
+double qmc_integrate(qmcintegrand f,void *ctx,int dim,const double *lo,const double *hi,long n,int reps,uint64_t seed,int nthreads,qmcstats *st){
+	return integrate(1,f,ctx,dim,lo,hi,n,reps,seed,nthreads,st);
+}
+
+double mc_integrate(qmcintegrand f,void *ctx,int dim,const double *lo,const double *hi,long n,int reps,uint64_t seed,int nthreads,qmcstats *st){
+	return integrate(0,f,ctx,dim,lo,hi,n,reps,seed,nthreads,st);
+}
@@ -0,0 +1,30 @@
+#ifndef QMC_H
+#define QMC_H
+#include <stdint.h>
+//Multithreaded quasi-Monte Carlo integration over a box in up to QMC_MAXDIM dimensions
+//The points are a Sobol sequence (Joe-Kuo direction numbers) under a random linear scramble and
+//digital shift; reps independent scrambles give unbiased estimates whose spread is the error estimate
+
+//Dimensions with direction numbers, replicates per call, points per call to f
+#define QMC_MAXDIM 21
+#define QMC_MAXREPS 64
+#define QMC_CHUNK 256
+
+//y[i]=f(x[i*dim..i*dim+dim-1]) for i<n
+typedef void (*qmcintegrand)(const double *x,double *y,int n,int dim,void *ctx);
+
+typedef struct qmcstats{
+	long nfev;		//integrand evaluations, n*reps
+	double err;		//standard error of the mean over the replicates, NAN for reps<2
+	double seconds;		//wall time of the call
+}qmcstats;
+
+//Integral of f over the box [lo[d],hi[d]], the mean over reps replicates of n points each
+//Point i of a replicate depends only on (seed, replicate, i), so the result depends on nthreads
+//only through the rounding of the sums; nthreads<=0 uses every online CPU
+//Returns NAN if dim or reps is out of range; st may be NULL
+double qmc_integrate(qmcintegrand f,void *ctx,int dim,const double *lo,const double *hi,long n,int reps,uint64_t seed,int nthreads,qmcstats *st);
+
+//The same with Philox pseudo-random points (plain Monte Carlo), for comparison
+double mc_integrate(qmcintegrand f,void *ctx,int dim,const double *lo,const double *hi,long n,int reps,uint64_t seed,int nthreads,qmcstats *st);
+#endif
@@ -0,0 +1,236 @@
+#include <math.h>
+#include <stddef.h>
+#include "quad.h"
+#include "cpu.h"
+
+//Kronrod abscissae on [-1,1] (positive half), odd entries are the 7 point Gauss nodes
+static const double xgk[8]={
+	0.991455371120812639206854697526329,0.949107912342758524526189684047851,
+	0.864864423359769072789712788640926,0.741531185599394439863864773280788,
+	0.586087235467691130294144845693013,0.405845151377397166906606412076961,
+	0.207784955007898467600689403773245,0.0};
+static const double wgk[8]={
+	0.022935322010529224963732008058970,0.063092092629978553290700663189204,
+	0.104790010322250183839876322541518,0.140653259715525918745189590510238,
+	0.169004726639267902826583426598550,0.190350578064785409913256402421014,
+	0.204432940075298892414161999234649,0.209482141084727828012999174891714};
+static const double wg[4]={
+	0.129484966168869693270611432679082,0.279705391489276667901467771423780,
+	0.381830050505118944950369775488975,0.417959183673469387755102040816327};
+
+//Neumaier compensated sum
+typedef struct ksum{
+	double s,c;
+}ksum;
+static void kadd(ksum *k,double v){
+	double t=k->s+v;
+	if(fabs(k->s)>=fabs(v)) k->c+=(k->s-t)+v;
+	else k->c+=(v-t)+k->s;
+	k->s=t;
+}
+
+//Subinterval with its integral and error estimate
+typedef struct seg{
+	double a,b,I,E;
+}seg;
+
+//Max-heap on E
+static void heappush(seg *h,int *n,seg s){
+	int i=(*n)++;
+	while(i>0&&h[(i-1)/2].E<s.E){
+		h[i]=h[(i-1)/2];
+		i=(i-1)/2;
+	}
+	h[i]=s;
+}
+static seg heappop(seg *h,int *n){
+	seg top=h[0],last=h[--(*n)];
+	int i=0;
+	for(;;){
+		int c=2*i+1;
+		if(c>=*n) break;
+		if(c+1<*n&&h[c+1].E>h[c].E) c++;
+		if(h[c].E<=last.E) break;
+		h[i]=h[c];
+		i=c;
+	}
+	h[i]=last;
+	return top;
+}
+
+//The 15 Kronrod nodes of [a,b] in the order matching fromnodes()
+static void nodes(double a,double b,double *x){
+	double c=(a+b)/2,r=(b-a)/2;
+	for(int j=0;j<7;j++){
+		x[2*j]=c-r*xgk[j];
+		x[2*j+1]=c+r*xgk[j];
+	}
+	x[14]=c;
+}
+static seg fromnodes(double a,double b,const double *y){
+	double r=(b-a)/2,K=wgk[7]*y[14],G=wg[3]*y[14];
+	for(int j=0;j<7;j++){
+		double s=y[2*j]+y[2*j+1];
+		K+=wgk[j]*s;
+		if(j&1) G+=wg[j/2]*s;
+	}
+	seg sg={a,b,K*r,fabs((K-G)*r)};
+	return sg;
+}
+
+//Core shared by the scalar and batch entry points, width intervals are bisected per round
+static double gk(batchintegrand f,void *ctx,double a,double b,double tol,int width,quadstats *st){
+	seg h[QUAD_MAXINT];
+	double x[QUAD_WIDTH*30],y[QUAD_WIDTH*30];
+	seg split[QUAD_WIDTH];
+	int n=0,nfev=15;
+	nodes(a,b,x);
+	f(x,y,15,ctx);
+	heappush(h,&n,fromnodes(a,b,y));
+	double E=h[0].E;
+	while(E>tol&&n+width<=QUAD_MAXINT){
+		int m=0;
+		while(m<width&&n>0&&(m==0||h[0].E>tol/QUAD_MAXINT)){
+			split[m]=heappop(h,&n);
+			double mid=(split[m].a+split[m].b)/2;
+			nodes(split[m].a,mid,x+30*m);
+			nodes(mid,split[m].b,x+30*m+15);
+			E-=split[m].E;
+			m++;
+		}
+		f(x,y,30*m,ctx);
+		nfev+=30*m;
+		for(int i=0;i<m;i++){
+			double mid=(split[i].a+split[i].b)/2;
+			seg l=fromnodes(split[i].a,mid,y+30*i),r=fromnodes(mid,split[i].b,y+30*i+15);
+			heappush(h,&n,l);
+			heappush(h,&n,r);
+			E+=l.E+r.E;
+		}
+	}
+	//Final totals are re-summed with compensation rather than trusting the running E
+	ksum I={0,0},Es={0,0};
+	for(int i=0;i<n;i++){
+		kadd(&I,h[i].I);
+		kadd(&Es,h[i].E);
+	}
+	if(st){
+		st->nfev=nfev;
+		st->intervals=n;
+		st->err=Es.s+Es.c;
+	}
+	return I.s+I.c;
+}
+
+//Adapts a scalar integrand to the batch interface
+typedef struct scalar{
+	integrand f;
+	void *ctx;
+}scalar;
+static void scalarbatch(const double *x,double *y,int n,void *ctx){
+	scalar *s=(scalar*)ctx;
+	for(int i=0;i<n;i++){
+		y[i]=s->f(x[i],s->ctx);
+	}
+}
+
+double quad_gk(integrand f,void *ctx,double a,double b,double tol,quadstats *st){
+	scalar s={f,ctx};
+	return gk(scalarbatch,&s,a,b,tol,1,st);
+}
+
+double quad_gk_batch(batchintegrand f,void *ctx,double a,double b,double tol,quadstats *st){
+	return gk(f,ctx,a,b,tol,QUAD_WIDTH,st);
+}
+
+#define PREC 'f'
+#include "scalar.h"
+#include "quad_impl.h"
+#undef PREC
+#define PREC 'd'
+#include "scalar.h"
+#include "quad_impl.h"
+#undef PREC
+#define PREC 'l'
+#include "scalar.h"
+#include "quad_impl.h"
+#undef PREC
+
+//Nodes a+(i0+i)*h for i<m, computed from the index so there is no drift
+HOT void trapnodes(double *x,double a,double h,long i0,int m){
+	for(int i=0;i<m;i++){
+		x[i]=a+(i0+i)*h;
+	}
+}
+ISA_CLONES_VOID(trapnodes,(double *x,double a,double h,long i0,int m),(x,a,h,i0,m))
+
+//Sum of y[0..m-1] in 8 interleaved partial sums, the same order at every level
+HOT double trapsum(const double *y,int m){
+	double p[8]={0,0,0,0,0,0,0,0},s=0;
+	int i=0;
+	for(;i+8<=m;i+=8){
+		for(int l=0;l<8;l++) p[l]+=y[i+l];
+	}
+	for(;i<m;i++) s+=y[i];
+	for(int l=0;l<8;l++) s+=p[l];
+	return s;
+}
+ISA_CLONES(double,trapsum,(const double *y,int m),(y,m))
+
+double quad_trapezoid_batch(batchintegrand f,void *ctx,double a,double b,long n){
+	double h=(b-a)/n,x[QUAD_TRAPCHUNK],y[QUAD_TRAPCHUNK];
+	double ends=0,inner=0;
+	for(long i0=0;i0<=n;i0+=QUAD_TRAPCHUNK){
+		int m=n+1-i0<QUAD_TRAPCHUNK?(int)(n+1-i0):QUAD_TRAPCHUNK;
+		ISA_CALL(trapnodes)(x,a,h,i0,m);
+		f(x,y,m,ctx);
+		//End points carry half weight
+		if(i0==0){
+			ends+=y[0];
+			y[0]=0;
+		}
+		if(i0+m==n+1){
+			ends+=y[m-1];
+			y[m-1]=0;
+		}
+		inner+=ISA_CALL(trapsum)(y,m);
+	}
+	return h*(inner+ends/2);
+}
+
+#define ROMBERG_LEVELS 24
+
+double quad_romberg(integrand f,void *ctx,double a,double b,double tol,quadstats *st){
+	double prev[ROMBERG_LEVELS],cur[ROMBERG_LEVELS];
+	double h=b-a,best;
+	int nfev=2,k;
+	prev[0]=h*(f(a,ctx)+f(b,ctx))/2;
+	best=prev[0];
+	double err=INFINITY;
+	for(k=1;k<ROMBERG_LEVELS;k++){
+		//Trapezoid with half the step reuses every previous point, only the midpoints are new
+		ksum mid={0,0};
+		int m=1<<(k-1);
+		for(int i=0;i<m;i++){
+			kadd(&mid,f(a+(2*i+1)*h/2,ctx));
+		}
+		nfev+=m;
+		cur[0]=prev[0]/2+h/2*(mid.s+mid.c);
+		double p=1;
+		for(int j=1;j<=k;j++){
+			p*=4;
+			cur[j]=cur[j-1]+(cur[j-1]-prev[j-1])/(p-1);
+		}
+		err=fabs(cur[k]-prev[k-1]);
+		best=cur[k];
+		for(int j=0;j<=k;j++) prev[j]=cur[j];
+		h/=2;
+		if(k>=4&&err<tol) break;
+	}
+	if(st){
+		st->nfev=nfev;
+		st->intervals=k<ROMBERG_LEVELS?k+1:ROMBERG_LEVELS;
+		st->err=err;
+	}
+	return best;
+}
@@ -0,0 +1,41 @@
+#ifndef QUAD_H
+#define QUAD_H
+//Adaptive numerical integration of f over [a,b]
+
+typedef double (*integrand)(double x,void *ctx);
+//Batch form: y[i]=f(x[i]) for i<n, lets expensive integrands use SIMD or threads
+typedef void (*batchintegrand)(const double *x,double *y,int n,void *ctx);
+
+//Largest number of subintervals kept by the Gauss-Kronrod engine
+#define QUAD_MAXINT 1024
+//Worst subintervals bisected per round on the batch path (30 nodes each)
+#define QUAD_WIDTH 8
+
+typedef struct quadstats{
+	int nfev;		//integrand evaluations
+	int intervals;		//subintervals (GK) or halving levels (Romberg)
+	double err;		//estimated absolute error
+}quadstats;
+
+//Adaptive Gauss-Kronrod 7/15, always bisecting the subinterval with the largest error estimate
+//Stops when the summed error estimate is below tol or QUAD_MAXINT subintervals are in use
+double quad_gk(integrand f,void *ctx,double a,double b,double tol,quadstats *st);
+double quad_gk_batch(batchintegrand f,void *ctx,double a,double b,double tol,quadstats *st);
+
+//Composite trapezoid rule with n equal steps, each point evaluated once
+double quad_trapezoid(integrand f,void *ctx,double a,double b,int n);
+//The same in float (_f) and long double (_l)
+typedef float (*integrand_f)(float x,void *ctx);
+typedef long double (*integrand_l)(long double x,void *ctx);
+float quad_trapezoid_f(integrand_f f,void *ctx,float a,float b,int n);
+long double quad_trapezoid_l(integrand_l f,void *ctx,long double a,long double b,int n);
+
+//Points per call to f in the batch trapezoid rule
+#define QUAD_TRAPCHUNK 1024
+
+//The same rule on a batch integrand, n+1 points in chunks of QUAD_TRAPCHUNK, for n up to long
+double quad_trapezoid_batch(batchintegrand f,void *ctx,double a,double b,long n);
+
+//Romberg integration: trapezoid halving with Richardson extrapolation, for smooth integrands
+double quad_romberg(integrand f,void *ctx,double a,double b,double tol,quadstats *st);
+#endif
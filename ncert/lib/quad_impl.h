@@ -0,0 +1,12 @@
+//Generic composite trapezoid rule, instantiated by quad.c for each precision (see scalar.h)
+
+T FN(quad_trapezoid)(FN(integrand) f,void *ctx,T a,T b,int n){
+	T h=(b-a)/n,A=0;
+	T yl=f(a,ctx),yr;	//value at the left end is carried over
+	for(int i=0;i<n;i++){
+		yr=f(a+(i+1)*h,ctx);	//x computed from i, no drift from repeated x+=h
+		A+=((yr+yl)/2)*h;
+		yl=yr;
+	}
+	return A;
+}
@@ -0,0 +1,157 @@
+#include <math.h>
+#include <stddef.h>
+#include "rk45.h"
+
+//Dormand-Prince tableau
+#define C2 (1.0/5)
+#define C3 (3.0/10)
+#define C4 (4.0/5)
+#define C5 (8.0/9)
+#define A21 (1.0/5)
+#define A31 (3.0/40)
+#define A32 (9.0/40)
+#define A41 (44.0/45)
+#define A42 (-56.0/15)
+#define A43 (32.0/9)
+#define A51 (19372.0/6561)
+#define A52 (-25360.0/2187)
+#define A53 (64448.0/6561)
+#define A54 (-212.0/729)
+#define A61 (9017.0/3168)
+#define A62 (-355.0/33)
+#define A63 (46732.0/5247)
+#define A64 (49.0/176)
+#define A65 (-5103.0/18656)
+#define A71 (35.0/384)
+#define A73 (500.0/1113)
+#define A74 (125.0/192)
+#define A75 (-2187.0/6784)
+#define A76 (11.0/84)
+//Difference between the 5th and embedded 4th order weights
+#define E1 (71.0/57600)
+#define E3 (-71.0/16695)
+#define E4 (71.0/1920)
+#define E5 (-17253.0/339200)
+#define E6 (22.0/525)
+#define E7 (-1.0/40)
+//Dense output weights (Hairer, Norsett, Wanner)
+#define D1 (-12715105075.0/11282082432)
+#define D3 (87487479700.0/32700410799)
+#define D4 (-10690763975.0/1880347072)
+#define D5 (701980252875.0/199316789632)
+#define D6 (-1453857185.0/822651844)
+#define D7 (69997945.0/29380423)
+
+rk45opts rk45_defaults(void){
+	rk45opts o={1e-8,1e-10,0,0,100000};
+	return o;
+}
+
+//Sink used by rk45() to fill the caller's buffer
+typedef struct gridbuf{
+	double *y;
+	int i;
+}gridbuf;
+
+static void tobuf(double x,double y,void *ctx){
+	gridbuf *b=(gridbuf*)ctx;
+	(void)x;
+	b->y[b->i++]=y;
+}
+
+//Starting step from the size of y and y' (Hairer's simple estimate)
+static double firststep(double y0,double f0,double atol,double rtol){
+	double sc=atol+rtol*fabs(y0);
+	double d0=fabs(y0)/sc,d1=fabs(f0)/sc;
+	if(d0<1e-5||d1<1e-5){
+		return 1e-6;
+	}
+	return 0.01*d0/d1;
+}
+
+int rk45_stream(odefunc f,void *ctx,double x0,double y0,const double *xout,int n,odesink sink,void *sctx,const rk45opts *opt,rk45stats *st){
+	rk45opts o=rk45_defaults();
+	rk45stats s={0,0,0};
+	int k=0,ret=0;
+	if(opt){
+		if(opt->rtol>0) o.rtol=opt->rtol;
+		if(opt->atol>0) o.atol=opt->atol;
+		if(opt->h0>0) o.h0=opt->h0;
+		if(opt->hmax>0) o.hmax=opt->hmax;
+		if(opt->maxsteps>0) o.maxsteps=opt->maxsteps;
+	}
+	//Only forward integration over a non-decreasing grid
+	for(int i=0;i<n;i++){
+		if(xout[i]<(i?xout[i-1]:x0)){
+			if(st) *st=s;
+			return -1;
+		}
+	}
+	//Grid points at the starting point need no integration
+	while(k<n&&xout[k]<=x0){
+		sink(xout[k],y0,sctx);
+		k++;
+	}
+	if(k==n){
+		if(st) *st=s;
+		return 0;
+	}
+	double xend=xout[n-1],x=x0,y=y0;
+	double k1=f(x,y,ctx);	//FSAL: the last stage of a step is the first of the next
+	s.nfev++;
+	double h=o.h0>0?o.h0:firststep(y0,k1,o.atol,o.rtol);
+	while(k<n){
+		if(s.accepted+s.rejected>=o.maxsteps){
+			ret=-1;
+			break;
+		}
+		if(o.hmax>0&&h>o.hmax) h=o.hmax;
+		if(x+h>xend) h=xend-x;
+		if(h<=fabs(x)*1e-15){
+			ret=-1;
+			break;
+		}
+		double k2=f(x+C2*h,y+h*A21*k1,ctx);
+		double k3=f(x+C3*h,y+h*(A31*k1+A32*k2),ctx);
+		double k4=f(x+C4*h,y+h*(A41*k1+A42*k2+A43*k3),ctx);
+		double k5=f(x+C5*h,y+h*(A51*k1+A52*k2+A53*k3+A54*k4),ctx);
+		double k6=f(x+h,y+h*(A61*k1+A62*k2+A63*k3+A64*k4+A65*k5),ctx);
+		double y1=y+h*(A71*k1+A73*k3+A74*k4+A75*k5+A76*k6);
+		double k7=f(x+h,y1,ctx);
+		s.nfev+=6;
+		double e=h*(E1*k1+E3*k3+E4*k4+E5*k5+E6*k6+E7*k7);
+		double err=fabs(e)/(o.atol+o.rtol*fmax(fabs(y),fabs(y1)));
+		double fac=err>0?0.9*pow(err,-0.2):10;
+		if(fac<0.2) fac=0.2;
+		if(fac>10) fac=10;
+		if(err>1){
+			s.rejected++;
+			h*=fac;
+			continue;
+		}
+		s.accepted++;
+		//Emit every grid point inside this step using the continuous extension
+		double x1=(h==xend-x)?xend:x+h;
+		if(k<n&&xout[k]<=x1){
+			double ydiff=y1-y,bspl=h*k1-ydiff;
+			double r4=ydiff-h*k7-bspl;
+			double r5=h*(D1*k1+D3*k3+D4*k4+D5*k5+D6*k6+D7*k7);
+			while(k<n&&xout[k]<=x1){
+				double t=(xout[k]-x)/h,t1=1-t;
+				sink(xout[k],y+t*(ydiff+t1*(bspl+t*(r4+t1*r5))),sctx);
+				k++;
+			}
+		}
+		x=x1;
+		y=y1;
+		k1=k7;
+		h*=fac;
+	}
+	if(st) *st=s;
+	return ret;
+}
+
+int rk45(odefunc f,void *ctx,double x0,double y0,const double *xout,double *yout,int n,const rk45opts *opt,rk45stats *st){
+	gridbuf b={yout,0};
+	return rk45_stream(f,ctx,x0,y0,xout,n,tobuf,&b,opt,st);
+}
@@ -0,0 +1,32 @@
+#ifndef RK45_H
+#define RK45_H
+//Adaptive Dormand-Prince RK5(4) integrator for y'=f(x,y) with dense output
+
+//Right hand side of the ODE, ctx is passed through untouched
+typedef double (*odefunc)(double x,double y,void *ctx);
+//Receives every output point (x,y) when streaming instead of writing to a buffer
+typedef void (*odesink)(double x,double y,void *ctx);
+
+//Tolerances and step limits, zero fields take the defaults from rk45_defaults()
+typedef struct rk45opts{
+	double rtol,atol;	//relative and absolute error tolerance
+	double h0;		//initial step, 0 picks one automatically
+	double hmax;		//largest allowed step, 0 means unlimited
+	int maxsteps;		//accepted+rejected step budget
+}rk45opts;
+
+//What the integrator did
+typedef struct rk45stats{
+	int accepted,rejected,nfev;
+}rk45stats;
+
+rk45opts rk45_defaults(void);
+
+//Integrates from (x0,y0) and writes y at the n increasing grid points xout[] into yout[]
+//Returns 0 on success, -1 if the step budget ran out or the step size underflowed, or straight
+//away (nothing written) if xout[0]<x0 or xout decreases anywhere
+int rk45(odefunc f,void *ctx,double x0,double y0,const double *xout,double *yout,int n,const rk45opts *opt,rk45stats *st);
+
+//Same as rk45() but hands each grid point to sink(x,y,sctx) so nothing has to be stored
+int rk45_stream(odefunc f,void *ctx,double x0,double y0,const double *xout,int n,odesink sink,void *sctx,const rk45opts *opt,rk45stats *st);
+#endif
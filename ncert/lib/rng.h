@@ -0,0 +1,66 @@
+#ifndef RNG_H
+#define RNG_H
+#include <stdint.h>
+//Philox4x32-10 counter-based random number generator (Salmon et al., Random123)
+//The output is a pure function of (counter, key), so any stream can jump to any position
+//and threads need no shared state to produce reproducible numbers
+
+//One block of four 32-bit outputs for the given counter and key
+static inline void philox4x32(const uint32_t ctr[4],const uint32_t key[2],uint32_t out[4]){
+	uint32_t c0=ctr[0],c1=ctr[1],c2=ctr[2],c3=ctr[3],k0=key[0],k1=key[1];
+	for(int r=0;r<10;r++){
+		uint64_t p0=(uint64_t)0xD2511F53u*c0,p1=(uint64_t)0xCD9E8D57u*c2;
+		uint32_t n0=(uint32_t)(p1>>32)^c1^k0,n2=(uint32_t)(p0>>32)^c3^k1;
+		c0=n0;
+		c1=(uint32_t)p1;
+		c2=n2;
+		c3=(uint32_t)p0;
+		k0+=0x9E3779B9u;
+		k1+=0xBB67AE85u;
+	}
+	out[0]=c0;
+	out[1]=c1;
+	out[2]=c2;
+	out[3]=c3;
+}
+
+//Sequential stream: key from the seed, stream id in the upper counter words
+typedef struct rng{
+	uint32_t key[2];
+	uint32_t ctr[4];
+	uint32_t buf[4];
+	int left;
+}rng;
+
+static inline void rng_init(rng *r,uint64_t seed,uint64_t stream){
+	r->key[0]=(uint32_t)seed;
+	r->key[1]=(uint32_t)(seed>>32);
+	r->ctr[0]=0;
+	r->ctr[1]=0;
+	r->ctr[2]=(uint32_t)stream;
+	r->ctr[3]=(uint32_t)(stream>>32);
+	r->left=0;
+}
+
+//Moves the stream to block index pos (4 outputs per block)
+static inline void rng_seek(rng *r,uint64_t pos){
+	r->ctr[0]=(uint32_t)pos;
+	r->ctr[1]=(uint32_t)(pos>>32);
+	r->left=0;
+}
+
+static inline uint32_t rng_u32(rng *r){
+	if(r->left==0){
+		philox4x32(r->ctr,r->key,r->buf);
+		if(++r->ctr[0]==0) r->ctr[1]++;
+		r->left=4;
+	}
+	return r->buf[--r->left];
+}
+
+//Uniform double in [0,1) with 53 random bits
+static inline double rng_double(rng *r){
+	uint64_t hi=rng_u32(r)>>5,lo=rng_u32(r)>>6;
+	return (hi*67108864.0+lo)*(1.0/9007199254740992.0);
+}
+#endif
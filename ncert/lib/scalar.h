@@ -0,0 +1,42 @@
+//Per-precision type, name suffix and math for the generic kernel bodies (*_impl.h)
+//Define PREC before each inclusion: 'f' float, 'd' double, 'l' long double, 'c' double complex
+//Double keeps the unsuffixed names, the others get _f, _l and _c
+//No include guard: this is included once per instantiation
+#undef T
+#undef R
+#undef FN
+#undef ABS
+#undef SQRT
+#undef EXP
+#if PREC=='f'
+#define T float
+#define R float
+#define FN(name) name##_f
+#define ABS fabsf
+#define SQRT sqrtf
+#define EXP expf
+#elif PREC=='d'
+#define T double
+#define R double
+#define FN(name) name
+#define ABS fabs
+#define SQRT sqrt
+#define EXP exp
+#elif PREC=='l'
+#define T long double
+#define R long double
+#define FN(name) name##_l
+#define ABS fabsl
+#define SQRT sqrtl
+#define EXP expl
+#elif PREC=='c'
+#include <complex.h>
+#define T double complex
+#define R double
+#define FN(name) name##_c
+#define ABS cabs
+#define SQRT csqrt
+#define EXP cexp
+#else
+#error "PREC must be 'f', 'd', 'l' or 'c'"
+#endif
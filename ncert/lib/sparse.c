@@ -0,0 +1,139 @@
+#include "sparse.h"
+#include "cpu.h"
+#include "mc.h"
+
+//Rows lo..hi-1 of y=Ax
+HOT void spmv(const long *ptr,const int *col,const double *val,const double *x,double *y,long lo,long hi){
+	for(long i=lo;i<hi;i++){
+		double s=0;
+		for(long k=ptr[i];k<ptr[i+1];k++){
+			s+=val[k]*x[col[k]];
+		}
+		y[i]=s;
+	}
+}
+ISA_CLONES_VOID(spmv,(const long *ptr,const int *col,const double *val,const double *x,double *y,long lo,long hi),(ptr,col,val,x,y,lo,hi))
+
+typedef struct job{
+	const csr *A;
+	const double *x;
+	double *y;
+	long lo,hi;
+}job;
+
+static void *run(void *arg){
+	job *j=(job*)arg;
+	ISA_CALL(spmv)(j->A->ptr,j->A->col,j->A->val,j->x,j->y,j->lo,j->hi);
+	return NULL;
+}
+
+//First row whose entries start at or after the target nonzero count
+static long rowat(const long *ptr,long n,long nnz){
+	long lo=0,hi=n;
+	while(lo<hi){
+		long m=(lo+hi)/2;
+		if(ptr[m]<nnz) lo=m+1;
+		else hi=m;
+	}
+	return lo;
+}
+
+void csr_spmv(const csr *A,const double *x,double *y){
+	int nthreads=A->nthreads;
+	if(nthreads>MC_MAXTHREADS) nthreads=MC_MAXTHREADS;
+	if(nthreads>A->n/CSR_CHUNK) nthreads=(int)(A->n/CSR_CHUNK);
+	if(nthreads<=1){
+		ISA_CALL(spmv)(A->ptr,A->col,A->val,x,y,0,A->n);
+		return;
+	}
+	job jobs[MC_MAXTHREADS];
+	long nnz=A->ptr[A->n];
+	for(int t=0;t<nthreads;t++){
+		job j={A,x,y,rowat(A->ptr,A->n,nnz*t/nthreads),t==nthreads-1?A->n:rowat(A->ptr,A->n,nnz*(t+1)/nthreads)};
+		jobs[t]=j;
+	}
+	parallel_for(nthreads,run,jobs,sizeof(job));
+}
+
+void csr_matvec(const double *x,double *y,long n,void *ctx){
+	(void)n;
+	csr_spmv((const csr*)ctx,x,y);
+}
+
+int csr_jacobi(const csr *A,double *dinv){
+	for(long i=0;i<A->n;i++){
+		dinv[i]=0;
+		for(long k=A->ptr[i];k<A->ptr[i+1];k++){
+			if(A->col[k]==i) dinv[i]=A->val[k];
+		}
+		if(dinv[i]==0) return -1;
+		dinv[i]=1/dinv[i];
+	}
+	return 0;
+}
+
+void jacobi_apply(const double *r,double *z,long n,void *ctx){
+	const double *dinv=(const double*)ctx;
+	for(long i=0;i<n;i++){
+		z[i]=r[i]*dinv[i];
+	}
+}
+
+int csr_ilu0(const csr *A,double *val,long *diag,ilu0 *M){
+	const long *ptr=A->ptr;
+	const int *col=A->col;
+	long n=A->n;
+	for(long k=0;k<ptr[n];k++){
+		val[k]=A->val[k];
+	}
+	for(long i=0;i<n;i++){
+		diag[i]=-1;
+		for(long k=ptr[i];k<ptr[i+1];k++){
+			if(col[k]==i) diag[i]=k;
+		}
+		if(diag[i]<0) return -1;
+	}
+	//IKJ Gaussian elimination restricted to the pattern, both rows sorted by column
+	for(long i=0;i<n;i++){
+		for(long k=ptr[i];k<diag[i];k++){
+			long r=col[k];
+			if(val[diag[r]]==0) return -1;
+			double l=val[k]/val[diag[r]];
+			val[k]=l;
+			long p=diag[r]+1,q=k+1;
+			while(p<ptr[r+1]&&q<ptr[i+1]){
+				if(col[p]<col[q]) p++;
+				else if(col[p]>col[q]) q++;
+				else val[q++]-=l*val[p++];
+			}
+		}
+		if(val[diag[i]]==0) return -1;
+	}
+	csr lu={n,ptr,col,val,A->nthreads};
+	M->lu=lu;
+	M->diag=diag;
+	return 0;
+}
+
+void ilu0_apply(const double *r,double *z,long n,void *ctx){
+	const ilu0 *M=(const ilu0*)ctx;
+	const long *ptr=M->lu.ptr,*diag=M->diag;
+	const int *col=M->lu.col;
+	const double *val=M->lu.val;
+	//Ly=r with the unit diagonal of L, y kept in z
+	for(long i=0;i<n;i++){
+		double s=r[i];
+		for(long k=ptr[i];k<diag[i];k++){
+			s-=val[k]*z[col[k]];
+		}
+		z[i]=s;
+	}
+	//Uz=y
+	for(long i=n-1;i>=0;i--){
+		double s=z[i];
+		for(long k=diag[i]+1;k<ptr[i+1];k++){
+			s-=val[k]*z[col[k]];
+		}
+		z[i]=s/val[diag[i]];
+	}
+}
@@ -0,0 +1,39 @@
+#ifndef SPARSE_H
+#define SPARSE_H
+//Compressed sparse row matrices and the preconditioners built from them
+//The three arrays are those of scipy.sparse.csr_matrix (indptr as int64, indices as int32),
+//so a SciPy or hand built NumPy matrix can be passed without copying
+
+typedef struct csr{
+	long n;			//rows (and columns)
+	const long *ptr;	//row i holds entries ptr[i]..ptr[i+1]-1
+	const int *col;		//column of each entry, sorted within a row for ILU(0)
+	const double *val;
+	int nthreads;		//threads for csr_spmv, <=1 runs on the calling thread
+}csr;
+
+//Rows per thread below which csr_spmv uses fewer threads
+#define CSR_CHUNK 16384
+
+//y=Ax, rows are split between threads by nonzero count
+void csr_spmv(const csr *A,const double *x,double *y);
+//csr_spmv as a matvec for the Krylov solvers in krylov.h, ctx is the csr
+void csr_matvec(const double *x,double *y,long n,void *ctx);
+
+//Jacobi: dinv[i]=1/A[i][i], returns -1 if a diagonal entry is zero or missing
+int csr_jacobi(const csr *A,double *dinv);
+//z=r/diag(A) as a matvec, ctx is dinv
+void jacobi_apply(const double *r,double *z,long n,void *ctx);
+
+//ILU(0): incomplete LU with the sparsity pattern of A, L unit lower and U sharing it
+typedef struct ilu0{
+	csr lu;			//the factors, ptr and col are those of A
+	long *diag;		//entry of the diagonal in each row
+}ilu0;
+
+//Factors A into M, val must hold ptr[n] doubles and diag n longs
+//Returns -1 if a diagonal entry is missing or a pivot is zero
+int csr_ilu0(const csr *A,double *val,long *diag,ilu0 *M);
+//z=(LU)^-1 r by forward and back substitution, ctx is the ilu0, r and z may alias
+void ilu0_apply(const double *r,double *z,long n,void *ctx);
+#endif
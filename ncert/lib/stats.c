@@ -0,0 +1,10 @@
+#include "stats.h"
+
+void kstats_trace_json(const char *kernel,int iter,double residual,void *ctx){
+	fprintf(ctx?(FILE*)ctx:stderr,"{\"kernel\": \"%s\", \"iter\": %d, \"residual\": %.6g}\n",kernel,iter,residual);
+}
+
+void kstats_print(FILE *out,const char *kernel,const kstats *st){
+	fprintf(out?out:stderr,"{\"kernel\": \"%s\", \"iterations\": %d, \"nfev\": %ld, \"residual\": %.6g, "
+		"\"seconds\": %.6g, \"deflations\": %d}\n",kernel,st->iterations,st->nfev,st->residual,st->seconds,st->deflations);
+}
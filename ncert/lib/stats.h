@@ -0,0 +1,51 @@
+#ifndef STATS_H
+#define STATS_H
+#include <stdio.h>
+#include <time.h>
+//Opt-in convergence stats for the iterative kernels (qr_eigen, newton_root, gd_walk, gd_scan, cg, gmres,
+//lanczos_eigs, arnoldi_eigs, lbfgs, lbfgs_sep, lu_solve_mixed)
+//Each takes a kstats pointer as its last argument: NULL costs one untaken branch per iteration
+//and no clock reads, a non-NULL one is filled in, and its trace hook if set sees every iteration
+
+typedef void (*ktrace)(const char *kernel,int iter,double residual,void *ctx);
+
+typedef struct kstats{
+	int iterations;		//QR steps, Newton updates, gradient steps, L-BFGS updates, refinement steps, Krylov iterations or restarts (eigs)
+	long nfev;		//function evaluations (value and derivative together for dual functions), products with A for Krylov and refinement
+	double residual;	//final |f| (Newton), |f'| (GD), |grad f|_inf (L-BFGS), largest deflated off-diagonal sum (QR), |b-Ax|/|b| (Krylov), |b-Ax|_inf/(|A|_inf|x|_inf) (refinement) or largest relative Ritz residual (eigs)
+	double seconds;		//wall time of the call
+	int deflations;		//rows split off by QR
+	ktrace trace;		//set by the caller, kept across calls
+	void *tracectx;
+}kstats;
+
+//Trace hook writing one JSON line per iteration to ctx (a FILE*, NULL for stderr)
+void kstats_trace_json(const char *kernel,int iter,double residual,void *ctx);
+//Summary of one call as a JSON line
+void kstats_print(FILE *out,const char *kernel,const kstats *st);
+
+static inline double kstats_now(void){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC,&t);
+	return t.tv_sec+t.tv_nsec*1e-9;
+}
+
+//Clears the counters (not the trace hook) and returns the start time, 0 without stats
+static inline double kstats_begin(kstats *st){
+	if(!st) return 0;
+	st->iterations=0;
+	st->nfev=0;
+	st->residual=0;
+	st->seconds=0;
+	st->deflations=0;
+	return kstats_now();
+}
+
+static inline void kstats_end(kstats *st,double t0){
+	if(st) st->seconds=kstats_now()-t0;
+}
+
+#define KTRACE(st,kernel,iter,res) do{ \
+	if((st)&&(st)->trace) (st)->trace(kernel,iter,res,(st)->tracectx); \
+}while(0)
+#endif